@@ -0,0 +1,81 @@
+//std
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/VulkanTest/Render/Culling/frustumCuller.h"
+#include "../src/VulkanTest/Camera&Movement/vulkanCamera.h"
+
+/*
+* Times FrustumCuller::Cull against the one box at a time CullScalar on random boxes.
+* Usage: frustumCullerBenchmark [box count, default 1000000] [iterations, default 10]
+* About a tenth of the boxes end up visible. The seed is fixed so runs on different machines cull the same scene.
+*/
+
+namespace {
+
+	using lve::FrustumCuller;
+
+	// Average of iterations runs in milliseconds, visible holds the last run
+	template<typename CullFunction>
+	double TimeCull(CullFunction cull, uint32_t iterations, std::vector<uint32_t>& visible) {
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < iterations; i++) {
+			cull(visible);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+	}
+}
+
+int main(int argc, char** argv) {
+	try {
+		uint32_t boxCount = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 1000000;
+		uint32_t iterations = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 10;
+		if (iterations == 0) {
+			throw std::runtime_error("iterations has to be at least 1");
+		}
+
+		std::mt19937 random{ 1234 };
+		std::uniform_real_distribution<float> position{ -100.f, 100.f };
+		std::uniform_real_distribution<float> size{ 0.1f, 2.f };
+
+		FrustumCuller culler{};
+		culler.Reserve(boxCount);
+		for (uint32_t i = 0; i < boxCount; i++) {
+			culler.Add(glm::vec3{ position(random), position(random), position(random) }, glm::vec3{ size(random), size(random), size(random) });
+		}
+
+		lve::VulkanCamera camera{};
+		camera.SetPerspectiveProjection(glm::radians(60.f), 16.f / 9.f, 0.1f, 100.f);
+		camera.SetViewDirection(glm::vec3{ 0.f }, glm::vec3{ 0.f, 0.f, 1.f });
+		std::array<glm::vec4, 6> planes = camera.GetFrustumPlanes();
+
+		std::vector<uint32_t> scalarVisible{};
+		std::vector<uint32_t> simdVisible{};
+		scalarVisible.reserve(boxCount);
+		simdVisible.reserve(boxCount);
+
+		double scalarTime = TimeCull([&](std::vector<uint32_t>& visible) { culler.CullScalar(planes, visible); }, iterations, scalarVisible);
+		double simdTime = TimeCull([&](std::vector<uint32_t>& visible) { culler.Cull(planes, visible); }, iterations, simdVisible);
+
+		std::cout << "Frustum culling " << boxCount << " boxes, " << simdVisible.size() << " visible: "
+			<< scalarTime << "ms scalar, " << simdTime << "ms with " << FrustumCuller::LANE_COUNT << " lanes, "
+			<< scalarTime / simdTime << "x";
+		if (scalarVisible != simdVisible) {
+			std::cout << ", results differ!";
+		}
+		std::cout << "\n";
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
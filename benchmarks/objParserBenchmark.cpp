@@ -0,0 +1,157 @@
+//std
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include "../src/VulkanTest/Render/Model/objParser.h"
+
+/*
+* Times ObjParser against the tinyobj path LoadModel used before it, on the bundled models and on a generated file.
+* Usage: objParserBenchmark [triangle count, default 10000000] [model folder, default src/Models]
+* The generated file is written to the temp folder and removed afterwards.
+*/
+
+namespace {
+
+	struct LoadResult {
+		size_t vertexCount;
+		size_t indexCount;
+	};
+
+	// Same work as the tinyobj branch of VulkanModel::Builder::LoadModel, everything up to the dedup pass
+	LoadResult LoadWithTinyObj(const std::string& filePath) {
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
+
+		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filePath.c_str())) {
+			throw std::runtime_error(warn + err);
+		}
+
+		lve::ObjData objData{};
+		objData.vertices = std::move(attrib.vertices);
+		objData.colors = std::move(attrib.colors);
+		objData.normals = std::move(attrib.normals);
+		objData.texcoords = std::move(attrib.texcoords);
+		for (const auto& shape : shapes) {
+			for (const auto& index : shape.mesh.indices) {
+				objData.indices.push_back({ index.vertex_index, index.normal_index, index.texcoord_index });
+			}
+		}
+		return { objData.vertices.size() / 3, objData.indices.size() };
+	}
+
+	LoadResult LoadWithObjParser(const std::string& filePath) {
+		lve::ObjData objData = lve::ObjParser::ParseFile(filePath);
+		return { objData.vertices.size() / 3, objData.indices.size() };
+	}
+
+	// Best of runs, the first run also warms the file cache for the other parser
+	double TimeLoad(const std::function<LoadResult(const std::string&)>& load, const std::string& filePath, int runs, LoadResult& result) {
+		double best = 0.0;
+		for (int i = 0; i < runs; i++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			result = load(filePath);
+			auto end = std::chrono::high_resolution_clock::now();
+			double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+			best = i == 0 ? milliseconds : std::min(best, milliseconds);
+		}
+		return best;
+	}
+
+	// A wavy grid of quads with positions, texcoords and normals, two triangles per quad
+	void WriteSyntheticObj(const std::string& filePath, uint64_t triangleCount) {
+		uint64_t quadsPerSide = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::sqrt(triangleCount / 2.0))));
+		uint64_t verticesPerSide = quadsPerSide + 1;
+
+		std::ofstream file{ filePath, std::ios::binary };
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open file: " + filePath);
+		}
+
+		std::vector<char> buffer{};
+		buffer.reserve(1 << 20);
+		char line[128];
+		auto append = [&](int length) {
+			buffer.insert(buffer.end(), line, line + length);
+			if (buffer.size() > (1 << 20) - 128) {
+				file.write(buffer.data(), buffer.size());
+				buffer.clear();
+			}
+		};
+
+		for (uint64_t y = 0; y < verticesPerSide; y++) {
+			for (uint64_t x = 0; x < verticesPerSide; x++) {
+				float u = static_cast<float>(x) / quadsPerSide;
+				float v = static_cast<float>(y) / quadsPerSide;
+				float height = 0.05f * std::sin(u * 40.f) * std::cos(v * 40.f);
+				append(snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n",
+					u, height, v, u, v, -std::cos(u * 40.f) * 0.1f, 1.f, std::sin(v * 40.f) * 0.1f));
+			}
+		}
+
+		uint64_t written = 0;
+		for (uint64_t y = 0; y < quadsPerSide && written < triangleCount; y++) {
+			for (uint64_t x = 0; x < quadsPerSide && written < triangleCount; x++) {
+				unsigned long long a = y * verticesPerSide + x + 1;
+				unsigned long long b = a + 1;
+				unsigned long long c = b + verticesPerSide;
+				unsigned long long d = a + verticesPerSide;
+				append(snprintf(line, sizeof(line), "f %llu/%llu/%llu %llu/%llu/%llu %llu/%llu/%llu %llu/%llu/%llu\n",
+					a, a, a, b, b, b, c, c, c, d, d, d));
+				written += 2;
+			}
+		}
+
+		file.write(buffer.data(), buffer.size());
+	}
+
+	void Compare(const std::string& name, const std::string& filePath, int runs) {
+		LoadResult tinyObjResult{};
+		LoadResult objParserResult{};
+		double tinyObjTime = TimeLoad(LoadWithTinyObj, filePath, runs, tinyObjResult);
+		double objParserTime = TimeLoad(LoadWithObjParser, filePath, runs, objParserResult);
+
+		std::cout << name << ": " << objParserResult.indexCount / 3 << " triangles, tinyobj " << tinyObjTime << "ms, ObjParser "
+			<< objParserTime << "ms, " << tinyObjTime / objParserTime << "x";
+		if (tinyObjResult.vertexCount != objParserResult.vertexCount || tinyObjResult.indexCount != objParserResult.indexCount) {
+			std::cout << ", results differ!";
+		}
+		std::cout << "\n";
+	}
+}
+
+int main(int argc, char** argv) {
+	uint64_t triangleCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+	std::string modelFolder = argc > 2 ? argv[2] : "src/Models";
+
+	try {
+		for (const char* model : { "flat_vase.obj", "smooth_vase.obj" }) {
+			Compare(model, modelFolder + "/" + model, 10);
+		}
+
+		std::string syntheticPath = (std::filesystem::temp_directory_path() / "lve_synthetic_benchmark.obj").string();
+		WriteSyntheticObj(syntheticPath, triangleCount);
+		std::cout << "synthetic file: " << std::filesystem::file_size(syntheticPath) / (1024 * 1024) << " MB\n";
+		Compare("synthetic", syntheticPath, 1);
+		std::filesystem::remove(syntheticPath);
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+//std
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/VulkanTest/Render/Model/objParser.h"
+#include "../src/VulkanTest/Render/Model/vertexDedup.h"
+#include "../src/VulkanTest/Render/utils.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+/*
+* Times VertexDedupTable against the std::unordered_map<Vertex, uint32_t> dedup LoadModel used before it.
+* Usage: vertexDedupBenchmark [model folder, default src/Models]
+* Only the dedup pass is timed, both start from the same parsed ObjData.
+*/
+
+namespace std {
+	template<>
+	struct hash<lve::VulkanModel::Vertex>
+	{
+		size_t operator()(lve::VulkanModel::Vertex const& vertex) const
+		{
+			size_t seed = 0;
+			lve::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+			return seed;
+		}
+	};
+}
+
+namespace {
+
+	using lve::ObjData;
+	using lve::ObjIndex;
+	using Vertex = lve::VulkanModel::Vertex;
+
+	struct DedupResult {
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+	};
+
+	// The loop LoadModel had before VertexDedupTable, two lookups per corner and a node per unique vertex
+	void DedupWithUnorderedMap(const ObjData& objData, DedupResult& result) {
+		std::unordered_map<Vertex, uint32_t> uniqueVertecies{};
+
+		for (const auto& index : objData.indices) {
+			Vertex vertex{};
+
+			if (index.vertexIndex >= 0) {
+				vertex.position = {
+					objData.vertices[3 * index.vertexIndex + 0],
+					objData.vertices[3 * index.vertexIndex + 1],
+					objData.vertices[3 * index.vertexIndex + 2]
+				};
+
+				vertex.color = {
+					objData.colors[3 * index.vertexIndex + 0],
+					objData.colors[3 * index.vertexIndex + 1],
+					objData.colors[3 * index.vertexIndex + 2]
+				};
+			}
+			if (index.normalIndex >= 0) {
+				vertex.normal = {
+					objData.normals[3 * index.normalIndex + 0],
+					objData.normals[3 * index.normalIndex + 1],
+					objData.normals[3 * index.normalIndex + 2]
+				};
+			}
+			if (index.texcoordIndex >= 0) {
+				vertex.uv = {
+					objData.texcoords[2 * index.texcoordIndex + 0],
+					objData.texcoords[2 * index.texcoordIndex + 1]
+				};
+			}
+
+			if (uniqueVertecies.count(vertex) == 0) {
+				uniqueVertecies[vertex] = static_cast<uint32_t>(result.vertices.size());
+				result.vertices.push_back(vertex);
+			}
+			result.indices.push_back(uniqueVertecies[vertex]);
+		}
+	}
+
+	// Same as the current LoadModel
+	void DedupWithTable(const ObjData& objData, DedupResult& result) {
+		size_t expectedVertexCount = std::max({ objData.vertices.size() / 3, objData.normals.size() / 3, objData.texcoords.size() / 2 });
+		result.vertices.reserve(expectedVertexCount);
+		result.indices.reserve(objData.indices.size());
+
+		lve::VertexDedupTable uniqueVertecies{expectedVertexCount};
+		for (const auto& index : objData.indices) {
+			result.indices.push_back(uniqueVertecies.FindOrAdd(index, objData, result.vertices));
+		}
+	}
+
+	// Best of runs in milliseconds, result holds the last run
+	double TimeDedup(const std::function<void(const ObjData&, DedupResult&)>& dedup, const ObjData& objData, int runs, DedupResult& result) {
+		double best = 0.0;
+		for (int i = 0; i < runs; i++) {
+			result = DedupResult{};
+			auto start = std::chrono::high_resolution_clock::now();
+			dedup(objData, result);
+			auto end = std::chrono::high_resolution_clock::now();
+			double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+			best = i == 0 ? milliseconds : std::min(best, milliseconds);
+		}
+		return best;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::string modelFolder = argc > 1 ? argv[1] : "src/Models";
+
+	try {
+		for (const char* model : { "flat_vase.obj", "smooth_vase.obj" }) {
+			ObjData objData = lve::ObjParser::ParseFile(modelFolder + "/" + model);
+
+			DedupResult mapResult{};
+			DedupResult tableResult{};
+			double mapTime = TimeDedup(DedupWithUnorderedMap, objData, 20, mapResult);
+			double tableTime = TimeDedup(DedupWithTable, objData, 20, tableResult);
+
+			std::cout << model << ": " << objData.indices.size() << " corners, " << tableResult.vertices.size() << " vertices, unordered_map "
+				<< mapTime << "ms, VertexDedupTable " << tableTime << "ms, " << mapTime / tableTime << "x";
+			if (mapResult.vertices.size() != tableResult.vertices.size() || mapResult.indices != tableResult.indices) {
+				std::cout << ", results differ!";
+			}
+			std::cout << "\n";
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -44,6 +44,7 @@ namespace lve {
 		viewMatrix[3][0] = -glm::dot(u, position);
 		viewMatrix[3][1] = -glm::dot(v, position);
 		viewMatrix[3][2] = -glm::dot(w, position);
+		this->position = position;
 	}
 
 	void VulkanCamera::SetViewTarget(glm::vec3 position, glm::vec3 target, glm::vec3 up) {
@@ -74,5 +75,29 @@ namespace lve {
 		viewMatrix[3][0] = -glm::dot(u, position);
 		viewMatrix[3][1] = -glm::dot(v, position);
 		viewMatrix[3][2] = -glm::dot(w, position);
+		this->position = position;
 	}
-}
\ No newline at end of file
+
+	std::array<glm::vec4, 6> VulkanCamera::GetFrustumPlanes() const {
+		// Rows of projection * view, glm is column major
+		glm::mat4 viewProjection = projectionMatrix * viewMatrix;
+		glm::vec4 rows[4];
+		for (int i = 0; i < 4; i++) {
+			rows[i] = glm::vec4{ viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i] };
+		}
+
+		// Depth runs from 0 to 1, so the near plane is the third row alone
+		std::array<glm::vec4, 6> planes{
+			rows[3] + rows[0],
+			rows[3] - rows[0],
+			rows[3] + rows[1],
+			rows[3] - rows[1],
+			rows[2],
+			rows[3] - rows[2]
+		};
+		for (auto& plane : planes) {
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return planes;
+	}
+}
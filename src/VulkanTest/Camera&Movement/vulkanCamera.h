@@ -4,12 +4,15 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include <array>
+
 namespace lve {
 
 	class VulkanCamera {
 
 		glm::mat4 projectionMatrix {1.f};
 		glm::mat4 viewMatrix {1.f};
+		glm::vec3 position {0.f};
 		
 
 	public:
@@ -23,5 +26,10 @@ namespace lve {
 
 		const glm::mat4& GetProjectionMatrix() const { return projectionMatrix; }
 		const glm::mat4& GetViewMatrix() const { return viewMatrix; }
+		const glm::vec3& GetPosition() const { return position; }
+		bool IsPerspective() const { return projectionMatrix[2][3] != 0.f; }
+		// Left, right, bottom, top, near and far planes in world space, xyz is the normalized inward normal and
+		// dot(xyz, point) + w is the signed distance of a point
+		std::array<glm::vec4, 6> GetFrustumPlanes() const;
 	};
 }
\ No newline at end of file
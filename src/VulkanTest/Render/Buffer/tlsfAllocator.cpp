@@ -0,0 +1,248 @@
+#include "tlsfAllocator.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace lve {
+
+    namespace {
+        uint32_t LowestBit(uint64_t value) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward64(&index, value);
+            return static_cast<uint32_t>(index);
+#else
+            return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+        }
+
+        uint32_t HighestBit(uint64_t value) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return static_cast<uint32_t>(index);
+#else
+            return 63u - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+        }
+
+        uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+    }
+
+    TlsfAllocator::TlsfAllocator(uint64_t size) : size{ size } {
+        for (auto& heads : freeHeads) {
+            for (auto& head : heads) {
+                head = NONE;
+            }
+        }
+
+        if (size > 0) {
+            uint32_t block = NewBlock();
+            blocks[block].offset = 0;
+            blocks[block].size = size;
+            blocks[block].isFree = true;
+            InsertFree(block);
+        }
+    }
+
+    uint64_t TlsfAllocator::Allocate(uint64_t allocationSize, uint64_t alignment) {
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "alignment must be a power of two");
+        allocationSize = allocationSize > 0 ? allocationSize : 1;
+        if (allocationSize > size) {
+            return INVALID_OFFSET;
+        }
+
+        // Room for moving the start up to the alignment anywhere in the block
+        uint32_t block = FindFreeBlock(allocationSize + alignment - 1);
+        if (block == NONE) {
+            return INVALID_OFFSET;
+        }
+        RemoveFree(block);
+
+        uint64_t padding = AlignUp(blocks[block].offset, alignment) - blocks[block].offset;
+        if (padding > 0) {
+            // The padding stays free, its previous neighbour is in use since free neighbours are always merged
+            uint32_t front = block;
+            Split(front, padding);
+            block = blocks[front].nextPhysical;
+            InsertFree(front);
+        }
+
+        if (blocks[block].size > allocationSize) {
+            Split(block, allocationSize);
+            InsertFree(blocks[block].nextPhysical);
+        }
+
+        blocks[block].isFree = false;
+        allocations[blocks[block].offset] = block;
+        usedSize += blocks[block].size;
+        return blocks[block].offset;
+    }
+
+    void TlsfAllocator::Free(uint64_t offset) {
+        auto allocation = allocations.find(offset);
+        assert(allocation != allocations.end() && "freeing an offset that was never allocated");
+        if (allocation == allocations.end()) {
+            return;
+        }
+
+        uint32_t block = allocation->second;
+        allocations.erase(allocation);
+        usedSize -= blocks[block].size;
+        blocks[block].isFree = true;
+
+        uint32_t next = blocks[block].nextPhysical;
+        if (next != NONE && blocks[next].isFree) {
+            RemoveFree(next);
+            MergeWithPrevious(next);
+        }
+        uint32_t previous = blocks[block].prevPhysical;
+        if (previous != NONE && blocks[previous].isFree) {
+            RemoveFree(previous);
+            block = MergeWithPrevious(block);
+        }
+        InsertFree(block);
+    }
+
+    uint64_t TlsfAllocator::GetLargestFreeBlock() const {
+        if (flBitmap == 0) {
+            return 0;
+        }
+
+        // Sizes within one class differ, so the whole list of the highest class has to be looked at
+        uint32_t fl = HighestBit(flBitmap);
+        uint32_t sl = HighestBit(slBitmaps[fl]);
+        uint64_t largest = 0;
+        for (uint32_t block = freeHeads[fl][sl]; block != NONE; block = blocks[block].nextFree) {
+            largest = std::max(largest, blocks[block].size);
+        }
+        return largest;
+    }
+
+    void TlsfAllocator::Mapping(uint64_t size, uint32_t& fl, uint32_t& sl) {
+        if (size < SL_COUNT) {
+            fl = 0;
+            sl = static_cast<uint32_t>(size);
+            return;
+        }
+        uint32_t highestBit = HighestBit(size);
+        fl = highestBit - SL_LOG2 + 1;
+        sl = static_cast<uint32_t>(size >> (highestBit - SL_LOG2)) - SL_COUNT;
+    }
+
+    uint32_t TlsfAllocator::FindFreeBlock(uint64_t size) {
+        // Round up to the next size class so every block in the class found is large enough
+        if (size >= SL_COUNT) {
+            uint64_t round = (1ull << (HighestBit(size) - SL_LOG2)) - 1;
+            if (size > UINT64_MAX - round) {
+                return NONE;
+            }
+            size += round;
+        }
+
+        uint32_t fl;
+        uint32_t sl;
+        Mapping(size, fl, sl);
+
+        uint32_t slMap = slBitmaps[fl] & (~0u << sl);
+        if (slMap == 0) {
+            uint64_t flMap = fl + 1 < 64 ? flBitmap & (~0ull << (fl + 1)) : 0;
+            if (flMap == 0) {
+                return NONE;
+            }
+            fl = LowestBit(flMap);
+            slMap = slBitmaps[fl];
+        }
+        sl = LowestBit(slMap);
+        return freeHeads[fl][sl];
+    }
+
+    void TlsfAllocator::InsertFree(uint32_t block) {
+        uint32_t fl;
+        uint32_t sl;
+        Mapping(blocks[block].size, fl, sl);
+
+        blocks[block].isFree = true;
+        blocks[block].prevFree = NONE;
+        blocks[block].nextFree = freeHeads[fl][sl];
+        if (freeHeads[fl][sl] != NONE) {
+            blocks[freeHeads[fl][sl]].prevFree = block;
+        }
+        freeHeads[fl][sl] = block;
+
+        flBitmap |= 1ull << fl;
+        slBitmaps[fl] |= 1u << sl;
+    }
+
+    void TlsfAllocator::RemoveFree(uint32_t block) {
+        uint32_t fl;
+        uint32_t sl;
+        Mapping(blocks[block].size, fl, sl);
+
+        Block& removed = blocks[block];
+        if (removed.prevFree != NONE) {
+            blocks[removed.prevFree].nextFree = removed.nextFree;
+        }
+        if (removed.nextFree != NONE) {
+            blocks[removed.nextFree].prevFree = removed.prevFree;
+        }
+        if (freeHeads[fl][sl] == block) {
+            freeHeads[fl][sl] = removed.nextFree;
+            if (freeHeads[fl][sl] == NONE) {
+                slBitmaps[fl] &= ~(1u << sl);
+                if (slBitmaps[fl] == 0) {
+                    flBitmap &= ~(1ull << fl);
+                }
+            }
+        }
+        removed.prevFree = NONE;
+        removed.nextFree = NONE;
+    }
+
+    void TlsfAllocator::Split(uint32_t block, uint64_t frontSize) {
+        uint32_t rest = NewBlock();
+        Block& front = blocks[block];
+
+        blocks[rest].offset = front.offset + frontSize;
+        blocks[rest].size = front.size - frontSize;
+        blocks[rest].isFree = true;
+        blocks[rest].prevPhysical = block;
+        blocks[rest].nextPhysical = front.nextPhysical;
+        if (front.nextPhysical != NONE) {
+            blocks[front.nextPhysical].prevPhysical = rest;
+        }
+        front.nextPhysical = rest;
+        front.size = frontSize;
+    }
+
+    uint32_t TlsfAllocator::MergeWithPrevious(uint32_t block) {
+        uint32_t previous = blocks[block].prevPhysical;
+        blocks[previous].size += blocks[block].size;
+        blocks[previous].nextPhysical = blocks[block].nextPhysical;
+        if (blocks[block].nextPhysical != NONE) {
+            blocks[blocks[block].nextPhysical].prevPhysical = previous;
+        }
+
+        blocks[block] = {};
+        unusedBlocks.push_back(block);
+        return previous;
+    }
+
+    uint32_t TlsfAllocator::NewBlock() {
+        if (!unusedBlocks.empty()) {
+            uint32_t block = unusedBlocks.back();
+            unusedBlocks.pop_back();
+            return block;
+        }
+        blocks.emplace_back();
+        return static_cast<uint32_t>(blocks.size() - 1);
+    }
+
+}  // namespace lve
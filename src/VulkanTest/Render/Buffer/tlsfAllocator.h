@@ -0,0 +1,75 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+    /*
+     * Two level segregated fit allocator over an abstract range [0, size).
+     * It only hands out offsets and keeps its bookkeeping on the CPU, so the same allocator sub-allocates
+     * buffers (in elements or bytes) and device memory blocks. Allocate and Free are O(1): free blocks are
+     * kept in size classes of a power of two split into SL_COUNT linear steps, found through two bitmaps,
+     * and neighbours are merged on Free. Not thread safe.
+     */
+    class TlsfAllocator {
+    public:
+        static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+        TlsfAllocator(uint64_t size);
+
+        // Returns INVALID_OFFSET when no free block fits, alignment has to be a power of two
+        uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+        void Free(uint64_t offset);
+
+        uint64_t GetSize() const { return size; }
+        uint64_t GetUsedSize() const { return usedSize; }
+        uint32_t GetAllocationCount() const { return static_cast<uint32_t>(allocations.size()); }
+        bool IsEmpty() const { return allocations.empty(); }
+        // Largest size Allocate can still hand out with an alignment of 1
+        uint64_t GetLargestFreeBlock() const;
+
+    private:
+        static constexpr uint32_t SL_LOG2 = 5;
+        static constexpr uint32_t SL_COUNT = 1u << SL_LOG2;
+        static constexpr uint32_t FL_COUNT = 64 - SL_LOG2 + 1;
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        struct Block {
+            uint64_t offset{0};
+            uint64_t size{0};
+            // Neighbours in address order
+            uint32_t prevPhysical{NONE};
+            uint32_t nextPhysical{NONE};
+            // Neighbours in the free list of this size class, only valid while free
+            uint32_t prevFree{NONE};
+            uint32_t nextFree{NONE};
+            bool isFree{false};
+        };
+
+        static void Mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+
+        uint32_t FindFreeBlock(uint64_t size);
+        void InsertFree(uint32_t block);
+        void RemoveFree(uint32_t block);
+        // Splits size bytes off the front of block, the rest becomes a new free block
+        void Split(uint32_t block, uint64_t size);
+        // Merges block into its previous physical neighbour and returns the survivor
+        uint32_t MergeWithPrevious(uint32_t block);
+        uint32_t NewBlock();
+
+        uint64_t size;
+        uint64_t usedSize{0};
+
+        std::vector<Block> blocks{};
+        std::vector<uint32_t> unusedBlocks{};
+        std::unordered_map<uint64_t, uint32_t> allocations{};
+
+        uint64_t flBitmap{0};
+        uint32_t slBitmaps[FL_COUNT]{};
+        uint32_t freeHeads[FL_COUNT][SL_COUNT];
+    };
+
+}  // namespace lve
@@ -11,6 +11,7 @@
 #include "vulkanBuffer.h"
 
  // std
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -38,7 +39,8 @@ namespace lve {
         uint32_t instanceCount,
         VkBufferUsageFlags usageFlags,
         VkMemoryPropertyFlags memoryPropertyFlags,
-        VkDeviceSize minOffsetAlignment)
+        VkDeviceSize minOffsetAlignment,
+        VkMemoryPropertyFlags preferredMemoryPropertyFlags)
         : lveDevice{ device },
         instanceSize{ instanceSize },
         instanceCount{ instanceCount },
@@ -46,27 +48,35 @@ namespace lve {
         memoryPropertyFlags{ memoryPropertyFlags } {
         alignmentSize = GetAlignment(instanceSize, minOffsetAlignment);
         bufferSize = alignmentSize * instanceCount;
-        device.CreateBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+        device.CreateBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation, preferredMemoryPropertyFlags);
+        this->memoryPropertyFlags = device.getMemoryAllocator().GetMemoryTypeFlags(allocation.memoryTypeIndex);
     }
 
     VulkanBuffer::~VulkanBuffer() {
         Unmap();
         vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
-        vkFreeMemory(lveDevice.device(), memory, nullptr);
+        lveDevice.getMemoryAllocator().Free(allocation);
     }
 
     /**
      * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
      *
-     * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
-     * buffer range.
-     * @param offset (Optional) Byte offset from beginning
+     * @note The buffer shares its memory block with other resources, the allocator maps the whole block once
+     * and every mapped buffer in it points into that mapping
+     *
+     * @param offset (Optional) Byte offset from beginning, the rest of the buffer is accessible from there
      *
      * @return VkResult of the buffer mapping call
      */
-    VkResult VulkanBuffer::Map(VkDeviceSize size, VkDeviceSize offset) {
-        assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(lveDevice.device(), memory, offset, size, 0, &mapped);
+    VkResult VulkanBuffer::Map(VkDeviceSize offset) {
+        assert(buffer && allocation.memory && "Called map on buffer before create");
+        assert(offset <= bufferSize && "Map offset is past the end of the buffer");
+        void* data = nullptr;
+        VkResult result = lveDevice.getMemoryAllocator().Map(allocation, &data);
+        if (result == VK_SUCCESS) {
+            mapped = static_cast<char*>(data) + offset;
+        }
+        return result;
     }
 
     /**
@@ -76,7 +86,7 @@ namespace lve {
      */
     void VulkanBuffer::Unmap() {
         if (mapped) {
-            vkUnmapMemory(lveDevice.device(), memory);
+            lveDevice.getMemoryAllocator().Unmap(allocation);
             mapped = nullptr;
         }
     }
@@ -106,7 +116,8 @@ namespace lve {
     /**
      * Flush a memory range of the buffer to make it visible to the device
      *
-     * @note Only required for non-coherent memory
+     * @note Does nothing on coherent memory, on non-coherent memory the range is widened to whole
+     * nonCoherentAtomSize atoms
      *
      * @param size (Optional) Size of the memory range to flush. Pass VK_WHOLE_SIZE to flush the
      * complete buffer range.
@@ -115,18 +126,18 @@ namespace lve {
      * @return VkResult of the flush call
      */
     VkResult VulkanBuffer::Flush(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        if (IsHostCoherent()) {
+            return VK_SUCCESS;
+        }
+        VkMappedMemoryRange mappedRange = GetMappedRange(size, offset);
         return vkFlushMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
     }
 
     /**
      * Invalidate a memory range of the buffer to make it visible to the host
      *
-     * @note Only required for non-coherent memory
+     * @note Does nothing on coherent memory, on non-coherent memory the range is widened to whole
+     * nonCoherentAtomSize atoms
      *
      * @param size (Optional) Size of the memory range to invalidate. Pass VK_WHOLE_SIZE to invalidate
      * the complete buffer range.
@@ -135,12 +146,31 @@ namespace lve {
      * @return VkResult of the invalidate call
      */
     VkResult VulkanBuffer::Invalidate(VkDeviceSize size, VkDeviceSize offset) {
+        if (IsHostCoherent()) {
+            return VK_SUCCESS;
+        }
+        VkMappedMemoryRange mappedRange = GetMappedRange(size, offset);
+        return vkInvalidateMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
+    }
+
+    /**
+     * Memory range covering [offset, offset + size) of the buffer, widened to whole nonCoherentAtomSize atoms
+     *
+     * @note Host visible allocations start on an atom and span whole atoms, so the widened range never
+     * leaves the allocation
+     */
+    VkMappedMemoryRange VulkanBuffer::GetMappedRange(VkDeviceSize size, VkDeviceSize offset) const {
+        VkDeviceSize atomSize = std::max<VkDeviceSize>(lveDevice.properties.limits.nonCoherentAtomSize, 1);
+        VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.size : std::min(offset + size, allocation.size);
+        end = std::min((end + atomSize - 1) / atomSize * atomSize, allocation.size);
+        VkDeviceSize start = std::min(offset / atomSize * atomSize, end);
+
         VkMappedMemoryRange mappedRange = {};
         mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkInvalidateMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
+        mappedRange.memory = allocation.memory;
+        mappedRange.offset = allocation.offset + start;
+        mappedRange.size = end - start;
+        return mappedRange;
     }
 
     /**
@@ -12,13 +12,15 @@ namespace lve {
             uint32_t instanceCount,
             VkBufferUsageFlags usageFlags,
             VkMemoryPropertyFlags memoryPropertyFlags,
-            VkDeviceSize minOffsetAlignment = 1);
+            VkDeviceSize minOffsetAlignment = 1,
+            VkMemoryPropertyFlags preferredMemoryPropertyFlags = 0);
         ~VulkanBuffer();
 
         VulkanBuffer(const VulkanBuffer&) = delete;
         VulkanBuffer& operator=(const VulkanBuffer&) = delete;
 
-        VkResult Map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+        // Always maps the whole buffer, mapped points offset bytes into it
+        VkResult Map(VkDeviceSize offset = 0);
         void Unmap();
 
         void WriteToBuffer(void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
@@ -35,18 +37,21 @@ namespace lve {
         void* GetMappedMemory() const { return mapped; }
         uint32_t GetInstanceCount() const { return instanceCount; }
         VkDeviceSize GetInstanceSize() const { return instanceSize; }
-        VkDeviceSize GetAlignmentSize() const { return instanceSize; }
+        VkDeviceSize GetAlignmentSize() const { return alignmentSize; }
         VkBufferUsageFlags GetUsageFlags() const { return usageFlags; }
+        // Flags of the memory type the buffer ended up in, can have more than were asked for
         VkMemoryPropertyFlags GetMemoryPropertyFlags() const { return memoryPropertyFlags; }
+        bool IsHostCoherent() const { return memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT; }
         VkDeviceSize GetBufferSize() const { return bufferSize; }
 
     private:
         static VkDeviceSize GetAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
+        VkMappedMemoryRange GetMappedRange(VkDeviceSize size, VkDeviceSize offset) const;
 
         VulkanDevice& lveDevice;
         void* mapped = nullptr;
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VulkanMemoryAllocator::Allocation allocation{};
 
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
@@ -0,0 +1,101 @@
+#include "vulkanFrameAllocator.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+
+namespace lve {
+
+    namespace {
+        VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+    }
+
+    VulkanFrameAllocator::VulkanFrameAllocator(
+        VulkanDevice& device,
+        VkDeviceSize frameSize,
+        uint32_t frameCount,
+        VkBufferUsageFlags usageFlags)
+        : device{ device },
+        usageFlags{ usageFlags },
+        frameCount{ frameCount },
+        frameSize{ frameSize } {
+        const VkPhysicalDeviceLimits& limits = device.properties.limits;
+
+        // Every dynamic offset has to be a multiple of the offset alignment of each descriptor type it is used with
+        alignment = 1;
+        if (usageFlags & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+            alignment = std::max(alignment, limits.minUniformBufferOffsetAlignment);
+        }
+        if (usageFlags & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+            alignment = std::max(alignment, limits.minStorageBufferOffsetAlignment);
+        }
+
+        CreateBuffer();
+    }
+
+    void VulkanFrameAllocator::BeginFrame(uint32_t frameIndex) {
+        assert(frameIndex < buffer->GetInstanceCount() && "frame index out of range");
+        currentFrame = frameIndex;
+        frameOffset = buffer->GetAlignmentSize() * frameIndex;
+        head = 0;
+    }
+
+    void VulkanFrameAllocator::Flush() {
+        // Only the bytes written this frame, VulkanBuffer skips the call entirely on coherent memory
+        if (head > 0) {
+            buffer->Flush(head, frameOffset);
+        }
+    }
+
+    VulkanFrameAllocator::Allocation VulkanFrameAllocator::Allocate(VkDeviceSize size) {
+        VkDeviceSize offset = AlignUp(head, alignment);
+        if (offset + size > frameSize) {
+            throw std::runtime_error("frame allocator is out of memory!");
+        }
+        head = offset + size;
+
+        Allocation allocation{};
+        allocation.data = static_cast<char*>(buffer->GetMappedMemory()) + frameOffset + offset;
+        allocation.dynamicOffset = static_cast<uint32_t>(frameOffset + offset);
+        return allocation;
+    }
+
+    void VulkanFrameAllocator::Reserve(VkDeviceSize frameSize) {
+        if (frameSize <= this->frameSize) {
+            return;
+        }
+        assert(head == 0 && "reserving after allocating this frame");
+
+        // The whole region is one descriptor range, and the last region's dynamic offset has to fit in 32 bits
+        const VkPhysicalDeviceLimits& limits = device.properties.limits;
+        VkDeviceSize maxRange = (usageFlags & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) ? limits.maxUniformBufferRange : limits.maxStorageBufferRange;
+        maxRange = std::min<VkDeviceSize>(maxRange, UINT32_MAX / frameCount - alignment);
+        if (frameSize > maxRange) {
+            throw std::runtime_error("frame allocator region is larger than the descriptor range limit!");
+        }
+
+        this->frameSize = std::min(std::max(frameSize, this->frameSize * 2), maxRange);
+        CreateBuffer();
+        BeginFrame(currentFrame);
+    }
+
+    void VulkanFrameAllocator::CreateBuffer() {
+        // minOffsetAlignment rounds each frame region up, so every region starts on an aligned offset too.
+        // Coherent memory makes Flush free, device local host visible memory (resizable BAR) saves the GPU
+        // from reading the constants over PCIe
+        buffer = std::make_unique<VulkanBuffer>(
+            device,
+            frameSize,
+            frameCount,
+            usageFlags,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+            alignment,
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        buffer->Map();
+    }
+
+}  // namespace lve
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "vulkanBuffer.h"
+
+// std
+#include <cstring>
+#include <memory>
+
+namespace lve {
+
+    /*
+     * Linear allocator for data that only lives for one frame, like per pass and per object constants.
+     * One persistently mapped buffer holds a region per frame in flight, allocating bumps a pointer through the
+     * region of the current frame and BeginFrame resets it. Everything is read through one descriptor of type
+     * VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC (or STORAGE_BUFFER_DYNAMIC) and picked by the dynamic offset,
+     * so transient data needs neither new buffers nor new descriptor sets.
+     * Reserve grows the regions when a frame needs more, which replaces the buffer and its descriptors have to be rewritten.
+     */
+    class VulkanFrameAllocator {
+    public:
+        struct Allocation {
+            void* data{nullptr};
+            // Offset from the start of the buffer, pass it to vkCmdBindDescriptorSets
+            uint32_t dynamicOffset{0};
+        };
+
+        VulkanFrameAllocator(
+            VulkanDevice& device,
+            VkDeviceSize frameSize,
+            uint32_t frameCount,
+            VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+        VulkanFrameAllocator(const VulkanFrameAllocator&) = delete;
+        VulkanFrameAllocator& operator=(const VulkanFrameAllocator&) = delete;
+
+        // Frees everything allocated the last time frameIndex was used, call once the fence of that frame has signaled
+        void BeginFrame(uint32_t frameIndex);
+        // Makes this frame's allocations visible to the device, call before submitting
+        void Flush();
+
+        // Throws when the frame region is full, data stays valid until the frame index comes around again
+        Allocation Allocate(VkDeviceSize size);
+
+        // Grows every frame region to at least frameSize bytes, regions at least double so this stays rare.
+        // Replaces the buffer when frameSize is above GetFrameSize: the device has to be idle, nothing allocated
+        // this frame yet, and every descriptor from DescriptorInfo rewritten afterwards
+        void Reserve(VkDeviceSize frameSize);
+
+        template<typename T>
+        uint32_t Push(const T& value) {
+            Allocation allocation = Allocate(sizeof(T));
+            std::memcpy(allocation.data, &value, sizeof(T));
+            return allocation.dynamicOffset;
+        }
+
+        // range is how much a shader sees behind each dynamic offset
+        VkDescriptorBufferInfo DescriptorInfo(VkDeviceSize range) { return buffer->DescriptorInfo(range, 0); }
+
+        VkDeviceSize GetFrameSize() const { return frameSize; }
+        VkDeviceSize GetUsedSize() const { return head; }
+
+    private:
+        void CreateBuffer();
+
+        VulkanDevice& device;
+        VkBufferUsageFlags usageFlags;
+        uint32_t frameCount;
+        VkDeviceSize frameSize;
+        VkDeviceSize alignment;
+        std::unique_ptr<VulkanBuffer> buffer;
+
+        uint32_t currentFrame{0};
+        VkDeviceSize frameOffset{0};
+        VkDeviceSize head{0};
+    };
+
+}  // namespace lve
@@ -0,0 +1,516 @@
+#include "vulkanMemoryAllocator.h"
+
+// std
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace lve {
+
+    namespace {
+        VkPhysicalDeviceMemoryProperties QueryMemoryProperties(VkPhysicalDevice physicalDevice) {
+            VkPhysicalDeviceMemoryProperties memoryProperties;
+            vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+            return memoryProperties;
+        }
+
+        VkPhysicalDeviceLimits QueryLimits(VkPhysicalDevice physicalDevice) {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+            return properties.limits;
+        }
+
+        VulkanMemoryAllocator::MemoryFunctions MakeDeviceFunctions(VkDevice device) {
+            VulkanMemoryAllocator::MemoryFunctions functions{};
+            functions.allocate = [device](uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory& memory) {
+                VkMemoryAllocateInfo allocInfo{};
+                allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+                allocInfo.allocationSize = size;
+                allocInfo.memoryTypeIndex = memoryTypeIndex;
+                return vkAllocateMemory(device, &allocInfo, nullptr, &memory);
+            };
+            functions.free = [device](VkDeviceMemory memory) {
+                vkFreeMemory(device, memory, nullptr);
+            };
+            functions.map = [device](VkDeviceMemory memory, void** data) {
+                return vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, data);
+            };
+            functions.unmap = [device](VkDeviceMemory memory) {
+                vkUnmapMemory(device, memory);
+            };
+            return functions;
+        }
+
+        VulkanMemoryAllocator::MemoryFunctions MakeDeviceFunctions(
+            VkInstance instance, VkDevice device, VkPhysicalDevice physicalDevice, bool memoryBudget) {
+            VulkanMemoryAllocator::MemoryFunctions functions = MakeDeviceFunctions(device);
+            if (!memoryBudget) {
+                return functions;
+            }
+
+            // Instance is 1.0, so vkGetPhysicalDeviceMemoryProperties2 comes from the KHR extension
+            auto getMemoryProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(
+                vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR"));
+            if (getMemoryProperties2 == nullptr) {
+                return functions;
+            }
+
+            functions.queryBudget = [physicalDevice, getMemoryProperties2](VkDeviceSize* heapUsage, VkDeviceSize* heapBudget) {
+                VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+                budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+                VkPhysicalDeviceMemoryProperties2 memoryProperties2{};
+                memoryProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+                memoryProperties2.pNext = &budgetProperties;
+                getMemoryProperties2(physicalDevice, &memoryProperties2);
+
+                for (uint32_t i = 0; i < VK_MAX_MEMORY_HEAPS; i++) {
+                    heapUsage[i] = budgetProperties.heapUsage[i];
+                    heapBudget[i] = budgetProperties.heapBudget[i];
+                }
+            };
+            return functions;
+        }
+
+        void AddBlock(VulkanMemoryAllocator::Statistics& statistics, VkDeviceSize size, const TlsfAllocator* allocator) {
+            statistics.allocatedBytes += size;
+            if (allocator == nullptr) {
+                statistics.dedicatedCount++;
+                return;
+            }
+            statistics.blockCount++;
+            statistics.freeBytes += size - allocator->GetUsedSize();
+            statistics.largestFreeBlock = std::max(statistics.largestFreeBlock, allocator->GetLargestFreeBlock());
+        }
+
+        void AddStatistics(VulkanMemoryAllocator::Statistics& statistics, const VulkanMemoryAllocator::Statistics& other) {
+            statistics.blockCount += other.blockCount;
+            statistics.dedicatedCount += other.dedicatedCount;
+            statistics.allocationCount += other.allocationCount;
+            statistics.allocatedBytes += other.allocatedBytes;
+            statistics.usedBytes += other.usedBytes;
+            statistics.freeBytes += other.freeBytes;
+            statistics.largestFreeBlock = std::max(statistics.largestFreeBlock, other.largestFreeBlock);
+        }
+
+        void ComputeFragmentation(VulkanMemoryAllocator::Statistics& statistics) {
+            statistics.fragmentation = statistics.freeBytes > 0
+                ? 1.f - static_cast<float>(statistics.largestFreeBlock) / static_cast<float>(statistics.freeBytes)
+                : 0.f;
+        }
+
+        void WriteStatisticsJson(std::ostream& out, const VulkanMemoryAllocator::Statistics& statistics) {
+            out << "{\"blockCount\": " << statistics.blockCount
+                << ", \"dedicatedCount\": " << statistics.dedicatedCount
+                << ", \"allocationCount\": " << statistics.allocationCount
+                << ", \"allocatedBytes\": " << statistics.allocatedBytes
+                << ", \"usedBytes\": " << statistics.usedBytes
+                << ", \"freeBytes\": " << statistics.freeBytes
+                << ", \"largestFreeBlock\": " << statistics.largestFreeBlock
+                << ", \"fragmentation\": " << statistics.fragmentation << "}";
+        }
+
+        VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+    }
+
+    VulkanMemoryAllocator::VulkanMemoryAllocator(
+        VkInstance instance, VkDevice device, VkPhysicalDevice physicalDevice, bool memoryBudget)
+        : VulkanMemoryAllocator{
+            QueryMemoryProperties(physicalDevice),
+            QueryLimits(physicalDevice).bufferImageGranularity,
+            QueryLimits(physicalDevice).nonCoherentAtomSize,
+            MakeDeviceFunctions(instance, device, physicalDevice, memoryBudget) } {}
+
+    VulkanMemoryAllocator::VulkanMemoryAllocator(
+        const VkPhysicalDeviceMemoryProperties& memoryProperties,
+        VkDeviceSize bufferImageGranularity,
+        VkDeviceSize nonCoherentAtomSize,
+        MemoryFunctions functions)
+        : memoryProperties{ memoryProperties },
+        bufferImageGranularity{ std::max<VkDeviceSize>(bufferImageGranularity, 1) },
+        nonCoherentAtomSize{ std::max<VkDeviceSize>(nonCoherentAtomSize, 1) },
+        functions{ std::move(functions) } {}
+
+    VulkanMemoryAllocator::~VulkanMemoryAllocator() {
+        uint32_t allocationCount = std::accumulate(std::begin(allocationCounts), std::end(allocationCounts), 0u);
+        if (allocationCount > 0) {
+            std::cout << allocationCount << " device memory allocations were not freed before the allocator\n";
+        }
+        for (uint32_t block = 0; block < blocks.size(); block++) {
+            if (blocks[block] != nullptr) {
+                DestroyBlock(block);
+            }
+        }
+    }
+
+    uint32_t VulkanMemoryAllocator::FindMemoryType(
+        uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferredProperties) const {
+        uint32_t memoryTypeIndex = FindMemoryTypeOrNone(typeFilter, properties, preferredProperties);
+        if (memoryTypeIndex == NONE) {
+            throw std::runtime_error("failed to find suitable memory type!");
+        }
+        return memoryTypeIndex;
+    }
+
+    VkMemoryPropertyFlags VulkanMemoryAllocator::GetMemoryTypeFlags(uint32_t memoryTypeIndex) const {
+        assert(memoryTypeIndex < memoryProperties.memoryTypeCount && "memory type index out of range");
+        return memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+    }
+
+    VulkanMemoryAllocator::Allocation VulkanMemoryAllocator::Allocate(
+        const VkMemoryRequirements& requirements,
+        VkMemoryPropertyFlags properties,
+        VkMemoryPropertyFlags preferredProperties,
+        ResourceKind kind) {
+        std::lock_guard<std::mutex> lock{ mutex };
+
+        uint32_t typeFilter = requirements.memoryTypeBits;
+        if (FindMemoryTypeOrNone(typeFilter, properties, preferredProperties) == NONE) {
+            throw std::runtime_error("failed to find suitable memory type!");
+        }
+
+        // A heap can run full while another type with the required properties still has room,
+        // like the small device local and host visible heap without resizable BAR
+        for (uint32_t memoryTypeIndex = FindMemoryTypeOrNone(typeFilter, properties, preferredProperties);
+            memoryTypeIndex != NONE;
+            memoryTypeIndex = FindMemoryTypeOrNone(typeFilter, properties, preferredProperties)) {
+
+            Allocation allocation{};
+            if (TryAllocate(memoryTypeIndex, requirements, kind, allocation)) {
+                allocationCounts[memoryTypeIndex]++;
+                usedBytes[memoryTypeIndex] += allocation.size;
+                return allocation;
+            }
+            typeFilter &= ~(1u << memoryTypeIndex);
+        }
+
+        throw std::runtime_error("failed to allocate device memory!");
+    }
+
+    void VulkanMemoryAllocator::Free(Allocation& allocation) {
+        if (allocation.memory == VK_NULL_HANDLE) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock{ mutex };
+        assert(allocation.block < blocks.size() && blocks[allocation.block] != nullptr && "allocation was already freed");
+
+        allocationCounts[allocation.memoryTypeIndex]--;
+        usedBytes[allocation.memoryTypeIndex] -= allocation.size;
+
+        Block& block = *blocks[allocation.block];
+        if (allocation.dedicated) {
+            DestroyBlock(allocation.block);
+        }
+        else {
+            block.allocator->Free(allocation.offset);
+
+            // Keep one empty block per pool so a resource that is recreated every frame doesn't reallocate it
+            if (block.allocator->IsEmpty()) {
+                for (uint32_t other : pools[block.pool]) {
+                    if (other != allocation.block && blocks[other]->allocator->IsEmpty()) {
+                        DestroyBlock(allocation.block);
+                        break;
+                    }
+                }
+            }
+        }
+
+        allocation = {};
+    }
+
+    VkResult VulkanMemoryAllocator::Map(const Allocation& allocation, void** data) {
+        std::lock_guard<std::mutex> lock{ mutex };
+        assert((GetMemoryTypeFlags(allocation.memoryTypeIndex) & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && "mapping memory that is not host visible");
+
+        Block& block = *blocks[allocation.block];
+        if (block.mapCount == 0) {
+            VkResult result = functions.map(block.memory, &block.mapped);
+            if (result != VK_SUCCESS) {
+                return result;
+            }
+        }
+        block.mapCount++;
+        *data = static_cast<char*>(block.mapped) + allocation.offset;
+        return VK_SUCCESS;
+    }
+
+    void VulkanMemoryAllocator::Unmap(const Allocation& allocation) {
+        std::lock_guard<std::mutex> lock{ mutex };
+
+        Block& block = *blocks[allocation.block];
+        assert(block.mapCount > 0 && "unmapping memory that is not mapped");
+        if (--block.mapCount == 0) {
+            functions.unmap(block.memory);
+            block.mapped = nullptr;
+        }
+    }
+
+    VulkanMemoryAllocator::Statistics VulkanMemoryAllocator::GetStatistics() {
+        std::lock_guard<std::mutex> lock{ mutex };
+        return GetDetailedStatisticsLocked().total;
+    }
+
+    VulkanMemoryAllocator::DetailedStatistics VulkanMemoryAllocator::GetDetailedStatistics() {
+        std::lock_guard<std::mutex> lock{ mutex };
+        return GetDetailedStatisticsLocked();
+    }
+
+    std::vector<VulkanMemoryAllocator::HeapBudget> VulkanMemoryAllocator::GetHeapBudgets() {
+        std::lock_guard<std::mutex> lock{ mutex };
+        return GetDetailedStatisticsLocked().budgets;
+    }
+
+    std::string VulkanMemoryAllocator::GetStatisticsJson() {
+        DetailedStatistics statistics = GetDetailedStatistics();
+
+        std::ostringstream out;
+        out << "{\n  \"budgetSource\": \"" << (statistics.budgetFromDriver ? "VK_EXT_memory_budget" : "estimated") << "\",\n";
+        out << "  \"total\": ";
+        WriteStatisticsJson(out, statistics.total);
+
+        out << ",\n  \"heaps\": [";
+        for (uint32_t i = 0; i < statistics.memoryHeaps.size(); i++) {
+            const HeapBudget& budget = statistics.budgets[i];
+            out << (i > 0 ? "," : "") << "\n    {\"index\": " << i
+                << ", \"size\": " << budget.size
+                << ", \"flags\": " << memoryProperties.memoryHeaps[i].flags
+                << ", \"budget\": " << budget.budget
+                << ", \"usage\": " << budget.usage
+                << ", \"statistics\": ";
+            WriteStatisticsJson(out, statistics.memoryHeaps[i]);
+            out << "}";
+        }
+
+        out << "\n  ],\n  \"types\": [";
+        for (uint32_t i = 0; i < statistics.memoryTypes.size(); i++) {
+            out << (i > 0 ? "," : "") << "\n    {\"index\": " << i
+                << ", \"heap\": " << memoryProperties.memoryTypes[i].heapIndex
+                << ", \"flags\": " << memoryProperties.memoryTypes[i].propertyFlags
+                << ", \"statistics\": ";
+            WriteStatisticsJson(out, statistics.memoryTypes[i]);
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+        return out.str();
+    }
+
+    VulkanMemoryAllocator::DetailedStatistics VulkanMemoryAllocator::GetDetailedStatisticsLocked() {
+        DetailedStatistics statistics{};
+        statistics.memoryTypes.resize(memoryProperties.memoryTypeCount);
+        statistics.memoryHeaps.resize(memoryProperties.memoryHeapCount);
+
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            statistics.memoryTypes[i].allocationCount = allocationCounts[i];
+            statistics.memoryTypes[i].usedBytes = usedBytes[i];
+        }
+        for (const auto& block : blocks) {
+            if (block != nullptr) {
+                AddBlock(statistics.memoryTypes[block->pool / 2], block->size, block->allocator.get());
+            }
+        }
+
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            ComputeFragmentation(statistics.memoryTypes[i]);
+            AddStatistics(statistics.memoryHeaps[memoryProperties.memoryTypes[i].heapIndex], statistics.memoryTypes[i]);
+            AddStatistics(statistics.total, statistics.memoryTypes[i]);
+        }
+        for (auto& heap : statistics.memoryHeaps) {
+            ComputeFragmentation(heap);
+        }
+        ComputeFragmentation(statistics.total);
+
+        statistics.budgets = GetHeapBudgetsLocked(statistics.memoryHeaps);
+        statistics.budgetFromDriver = static_cast<bool>(functions.queryBudget);
+        return statistics;
+    }
+
+    std::vector<VulkanMemoryAllocator::HeapBudget> VulkanMemoryAllocator::GetHeapBudgetsLocked(
+        const std::vector<Statistics>& heapStatistics) const {
+        std::vector<HeapBudget> budgets(memoryProperties.memoryHeapCount);
+
+        VkDeviceSize heapUsage[VK_MAX_MEMORY_HEAPS]{};
+        VkDeviceSize heapBudget[VK_MAX_MEMORY_HEAPS]{};
+        if (functions.queryBudget) {
+            functions.queryBudget(heapUsage, heapBudget);
+        }
+
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+            budgets[i].size = memoryProperties.memoryHeaps[i].size;
+            if (functions.queryBudget) {
+                budgets[i].usage = heapUsage[i];
+                budgets[i].budget = heapBudget[i];
+            }
+            else {
+                // Other processes and allocations made outside this allocator are invisible here
+                budgets[i].usage = heapStatistics[i].allocatedBytes;
+                budgets[i].budget = static_cast<VkDeviceSize>(budgets[i].size * ESTIMATED_BUDGET_FRACTION);
+            }
+        }
+        return budgets;
+    }
+
+    uint32_t VulkanMemoryAllocator::FindMemoryTypeOrNone(
+        uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferredProperties) const {
+        // Host memory that didn't ask for device local stays out of the device local heap, it is small on most
+        // discrete GPUs and reads from it are uncached
+        bool avoidDeviceLocal = (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+            && !((properties | preferredProperties) & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        uint32_t best = NONE;
+        int bestScore = 0;
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
+            if (!(typeFilter & (1u << i)) || (flags & properties) != properties) {
+                continue;
+            }
+
+            int score = 2 * static_cast<int>(std::bitset<32>(flags & preferredProperties).count());
+            if (avoidDeviceLocal && (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+                score -= 1;
+            }
+            if (best == NONE || score > bestScore) {
+                best = i;
+                bestScore = score;
+            }
+        }
+        return best;
+    }
+
+    bool VulkanMemoryAllocator::TryAllocate(
+        uint32_t memoryTypeIndex, const VkMemoryRequirements& requirements, ResourceKind kind, Allocation& allocation) {
+        VkDeviceSize size = requirements.size;
+        VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+
+        // Flushes have to start and end on atom boundaries, so mappable allocations never share an atom
+        if (GetMemoryTypeFlags(memoryTypeIndex) & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            alignment = std::max(alignment, nonCoherentAtomSize);
+            size = AlignUp(size, nonCoherentAtomSize);
+        }
+
+        VkDeviceSize blockSize = GetBlockSize(memoryTypeIndex);
+        if (size > blockSize / 2) {
+            return AllocateDedicated(memoryTypeIndex, size, allocation);
+        }
+
+        uint32_t pool = GetPool(memoryTypeIndex, kind);
+        uint32_t blockIndex = NONE;
+        uint64_t offset = TlsfAllocator::INVALID_OFFSET;
+        for (uint32_t candidate : pools[pool]) {
+            offset = blocks[candidate]->allocator->Allocate(size, alignment);
+            if (offset != TlsfAllocator::INVALID_OFFSET) {
+                blockIndex = candidate;
+                break;
+            }
+        }
+
+        if (blockIndex == NONE) {
+            blockIndex = CreateBlock(blockSize, pool);
+            if (blockIndex == NONE) {
+                // The heap may not fit another whole block but still fit this resource
+                return AllocateDedicated(memoryTypeIndex, size, allocation);
+            }
+            offset = blocks[blockIndex]->allocator->Allocate(size, alignment);
+            assert(offset != TlsfAllocator::INVALID_OFFSET && "new block too small for its first allocation");
+        }
+
+        allocation.memory = blocks[blockIndex]->memory;
+        allocation.offset = offset;
+        allocation.size = size;
+        allocation.memoryTypeIndex = memoryTypeIndex;
+        allocation.dedicated = false;
+        allocation.block = blockIndex;
+        return true;
+    }
+
+    bool VulkanMemoryAllocator::AllocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size, Allocation& allocation) {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        if (functions.allocate(memoryTypeIndex, size, memory) != VK_SUCCESS) {
+            return false;
+        }
+
+        auto block = std::make_unique<Block>();
+        block->memory = memory;
+        block->size = size;
+        block->pool = memoryTypeIndex * 2;
+
+        uint32_t blockIndex;
+        if (!unusedBlocks.empty()) {
+            blockIndex = unusedBlocks.back();
+            unusedBlocks.pop_back();
+            blocks[blockIndex] = std::move(block);
+        }
+        else {
+            blockIndex = static_cast<uint32_t>(blocks.size());
+            blocks.push_back(std::move(block));
+        }
+
+        allocation.memory = memory;
+        allocation.offset = 0;
+        allocation.size = size;
+        allocation.memoryTypeIndex = memoryTypeIndex;
+        allocation.dedicated = true;
+        allocation.block = blockIndex;
+        return true;
+    }
+
+    uint32_t VulkanMemoryAllocator::CreateBlock(VkDeviceSize size, uint32_t pool) {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        if (functions.allocate(pool / 2, size, memory) != VK_SUCCESS) {
+            return NONE;
+        }
+
+        auto block = std::make_unique<Block>();
+        block->memory = memory;
+        block->size = size;
+        block->pool = pool;
+        block->allocator = std::make_unique<TlsfAllocator>(size);
+
+        uint32_t blockIndex;
+        if (!unusedBlocks.empty()) {
+            blockIndex = unusedBlocks.back();
+            unusedBlocks.pop_back();
+            blocks[blockIndex] = std::move(block);
+        }
+        else {
+            blockIndex = static_cast<uint32_t>(blocks.size());
+            blocks.push_back(std::move(block));
+        }
+        pools[pool].push_back(blockIndex);
+        return blockIndex;
+    }
+
+    void VulkanMemoryAllocator::DestroyBlock(uint32_t blockIndex) {
+        Block& block = *blocks[blockIndex];
+        if (block.allocator != nullptr) {
+            auto& pool = pools[block.pool];
+            pool.erase(std::find(pool.begin(), pool.end(), blockIndex));
+        }
+        if (block.mapCount > 0) {
+            functions.unmap(block.memory);
+        }
+        functions.free(block.memory);
+
+        blocks[blockIndex].reset();
+        unusedBlocks.push_back(blockIndex);
+    }
+
+    VkDeviceSize VulkanMemoryAllocator::GetBlockSize(uint32_t memoryTypeIndex) const {
+        uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[heapIndex].size;
+        return heapSize <= SMALL_HEAP_SIZE ? heapSize / 8 : DEFAULT_BLOCK_SIZE;
+    }
+
+    uint32_t VulkanMemoryAllocator::GetPool(uint32_t memoryTypeIndex, ResourceKind kind) const {
+        // With a granularity of 1 buffers and images can sit next to each other anywhere
+        uint32_t kindIndex = bufferImageGranularity > 1 ? static_cast<uint32_t>(kind) : 0;
+        return memoryTypeIndex * 2 + kindIndex;
+    }
+
+}  // namespace lve
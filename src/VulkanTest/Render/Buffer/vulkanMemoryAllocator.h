@@ -0,0 +1,161 @@
+#pragma once
+
+#include "tlsfAllocator.h"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+    /*
+     * Places buffers and images in large VkDeviceMemory blocks instead of calling vkAllocateMemory per resource,
+     * so small buffers are cheap and the app stays far below maxMemoryAllocationCount.
+     * Each memory type gets its own blocks, carved up by a TlsfAllocator. Resources larger than half a block
+     * get a dedicated allocation. When bufferImageGranularity is above 1, buffers and optimal tiling images are
+     * kept in separate blocks so they never share a granularity page.
+     * The device calls go through MemoryFunctions, so the placement logic can be tested with a fake memory
+     * properties table and no GPU. Thread safe.
+     */
+    class VulkanMemoryAllocator {
+    public:
+        enum class ResourceKind : uint32_t {
+            Linear,  // Buffers and linear tiling images
+            Optimal  // Optimal tiling images
+        };
+
+        // Bind the resource to memory at offset, memory is shared with other allocations unless dedicated
+        struct Allocation {
+            VkDeviceMemory memory{VK_NULL_HANDLE};
+            VkDeviceSize offset{0};
+            VkDeviceSize size{0};
+            uint32_t memoryTypeIndex{0};
+            bool dedicated{false};
+            uint32_t block{UINT32_MAX};
+        };
+
+        struct Statistics {
+            uint32_t blockCount{0};       // Shared blocks
+            uint32_t dedicatedCount{0};
+            uint32_t allocationCount{0};  // Including dedicated ones
+            VkDeviceSize allocatedBytes{0}; // Every VkDeviceMemory together
+            VkDeviceSize usedBytes{0};      // Handed out to resources
+            VkDeviceSize freeBytes{0};      // Unused space inside shared blocks
+            VkDeviceSize largestFreeBlock{0};
+            // 1 - largestFreeBlock / freeBytes, 0 while the free space of every block is in one piece
+            float fragmentation{0.f};
+        };
+
+        struct HeapBudget {
+            VkDeviceSize size{0};
+            // Whole process when read from VK_EXT_memory_budget, otherwise only what this allocator holds
+            VkDeviceSize usage{0};
+            // How much the process can allocate before the driver starts evicting or failing
+            VkDeviceSize budget{0};
+        };
+
+        struct DetailedStatistics {
+            Statistics total{};
+            std::vector<Statistics> memoryTypes{};
+            std::vector<Statistics> memoryHeaps{};
+            std::vector<HeapBudget> budgets{};
+            // False when budgets are estimated from this allocator's own blocks
+            bool budgetFromDriver{false};
+        };
+
+        // The device constructor routes these to vkAllocateMemory, vkFreeMemory, vkMapMemory and vkUnmapMemory
+        struct MemoryFunctions {
+            std::function<VkResult(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory& memory)> allocate;
+            std::function<void(VkDeviceMemory memory)> free;
+            std::function<VkResult(VkDeviceMemory memory, void** data)> map;
+            std::function<void(VkDeviceMemory memory)> unmap;
+            // Optional, fills VK_MAX_MEMORY_HEAPS usages and budgets, set when VK_EXT_memory_budget is enabled
+            std::function<void(VkDeviceSize* heapUsage, VkDeviceSize* heapBudget)> queryBudget;
+        };
+
+        static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+        // Heaps up to this size get blocks of an eighth of the heap, so a small BAR heap isn't taken by one block
+        static constexpr VkDeviceSize SMALL_HEAP_SIZE = 1024ull * 1024 * 1024;
+        // Without VK_EXT_memory_budget a heap's budget is estimated as this fraction of its size
+        static constexpr float ESTIMATED_BUDGET_FRACTION = 0.8f;
+
+        // memoryBudget needs VK_EXT_memory_budget enabled on device and VK_KHR_get_physical_device_properties2 on instance
+        VulkanMemoryAllocator(VkInstance instance, VkDevice device, VkPhysicalDevice physicalDevice, bool memoryBudget);
+        VulkanMemoryAllocator(
+            const VkPhysicalDeviceMemoryProperties& memoryProperties,
+            VkDeviceSize bufferImageGranularity,
+            VkDeviceSize nonCoherentAtomSize,
+            MemoryFunctions functions);
+        ~VulkanMemoryAllocator();
+
+        VulkanMemoryAllocator(const VulkanMemoryAllocator&) = delete;
+        VulkanMemoryAllocator& operator=(const VulkanMemoryAllocator&) = delete;
+
+        // Memory type in typeFilter with every flag of properties and as many of preferredProperties as possible,
+        // throws when there is none
+        uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferredProperties = 0) const;
+        VkMemoryPropertyFlags GetMemoryTypeFlags(uint32_t memoryTypeIndex) const;
+
+        // Tries the next matching memory type when one runs out, throws when none is left
+        Allocation Allocate(
+            const VkMemoryRequirements& requirements,
+            VkMemoryPropertyFlags properties,
+            VkMemoryPropertyFlags preferredProperties,
+            ResourceKind kind);
+        // Destroy the resource first, resets allocation
+        void Free(Allocation& allocation);
+
+        // Maps the whole block on first use, so any number of allocations in one block can be mapped at once
+        VkResult Map(const Allocation& allocation, void** data);
+        void Unmap(const Allocation& allocation);
+
+        Statistics GetStatistics();
+        DetailedStatistics GetDetailedStatistics();
+        std::vector<HeapBudget> GetHeapBudgets();
+        // GetDetailedStatistics as a JSON object
+        std::string GetStatisticsJson();
+
+    private:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        struct Block {
+            VkDeviceMemory memory{VK_NULL_HANDLE};
+            VkDeviceSize size{0};
+            uint32_t pool{0};
+            // Null for dedicated allocations
+            std::unique_ptr<TlsfAllocator> allocator{};
+            void* mapped{nullptr};
+            uint32_t mapCount{0};
+        };
+
+        uint32_t FindMemoryTypeOrNone(uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferredProperties) const;
+        bool TryAllocate(uint32_t memoryTypeIndex, const VkMemoryRequirements& requirements, ResourceKind kind, Allocation& allocation);
+        bool AllocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size, Allocation& allocation);
+        uint32_t CreateBlock(VkDeviceSize size, uint32_t pool);
+        void DestroyBlock(uint32_t block);
+        VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex) const;
+        uint32_t GetPool(uint32_t memoryTypeIndex, ResourceKind kind) const;
+        std::vector<HeapBudget> GetHeapBudgetsLocked(const std::vector<Statistics>& heapStatistics) const;
+        DetailedStatistics GetDetailedStatisticsLocked();
+
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        VkDeviceSize bufferImageGranularity;
+        VkDeviceSize nonCoherentAtomSize;
+        MemoryFunctions functions;
+
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Block>> blocks{};
+        std::vector<uint32_t> unusedBlocks{};
+        // Shared blocks of every memory type and resource kind, indexed by GetPool
+        std::vector<uint32_t> pools[VK_MAX_MEMORY_TYPES * 2]{};
+
+        uint32_t allocationCounts[VK_MAX_MEMORY_TYPES]{};
+        VkDeviceSize usedBytes[VK_MAX_MEMORY_TYPES]{};
+    };
+
+}  // namespace lve
@@ -0,0 +1,71 @@
+#include "vulkanStagingPool.h"
+
+namespace lve {
+
+    bool VulkanStagingPool::Block::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+        VkDeviceSize start = (used + alignment - 1) & ~(alignment - 1);
+        if (start + size > buffer->GetBufferSize()) {
+            return false;
+        }
+        offset = start;
+        used = start + size;
+        return true;
+    }
+
+    VulkanStagingPool::VulkanStagingPool(VulkanDevice& device) : device{ device } {}
+
+    VulkanStagingPool::Block VulkanStagingPool::Acquire(VkDeviceSize size) {
+        uint32_t sizeClass = GetSizeClass(size);
+
+        // A larger idle block beats allocating a new one of the right size
+        for (uint32_t i = sizeClass; i < SIZE_CLASS_COUNT; i++) {
+            if (!idleBlocks[i].empty()) {
+                Block block = std::move(idleBlocks[i].back());
+                idleBlocks[i].pop_back();
+                idleBytes -= GetClassSize(i);
+                block.used = 0;
+                statistics.blocksReused++;
+                return block;
+            }
+        }
+
+        Block block{};
+        block.sizeClass = sizeClass;
+        block.buffer = std::make_unique<VulkanBuffer>(
+            device,
+            sizeClass == OVERSIZED ? size : GetClassSize(sizeClass),
+            1,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        block.buffer->Map();
+        statistics.blocksCreated++;
+        return block;
+    }
+
+    void VulkanStagingPool::Release(Block&& block) {
+        if (block.sizeClass == OVERSIZED || idleBytes + GetClassSize(block.sizeClass) > MAX_IDLE_BYTES) {
+            block.buffer.reset();
+            statistics.blocksFreed++;
+            return;
+        }
+
+        idleBytes += GetClassSize(block.sizeClass);
+        idleBlocks[block.sizeClass].push_back(std::move(block));
+    }
+
+    VulkanStagingPool::Statistics VulkanStagingPool::GetStatistics() const {
+        Statistics current = statistics;
+        current.idleBytes = idleBytes;
+        return current;
+    }
+
+    uint32_t VulkanStagingPool::GetSizeClass(VkDeviceSize size) {
+        for (uint32_t sizeClass = 0; sizeClass < SIZE_CLASS_COUNT; sizeClass++) {
+            if (size <= GetClassSize(sizeClass)) {
+                return sizeClass;
+            }
+        }
+        return OVERSIZED;
+    }
+
+}  // namespace lve
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "vulkanBuffer.h"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+    /*
+     * Keeps persistently mapped host visible staging buffers around between uploads, so an upload doesn't
+     * create, allocate, map and free a buffer of its own. Blocks come in SIZE_CLASS_COUNT size classes, each four
+     * times the previous one. A batch of uploads acquires a block, places any number of regions in it and releases
+     * it once the fence of that batch has signaled. Idle blocks are kept up to MAX_IDLE_BYTES, uploads larger than
+     * the biggest class get a block of their own that is freed on release.
+     * Not thread safe, VulkanUploadContext only calls it with its lock held.
+     */
+    class VulkanStagingPool {
+    public:
+        static constexpr VkDeviceSize MIN_BLOCK_SIZE = 16ull * 1024 * 1024;
+        // 16, 64 and 256 MB
+        static constexpr uint32_t SIZE_CLASS_COUNT = 3;
+        static constexpr VkDeviceSize MAX_IDLE_BYTES = 256ull * 1024 * 1024;
+        static constexpr uint32_t OVERSIZED = UINT32_MAX;
+
+        struct Block {
+            std::unique_ptr<VulkanBuffer> buffer{};
+            VkDeviceSize used{0};
+            uint32_t sizeClass{OVERSIZED};
+
+            // Reserves size bytes at the next aligned offset, returns false when they don't fit
+            bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+            void* GetMappedMemory(VkDeviceSize offset) { return static_cast<char*>(buffer->GetMappedMemory()) + offset; }
+        };
+
+        struct Statistics {
+            uint64_t blocksCreated{0};
+            uint64_t blocksReused{0};
+            uint64_t blocksFreed{0};
+            VkDeviceSize idleBytes{0};
+        };
+
+        VulkanStagingPool(VulkanDevice& device);
+
+        VulkanStagingPool(const VulkanStagingPool&) = delete;
+        VulkanStagingPool& operator=(const VulkanStagingPool&) = delete;
+
+        // Empty block with at least size bytes, from the idle blocks when one is large enough
+        Block Acquire(VkDeviceSize size);
+        // Call once the device is done reading the block
+        void Release(Block&& block);
+
+        static VkDeviceSize GetClassSize(uint32_t sizeClass) { return MIN_BLOCK_SIZE << (2 * sizeClass); }
+        Statistics GetStatistics() const;
+
+    private:
+        static uint32_t GetSizeClass(VkDeviceSize size);
+
+        VulkanDevice& device;
+        std::vector<Block> idleBlocks[SIZE_CLASS_COUNT]{};
+        VkDeviceSize idleBytes{0};
+        Statistics statistics{};
+    };
+
+}  // namespace lve
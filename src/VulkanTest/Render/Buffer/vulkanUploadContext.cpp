@@ -0,0 +1,413 @@
+#include "vulkanUploadContext.h"
+
+// std
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve {
+
+    namespace {
+        // Satisfies the bufferOffset rules of vkCmdCopyBufferToImage for every color format
+        constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+    }
+
+    VulkanUploadContext::VulkanUploadContext(VulkanDevice& device) : device{ device }, stagingPool{ device } {
+        QueueFamilyIndices indices = device.findPhysicalQueueFamilies();
+        transferQueue = device.transferQueue();
+        transferCommandPool = device.getTransferCommandPool();
+        transferFamily = indices.transferFamily;
+        graphicsQueue = device.graphicsQueue();
+        graphicsFamily = indices.graphicsFamily;
+        dedicatedTransfer = indices.hasDedicatedTransfer();
+
+        if (dedicatedTransfer) {
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.queueFamilyIndex = graphicsFamily;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+            if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &acquireCommandPool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create upload acquire command pool!");
+            }
+        }
+    }
+
+    VulkanUploadContext::~VulkanUploadContext() {
+        WaitIdle();
+
+        for (VkFence fence : freeFences) {
+            vkDestroyFence(device.device(), fence, nullptr);
+        }
+        for (VkSemaphore semaphore : freeSemaphores) {
+            vkDestroySemaphore(device.device(), semaphore, nullptr);
+        }
+        if (!freeCommandBuffers.empty()) {
+            vkFreeCommandBuffers(
+                device.device(),
+                transferCommandPool,
+                static_cast<uint32_t>(freeCommandBuffers.size()),
+                freeCommandBuffers.data());
+        }
+        if (acquireCommandPool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(device.device(), acquireCommandPool, nullptr);
+        }
+    }
+
+    void VulkanUploadContext::UploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset) {
+        std::lock_guard<std::recursive_mutex> lock{ mutex };
+        if (size == 0) {
+            return;
+        }
+
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        VkDeviceSize stagingOffset = Stage(data, size, stagingBuffer);
+        CopyBuffer(stagingBuffer, dstBuffer, size, stagingOffset, dstOffset);
+        statistics.uploadedBytes += size;
+    }
+
+    void VulkanUploadContext::UploadImage(
+        VkImage image, const void* data, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t layerCount) {
+        std::lock_guard<std::recursive_mutex> lock{ mutex };
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        VkDeviceSize stagingOffset = Stage(data, size, stagingBuffer);
+        CopyBufferToImage(stagingBuffer, image, width, height, layerCount, stagingOffset);
+        statistics.uploadedBytes += size;
+    }
+
+    void VulkanUploadContext::CopyBuffer(
+        VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset) {
+        std::lock_guard<std::recursive_mutex> lock{ mutex };
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = srcOffset;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        vkCmdCopyBuffer(GetCommandBuffer(), srcBuffer, dstBuffer, 1, &copyRegion);
+        statistics.copyCount++;
+
+        if (dedicatedTransfer) {
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+            barrier.buffer = dstBuffer;
+            barrier.offset = dstOffset;
+            barrier.size = size;
+            recording.bufferOwnershipBarriers.push_back(barrier);
+        }
+    }
+
+    void VulkanUploadContext::CopyBufferToImage(
+        VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount, VkDeviceSize bufferOffset) {
+        std::lock_guard<std::recursive_mutex> lock{ mutex };
+        VkBufferImageCopy region{};
+        region.bufferOffset = bufferOffset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = layerCount;
+
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { width, height, 1 };
+
+        vkCmdCopyBufferToImage(
+            GetCommandBuffer(),
+            buffer,
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1,
+            &region);
+        statistics.copyCount++;
+
+        if (dedicatedTransfer) {
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+            barrier.image = image;
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.baseMipLevel = 0;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.baseArrayLayer = 0;
+            barrier.subresourceRange.layerCount = layerCount;
+            recording.imageOwnershipBarriers.push_back(barrier);
+        }
+    }
+
+    uint64_t VulkanUploadContext::Submit() {
+        std::lock_guard<std::recursive_mutex> lock{ mutex };
+        if (!isRecording) {
+            return nextBatchId - 1;
+        }
+
+        if (freeFences.empty()) {
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            VkFence fence;
+            if (vkCreateFence(device.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create upload fence!");
+            }
+            freeFences.push_back(fence);
+        }
+        recording.fence = freeFences.back();
+        freeFences.pop_back();
+
+        if (dedicatedTransfer) {
+            SubmitWithOwnershipTransfer();
+        }
+        else {
+            // Makes the copies visible to everything submitted to this queue afterwards,
+            // so draws don't need their own barrier or a wait on the fence
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+            vkCmdPipelineBarrier(
+                recording.commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                0,
+                1,
+                &barrier,
+                0,
+                nullptr,
+                0,
+                nullptr);
+
+            if (vkEndCommandBuffer(recording.commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to record upload command buffer!");
+            }
+
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &recording.commandBuffer;
+
+            std::lock_guard<std::mutex> queueLock{ device.getQueueMutex() };
+            if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, recording.fence) != VK_SUCCESS) {
+                throw std::runtime_error("failed to submit upload command buffer!");
+            }
+        }
+
+        uint64_t batchId = recording.id;
+        inFlight.push_back(std::move(recording));
+        recording = {};
+        isRecording = false;
+        nextBatchId++;
+        statistics.submitCount++;
+        return batchId;
+    }
+
+    void VulkanUploadContext::SubmitWithOwnershipTransfer() {
+        // Release on the transfer queue, the graphics family acquires with the same barriers
+        vkCmdPipelineBarrier(
+            recording.commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0,
+            nullptr,
+            static_cast<uint32_t>(recording.bufferOwnershipBarriers.size()),
+            recording.bufferOwnershipBarriers.data(),
+            static_cast<uint32_t>(recording.imageOwnershipBarriers.size()),
+            recording.imageOwnershipBarriers.data());
+
+        if (vkEndCommandBuffer(recording.commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record upload command buffer!");
+        }
+
+        if (freeSemaphores.empty()) {
+            VkSemaphoreCreateInfo semaphoreInfo{};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            VkSemaphore semaphore;
+            if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create upload semaphore!");
+            }
+            freeSemaphores.push_back(semaphore);
+        }
+        recording.semaphore = freeSemaphores.back();
+        freeSemaphores.pop_back();
+
+        VkSubmitInfo transferSubmitInfo{};
+        transferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        transferSubmitInfo.commandBufferCount = 1;
+        transferSubmitInfo.pCommandBuffers = &recording.commandBuffer;
+        transferSubmitInfo.signalSemaphoreCount = 1;
+        transferSubmitInfo.pSignalSemaphores = &recording.semaphore;
+
+        std::lock_guard<std::mutex> queueLock{ device.getQueueMutex() };
+        if (vkQueueSubmit(transferQueue, 1, &transferSubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit upload command buffer!");
+        }
+
+        for (auto& barrier : recording.bufferOwnershipBarriers) {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        }
+        for (auto& barrier : recording.imageOwnershipBarriers) {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        }
+
+        recording.acquireCommandBuffer = AcquireCommandBuffer(acquireCommandPool, freeAcquireCommandBuffers);
+        vkCmdPipelineBarrier(
+            recording.acquireCommandBuffer,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            0,
+            nullptr,
+            static_cast<uint32_t>(recording.bufferOwnershipBarriers.size()),
+            recording.bufferOwnershipBarriers.data(),
+            static_cast<uint32_t>(recording.imageOwnershipBarriers.size()),
+            recording.imageOwnershipBarriers.data());
+
+        if (vkEndCommandBuffer(recording.acquireCommandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record upload acquire command buffer!");
+        }
+
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkSubmitInfo acquireSubmitInfo{};
+        acquireSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        acquireSubmitInfo.waitSemaphoreCount = 1;
+        acquireSubmitInfo.pWaitSemaphores = &recording.semaphore;
+        acquireSubmitInfo.pWaitDstStageMask = &waitStage;
+        acquireSubmitInfo.commandBufferCount = 1;
+        acquireSubmitInfo.pCommandBuffers = &recording.acquireCommandBuffer;
+
+        // The fence is on the acquire so a completed batch is usable by the graphics queue
+        if (vkQueueSubmit(graphicsQueue, 1, &acquireSubmitInfo, recording.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit upload acquire command buffer!");
+        }
+    }
+
+    bool VulkanUploadContext::IsComplete(uint64_t batchId) {
+        std::lock_guard<std::recursive_mutex> lock{ mutex };
+        Collect();
+        return batchId <= completedBatchId;
+    }
+
+    void VulkanUploadContext::Wait(uint64_t batchId) {
+        std::lock_guard<std::recursive_mutex> lock{ mutex };
+        if (isRecording && batchId >= recording.id) {
+            Submit();
+        }
+
+        for (const auto& batch : inFlight) {
+            if (batch.id > batchId) {
+                break;
+            }
+            vkWaitForFences(device.device(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+        }
+        Collect();
+    }
+
+    void VulkanUploadContext::WaitIdle() {
+        std::lock_guard<std::recursive_mutex> lock{ mutex };
+        Wait(Submit());
+    }
+
+    void VulkanUploadContext::Collect() {
+        std::lock_guard<std::recursive_mutex> lock{ mutex };
+        // Batches run in submission order on one queue, so stop at the first one still running
+        size_t completed = 0;
+        while (completed < inFlight.size() && vkGetFenceStatus(device.device(), inFlight[completed].fence) == VK_SUCCESS) {
+            completedBatchId = inFlight[completed].id;
+            Recycle(inFlight[completed]);
+            completed++;
+        }
+        inFlight.erase(inFlight.begin(), inFlight.begin() + completed);
+    }
+
+    VkCommandBuffer VulkanUploadContext::GetCommandBuffer() {
+        if (isRecording) {
+            return recording.commandBuffer;
+        }
+
+        Collect();
+
+        recording.id = nextBatchId;
+        recording.commandBuffer = AcquireCommandBuffer(transferCommandPool, freeCommandBuffers);
+        isRecording = true;
+        return recording.commandBuffer;
+    }
+
+    VulkanUploadContext::Statistics VulkanUploadContext::GetStatistics() {
+        std::lock_guard<std::recursive_mutex> lock{ mutex };
+        VulkanStagingPool::Statistics stagingStatistics = stagingPool.GetStatistics();
+        Statistics current = statistics;
+        current.stagingBlocksCreated = stagingStatistics.blocksCreated;
+        current.stagingBlocksReused = stagingStatistics.blocksReused;
+        return current;
+    }
+
+    VkCommandBuffer VulkanUploadContext::AcquireCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList) {
+        if (freeList.empty()) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = pool;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers(device.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate upload command buffer!");
+            }
+            freeList.push_back(commandBuffer);
+        }
+
+        VkCommandBuffer commandBuffer = freeList.back();
+        freeList.pop_back();
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin upload command buffer!");
+        }
+        return commandBuffer;
+    }
+
+    VkDeviceSize VulkanUploadContext::Stage(const void* data, VkDeviceSize size, VkBuffer& stagingBuffer) {
+        if (isRecording && recording.stagingSize + size > MAX_BATCH_STAGING_SIZE) {
+            Submit();
+        }
+        GetCommandBuffer();
+
+        VkDeviceSize offset = 0;
+        VulkanStagingPool::Block* block = recording.stagingBlocks.empty() ? nullptr : &recording.stagingBlocks.back();
+        if (block == nullptr || !block->Allocate(size, STAGING_ALIGNMENT, offset)) {
+            recording.stagingBlocks.push_back(stagingPool.Acquire(size));
+            block = &recording.stagingBlocks.back();
+            block->Allocate(size, STAGING_ALIGNMENT, offset);
+        }
+
+        std::memcpy(block->GetMappedMemory(offset), data, static_cast<size_t>(size));
+        recording.stagingSize += size;
+
+        stagingBuffer = block->buffer->GetBuffer();
+        return offset;
+    }
+
+    void VulkanUploadContext::Recycle(Batch& batch) {
+        for (auto& block : batch.stagingBlocks) {
+            stagingPool.Release(std::move(block));
+        }
+        batch.stagingBlocks.clear();
+
+        vkResetFences(device.device(), 1, &batch.fence);
+        freeFences.push_back(batch.fence);
+        freeCommandBuffers.push_back(batch.commandBuffer);
+        if (batch.acquireCommandBuffer != VK_NULL_HANDLE) {
+            freeAcquireCommandBuffers.push_back(batch.acquireCommandBuffer);
+            freeSemaphores.push_back(batch.semaphore);
+        }
+    }
+
+}  // namespace lve
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "vulkanBuffer.h"
+#include "vulkanStagingPool.h"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+    /*
+     * Records buffer and image uploads into one command buffer and submits them together.
+     * Data handed to Upload* is copied into persistently mapped staging blocks from a VulkanStagingPool right away,
+     * so the caller can free its copy as soon as the call returns. A batch is submitted with a fence on Submit (or once
+     * it holds MAX_BATCH_STAGING_SIZE bytes) and Collect hands its staging blocks back to the pool and recycles its
+     * command buffer after that fence signals. Commands submitted to the graphics queue after Submit see the uploaded data.
+     *
+     * With a dedicated transfer queue family the copies run on the transfer queue, every destination is released
+     * to the graphics family at the end of the batch and acquired again by a small command buffer on the graphics
+     * queue that waits on a semaphore, so the graphics queue never waits on the CPU. Without one everything
+     * is recorded straight onto the graphics queue.
+     *
+     * Every call locks the context, so any thread may record into it. Recording threads share the batch,
+     * whoever calls Submit sends the uploads of all of them.
+     */
+    class VulkanUploadContext {
+    public:
+        // Submit early instead of letting one batch hold on to an unbounded amount of staging memory
+        static constexpr VkDeviceSize MAX_BATCH_STAGING_SIZE = 256ull * 1024 * 1024;
+
+        struct Statistics {
+            uint64_t submitCount{0};
+            uint64_t copyCount{0};
+            uint64_t uploadedBytes{0};
+            uint64_t stagingBlocksCreated{0};
+            uint64_t stagingBlocksReused{0};
+        };
+
+        VulkanUploadContext(VulkanDevice& device);
+        ~VulkanUploadContext();
+
+        VulkanUploadContext(const VulkanUploadContext&) = delete;
+        VulkanUploadContext& operator=(const VulkanUploadContext&) = delete;
+
+        // Stages size bytes of data and records a copy into dstBuffer at dstOffset
+        void UploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+        // Stages data and records a copy into mip 0 of image, which has to be in TRANSFER_DST_OPTIMAL when the batch runs
+        void UploadImage(VkImage image, const void* data, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t layerCount);
+
+        // Same as above but from a buffer the caller keeps alive until the batch has completed
+        void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+        void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount, VkDeviceSize bufferOffset = 0);
+
+        // Submits everything recorded since the last Submit with one vkQueueSubmit and returns its batch id,
+        // returns the id of the last submitted batch when nothing was recorded
+        uint64_t Submit();
+        bool IsComplete(uint64_t batchId);
+        // Blocks until batchId and every batch before it have completed
+        void Wait(uint64_t batchId);
+        // Submits and waits for everything recorded so far
+        void WaitIdle();
+        // Recycles the staging memory and command buffers of completed batches, never blocks
+        void Collect();
+
+        Statistics GetStatistics();
+
+    private:
+        struct Batch {
+            uint64_t id{0};
+            VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+            VkFence fence{VK_NULL_HANDLE};
+            // Only used with a dedicated transfer family
+            VkCommandBuffer acquireCommandBuffer{VK_NULL_HANDLE};
+            VkSemaphore semaphore{VK_NULL_HANDLE};
+            std::vector<VkBufferMemoryBarrier> bufferOwnershipBarriers{};
+            std::vector<VkImageMemoryBarrier> imageOwnershipBarriers{};
+            std::vector<VulkanStagingPool::Block> stagingBlocks{};
+            VkDeviceSize stagingSize{0};
+        };
+
+        // Returns the command buffer of the batch being recorded, starting one when needed
+        VkCommandBuffer GetCommandBuffer();
+        // Reserves size bytes in the staging memory of the recording batch and copies data into it
+        VkDeviceSize Stage(const void* data, VkDeviceSize size, VkBuffer& stagingBuffer);
+        VkCommandBuffer AcquireCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList);
+        // Releases the batch destinations on the transfer queue and acquires them on the graphics queue
+        void SubmitWithOwnershipTransfer();
+        void Recycle(Batch& batch);
+
+        VulkanDevice& device;
+        VkQueue transferQueue;
+        VkCommandPool transferCommandPool;
+        uint32_t transferFamily;
+        VkQueue graphicsQueue;
+        // Own pool so acquires never touch the pool the frame command buffers come from
+        VkCommandPool acquireCommandPool{VK_NULL_HANDLE};
+        uint32_t graphicsFamily;
+        bool dedicatedTransfer;
+
+        // Recursive because the public calls build on each other
+        std::recursive_mutex mutex;
+
+        Batch recording{};
+        bool isRecording{false};
+        std::vector<Batch> inFlight{};
+
+        VulkanStagingPool stagingPool;
+        std::vector<VkCommandBuffer> freeCommandBuffers{};
+        std::vector<VkCommandBuffer> freeAcquireCommandBuffers{};
+        std::vector<VkFence> freeFences{};
+        std::vector<VkSemaphore> freeSemaphores{};
+
+        uint64_t nextBatchId{1};
+        uint64_t completedBatchId{0};
+        Statistics statistics{};
+    };
+
+}  // namespace lve
@@ -0,0 +1,157 @@
+#include "frustumCuller.h"
+
+#include <cmath>
+
+#if defined(LVE_CULL_AVX)
+#include <immintrin.h>
+#elif defined(LVE_CULL_SSE)
+#include <emmintrin.h>
+#endif
+
+namespace lve {
+
+	void FrustumCuller::Reserve(uint32_t boxCount) {
+		for (auto* component : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ }) {
+			component->reserve(boxCount);
+		}
+	}
+
+	void FrustumCuller::Clear() {
+		for (auto* component : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ }) {
+			component->clear();
+		}
+	}
+
+	uint32_t FrustumCuller::Add(const glm::vec3& center, const glm::vec3& extent) {
+		centerX.push_back(center.x);
+		centerY.push_back(center.y);
+		centerZ.push_back(center.z);
+		extentX.push_back(extent.x);
+		extentY.push_back(extent.y);
+		extentZ.push_back(extent.z);
+		return static_cast<uint32_t>(centerX.size() - 1);
+	}
+
+	uint32_t FrustumCuller::Add(const glm::mat4& modelMatrix, const glm::vec3& minBounds, const glm::vec3& maxBounds) {
+		glm::vec3 center = (minBounds + maxBounds) * 0.5f;
+		glm::vec3 extent = (maxBounds - minBounds) * 0.5f;
+
+		// Each world axis gets the extents projected through the absolute values of its matrix row
+		glm::vec3 worldCenter = glm::vec3(modelMatrix * glm::vec4(center, 1.f));
+		glm::vec3 worldExtent{0.f};
+		for (int column = 0; column < 3; column++) {
+			for (int row = 0; row < 3; row++) {
+				worldExtent[row] += std::abs(modelMatrix[column][row]) * extent[column];
+			}
+		}
+		return Add(worldCenter, worldExtent);
+	}
+
+	void FrustumCuller::Cull(const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& visible) const {
+		visible.clear();
+		uint32_t boxCount = GetBoxCount();
+		// Boxes from batchEnd on, all of them without SIMD, go through the scalar test
+		uint32_t batchEnd = 0;
+
+#if defined(LVE_CULL_AVX)
+		__m256 normalX[6], normalY[6], normalZ[6], distance[6], absX[6], absY[6], absZ[6];
+		for (int p = 0; p < 6; p++) {
+			normalX[p] = _mm256_set1_ps(planes[p].x);
+			normalY[p] = _mm256_set1_ps(planes[p].y);
+			normalZ[p] = _mm256_set1_ps(planes[p].z);
+			distance[p] = _mm256_set1_ps(planes[p].w);
+			absX[p] = _mm256_set1_ps(std::abs(planes[p].x));
+			absY[p] = _mm256_set1_ps(std::abs(planes[p].y));
+			absZ[p] = _mm256_set1_ps(std::abs(planes[p].z));
+		}
+		const __m256 zero = _mm256_setzero_ps();
+		batchEnd = boxCount - boxCount % LANE_COUNT;
+
+		for (uint32_t i = 0; i < batchEnd; i += LANE_COUNT) {
+			__m256 cx = _mm256_loadu_ps(&centerX[i]);
+			__m256 cy = _mm256_loadu_ps(&centerY[i]);
+			__m256 cz = _mm256_loadu_ps(&centerZ[i]);
+			__m256 ex = _mm256_loadu_ps(&extentX[i]);
+			__m256 ey = _mm256_loadu_ps(&extentY[i]);
+			__m256 ez = _mm256_loadu_ps(&extentZ[i]);
+
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int p = 0; p < 6; p++) {
+				__m256 centerDistance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+					_mm256_mul_ps(cx, normalX[p]), _mm256_mul_ps(cy, normalY[p])), _mm256_mul_ps(cz, normalZ[p])), distance[p]);
+				__m256 radius = _mm256_add_ps(_mm256_add_ps(
+					_mm256_mul_ps(ex, absX[p]), _mm256_mul_ps(ey, absY[p])), _mm256_mul_ps(ez, absZ[p]));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(centerDistance, radius), zero, _CMP_GE_OQ));
+			}
+
+			int mask = _mm256_movemask_ps(inside);
+			for (uint32_t lane = 0; mask != 0; lane++, mask >>= 1) {
+				if (mask & 1) {
+					visible.push_back(i + lane);
+				}
+			}
+		}
+#elif defined(LVE_CULL_SSE)
+		__m128 normalX[6], normalY[6], normalZ[6], distance[6], absX[6], absY[6], absZ[6];
+		for (int p = 0; p < 6; p++) {
+			normalX[p] = _mm_set1_ps(planes[p].x);
+			normalY[p] = _mm_set1_ps(planes[p].y);
+			normalZ[p] = _mm_set1_ps(planes[p].z);
+			distance[p] = _mm_set1_ps(planes[p].w);
+			absX[p] = _mm_set1_ps(std::abs(planes[p].x));
+			absY[p] = _mm_set1_ps(std::abs(planes[p].y));
+			absZ[p] = _mm_set1_ps(std::abs(planes[p].z));
+		}
+		const __m128 zero = _mm_setzero_ps();
+		batchEnd = boxCount - boxCount % LANE_COUNT;
+
+		for (uint32_t i = 0; i < batchEnd; i += LANE_COUNT) {
+			__m128 cx = _mm_loadu_ps(&centerX[i]);
+			__m128 cy = _mm_loadu_ps(&centerY[i]);
+			__m128 cz = _mm_loadu_ps(&centerZ[i]);
+			__m128 ex = _mm_loadu_ps(&extentX[i]);
+			__m128 ey = _mm_loadu_ps(&extentY[i]);
+			__m128 ez = _mm_loadu_ps(&extentZ[i]);
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < 6; p++) {
+				__m128 centerDistance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(cx, normalX[p]), _mm_mul_ps(cy, normalY[p])), _mm_mul_ps(cz, normalZ[p])), distance[p]);
+				__m128 radius = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(ex, absX[p]), _mm_mul_ps(ey, absY[p])), _mm_mul_ps(ez, absZ[p]));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(centerDistance, radius), zero));
+			}
+
+			int mask = _mm_movemask_ps(inside);
+			for (uint32_t lane = 0; mask != 0; lane++, mask >>= 1) {
+				if (mask & 1) {
+					visible.push_back(i + lane);
+				}
+			}
+		}
+#endif
+
+		CullRange(planes, batchEnd, boxCount, visible);
+	}
+
+	void FrustumCuller::CullScalar(const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& visible) const {
+		visible.clear();
+		CullRange(planes, 0, GetBoxCount(), visible);
+	}
+
+	void FrustumCuller::CullRange(const std::array<glm::vec4, 6>& planes, uint32_t first, uint32_t last, std::vector<uint32_t>& visible) const {
+		for (uint32_t i = first; i < last; i++) {
+			bool inside = true;
+			// Same operation order as the SIMD paths so both agree on boxes touching a plane
+			for (int p = 0; p < 6 && inside; p++) {
+				const glm::vec4& plane = planes[p];
+				float centerDistance = centerX[i] * plane.x + centerY[i] * plane.y + centerZ[i] * plane.z + plane.w;
+				float radius = extentX[i] * std::abs(plane.x) + extentY[i] * std::abs(plane.y) + extentZ[i] * std::abs(plane.z);
+				inside = centerDistance + radius >= 0.f;
+			}
+			if (inside) {
+				visible.push_back(i);
+			}
+		}
+	}
+}
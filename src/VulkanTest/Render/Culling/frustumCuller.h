@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Widest instruction set the compiler targets, there is no runtime dispatch
+#if defined(__AVX__)
+#define LVE_CULL_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LVE_CULL_SSE 1
+#endif
+
+namespace lve {
+
+	/*
+	* Tests world space axis aligned boxes against the six camera frustum planes on the CPU.
+	* Boxes are kept as structure of arrays, one array per center and extent component, so a batch of
+	* LANE_COUNT boxes loads straight into SIMD registers. AVX tests 8 boxes at once and SSE 4, otherwise
+	* and for the boxes left over at the end it falls back to the scalar test.
+	* A box is culled when it lies fully behind any one plane, boxes crossing a corner outside the frustum stay visible.
+	*/
+	class FrustumCuller {
+	public:
+#if defined(LVE_CULL_AVX)
+		static constexpr uint32_t LANE_COUNT = 8;
+#elif defined(LVE_CULL_SSE)
+		static constexpr uint32_t LANE_COUNT = 4;
+#else
+		static constexpr uint32_t LANE_COUNT = 1;
+#endif
+
+		void Reserve(uint32_t boxCount);
+		void Clear();
+
+		// Returns the index Cull reports the box by
+		uint32_t Add(const glm::vec3& center, const glm::vec3& extent);
+		// Box around model space bounds after transforming them by modelMatrix, see Arvo's Graphics Gems method
+		uint32_t Add(const glm::mat4& modelMatrix, const glm::vec3& minBounds, const glm::vec3& maxBounds);
+
+		// Planes as returned by VulkanCamera::GetFrustumPlanes, inside is dot(normal, point) + w >= 0.
+		// Overwrites visible with the indices of the boxes touching the frustum, in ascending order
+		void Cull(const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& visible) const;
+		// One box at a time, the reference Cull has to agree with
+		void CullScalar(const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& visible) const;
+
+		uint32_t GetBoxCount() const { return static_cast<uint32_t>(centerX.size()); }
+
+	private:
+		std::vector<float> centerX{};
+		std::vector<float> centerY{};
+		std::vector<float> centerZ{};
+		std::vector<float> extentX{};
+		std::vector<float> extentY{};
+		std::vector<float> extentZ{};
+
+		void CullRange(const std::array<glm::vec4, 6>& planes, uint32_t first, uint32_t last, std::vector<uint32_t>& visible) const;
+	};
+}
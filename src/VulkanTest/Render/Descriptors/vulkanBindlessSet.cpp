@@ -0,0 +1,158 @@
+#include "vulkanBindlessSet.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+    // *************** Bindless Slot Allocator *********************
+
+    uint32_t BindlessSlotAllocator::Allocate() {
+        if (!freeSlots.empty()) {
+            uint32_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+        if (nextSlot == capacity) {
+            return INVALID_SLOT;
+        }
+        return nextSlot++;
+    }
+
+    void BindlessSlotAllocator::Retire(uint32_t slot, int frameIndex) {
+        assert(slot < nextSlot && "Retiring a slot that was never allocated");
+        retiredSlots[frameIndex].push_back(slot);
+        retiredCount++;
+    }
+
+    void BindlessSlotAllocator::BeginFrame(int frameIndex) {
+        auto& retired = retiredSlots[frameIndex];
+        freeSlots.insert(freeSlots.end(), retired.begin(), retired.end());
+        retiredCount -= static_cast<uint32_t>(retired.size());
+        retired.clear();
+    }
+
+    // *************** Bindless Set *********************
+
+    namespace {
+        uint32_t ClampToLimits(uint32_t count, uint32_t perStageLimit, uint32_t perSetLimit, uint32_t resourceLimit) {
+            return std::min({ count, perStageLimit, perSetLimit, resourceLimit });
+        }
+    }
+
+    VulkanBindlessSet::VulkanBindlessSet(VulkanDevice& device)
+        : device{ device },
+        imageSlots{ 0 },
+        storageBufferSlots{ 0 } {
+        if (!device.isDescriptorIndexingEnabled()) {
+            throw std::runtime_error("failed to create bindless set, descriptor indexing is not enabled!");
+        }
+
+        // Both arrays are visible to every stage, so each gets at most half of the per stage resource limit
+        const VkPhysicalDeviceDescriptorIndexingProperties& limits = device.getDescriptorIndexingProperties();
+        uint32_t resourceLimit = limits.maxPerStageUpdateAfterBindResources / 2;
+        uint32_t imageCount = ClampToLimits(
+            MAX_SAMPLED_IMAGES,
+            std::min(limits.maxPerStageDescriptorUpdateAfterBindSampledImages, limits.maxPerStageDescriptorUpdateAfterBindSamplers),
+            std::min(limits.maxDescriptorSetUpdateAfterBindSampledImages, limits.maxDescriptorSetUpdateAfterBindSamplers),
+            resourceLimit);
+        uint32_t storageBufferCount = ClampToLimits(
+            MAX_STORAGE_BUFFERS,
+            limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+            limits.maxDescriptorSetUpdateAfterBindStorageBuffers,
+            resourceLimit);
+        imageSlots = BindlessSlotAllocator{ imageCount };
+        storageBufferSlots = BindlessSlotAllocator{ storageBufferCount };
+
+        VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+        if (device.getDescriptorIndexingFeatures().descriptorBindingUpdateUnusedWhilePending) {
+            bindingFlags |= VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        }
+        VkShaderStageFlags stages = VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT;
+
+        setLayout = VulkanDescriptorSetLayout::Builder(device)
+            .addBinding(SAMPLED_IMAGE_BINDING, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, stages, imageCount)
+            .addBinding(STORAGE_BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages, storageBufferCount)
+            .setBindingFlags(SAMPLED_IMAGE_BINDING, bindingFlags)
+            .setBindingFlags(STORAGE_BUFFER_BINDING, bindingFlags)
+            .setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
+            .build();
+
+        pool = LveDescriptorPool::Builder(device)
+            .setMaxSets(1)
+            .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageCount)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBufferCount)
+            .build();
+
+        if (!pool->allocateDescriptor(setLayout->getDescriptorSetLayout(), descriptorSet)) {
+            throw std::runtime_error("failed to allocate bindless descriptor set!");
+        }
+    }
+
+    uint32_t VulkanBindlessSet::AddImage(VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout) {
+        std::lock_guard<std::mutex> lock{ mutex };
+        uint32_t slot = imageSlots.Allocate();
+        if (slot != INVALID_SLOT) {
+            VkDescriptorImageInfo imageInfo{ sampler, imageView, imageLayout };
+            WriteSlot(SAMPLED_IMAGE_BINDING, slot, &imageInfo, nullptr);
+        }
+        return slot;
+    }
+
+    uint32_t VulkanBindlessSet::AddStorageBuffer(const VkDescriptorBufferInfo& bufferInfo) {
+        std::lock_guard<std::mutex> lock{ mutex };
+        uint32_t slot = storageBufferSlots.Allocate();
+        if (slot != INVALID_SLOT) {
+            WriteSlot(STORAGE_BUFFER_BINDING, slot, nullptr, &bufferInfo);
+        }
+        return slot;
+    }
+
+    void VulkanBindlessSet::RetireImage(uint32_t slot) {
+        std::lock_guard<std::mutex> lock{ mutex };
+        imageSlots.Retire(slot, frameIndex);
+    }
+
+    void VulkanBindlessSet::RetireStorageBuffer(uint32_t slot) {
+        std::lock_guard<std::mutex> lock{ mutex };
+        storageBufferSlots.Retire(slot, frameIndex);
+    }
+
+    void VulkanBindlessSet::BeginFrame(int frameIndex) {
+        std::lock_guard<std::mutex> lock{ mutex };
+        this->frameIndex = frameIndex;
+        imageSlots.BeginFrame(frameIndex);
+        storageBufferSlots.BeginFrame(frameIndex);
+    }
+
+    VulkanBindlessSet::Statistics VulkanBindlessSet::GetStatistics() {
+        std::lock_guard<std::mutex> lock{ mutex };
+        Statistics statistics{};
+        statistics.imageSlotsUsed = imageSlots.GetUsedCount();
+        statistics.imageSlotCapacity = imageSlots.GetCapacity();
+        statistics.storageBufferSlotsUsed = storageBufferSlots.GetUsedCount();
+        statistics.storageBufferSlotCapacity = storageBufferSlots.GetCapacity();
+        statistics.retiredSlots = imageSlots.GetRetiredCount() + storageBufferSlots.GetRetiredCount();
+        return statistics;
+    }
+
+    void VulkanBindlessSet::WriteSlot(
+        uint32_t binding, uint32_t slot, const VkDescriptorImageInfo* imageInfo, const VkDescriptorBufferInfo* bufferInfo) {
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = descriptorSet;
+        write.dstBinding = binding;
+        write.dstArrayElement = slot;
+        write.descriptorCount = 1;
+        write.descriptorType = imageInfo != nullptr ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pImageInfo = imageInfo;
+        write.pBufferInfo = bufferInfo;
+
+        // Update after bind lets this run while the set is bound, the slot itself is not read by any pending frame
+        vkUpdateDescriptorSets(device.device(), 1, &write, 0, nullptr);
+    }
+
+}  // namespace lve
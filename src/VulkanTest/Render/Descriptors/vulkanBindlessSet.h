@@ -0,0 +1,108 @@
+#pragma once
+
+#include "vulkanDescriptor.h"
+#include "../SwapChain/vulkanSwapChain.h"
+
+// std
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+    /*
+     * Hands out stable indices into one descriptor array. A retired slot may still be read by frames in flight,
+     * so it only becomes free again once the frame it was retired in comes around, at which point that frame's
+     * fence has signaled and so have the fences of every frame submitted before it.
+     * Not thread safe, VulkanBindlessSet calls it with its lock held.
+     */
+    class BindlessSlotAllocator {
+    public:
+        static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+        explicit BindlessSlotAllocator(uint32_t capacity) : capacity{ capacity } {}
+
+        // INVALID_SLOT when every slot is taken or still retired
+        uint32_t Allocate();
+        void Retire(uint32_t slot, int frameIndex);
+        // Frees the slots retired the last time frameIndex was recorded
+        void BeginFrame(int frameIndex);
+
+        uint32_t GetCapacity() const { return capacity; }
+        uint32_t GetUsedCount() const { return nextSlot - static_cast<uint32_t>(freeSlots.size()) - retiredCount; }
+        uint32_t GetRetiredCount() const { return retiredCount; }
+
+    private:
+        uint32_t capacity;
+        // Slots below nextSlot have been handed out at least once, the free ones among them are in freeSlots
+        uint32_t nextSlot{ 0 };
+        std::vector<uint32_t> freeSlots{};
+        std::array<std::vector<uint32_t>, vulkanSwapChain::MAX_FRAMES_IN_FLIGHT> retiredSlots{};
+        uint32_t retiredCount{ 0 };
+    };
+
+    /*
+     * One large descriptor set for VK_EXT_descriptor_indexing, bound once and indexed by shaders instead of binding
+     * a set per material. Binding 0 is an array of combined image samplers, binding 1 an array of storage buffers.
+     * Both are update after bind and partially bound, so slots can be written while the set is bound in command
+     * buffers that are still recording, and unwritten slots are fine as long as no shader reads them.
+     * Shaders declare the set through ShaderFolder/bindless.glsl and index it with the ids this returns,
+     * for example an ObjectData materialIndex. Add and Retire are safe to call from several threads.
+     * Whatever a slot points at has to stay alive until the slot was retired and its frame came around again.
+     * vulkanApp creates one when BINDLESS_DESCRIPTORS is on and calls BeginFrame every frame.
+     */
+    class VulkanBindlessSet {
+    public:
+        static constexpr uint32_t SAMPLED_IMAGE_BINDING = 0;
+        static constexpr uint32_t STORAGE_BUFFER_BINDING = 1;
+        // Upper bounds, the device limits for update after bind descriptors can lower them
+        static constexpr uint32_t MAX_SAMPLED_IMAGES = 16384;
+        static constexpr uint32_t MAX_STORAGE_BUFFERS = 16384;
+        static constexpr uint32_t INVALID_SLOT = BindlessSlotAllocator::INVALID_SLOT;
+
+        struct Statistics {
+            uint32_t imageSlotsUsed{ 0 };
+            uint32_t imageSlotCapacity{ 0 };
+            uint32_t storageBufferSlotsUsed{ 0 };
+            uint32_t storageBufferSlotCapacity{ 0 };
+            // Waiting for the frames that may still read them
+            uint32_t retiredSlots{ 0 };
+        };
+
+        // Throws when the device has no descriptor indexing, check VulkanDevice::isDescriptorIndexingEnabled first
+        explicit VulkanBindlessSet(VulkanDevice& device);
+
+        VulkanBindlessSet(const VulkanBindlessSet&) = delete;
+        VulkanBindlessSet& operator=(const VulkanBindlessSet&) = delete;
+
+        // Write the descriptor into a free slot and return its index, INVALID_SLOT when the array is full
+        uint32_t AddImage(VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        uint32_t AddStorageBuffer(const VkDescriptorBufferInfo& bufferInfo);
+        // The slot must no longer be used by frames recorded from now on
+        void RetireImage(uint32_t slot);
+        void RetireStorageBuffer(uint32_t slot);
+
+        // Call once BeginFrame of the renderer waited for frameIndex's fence
+        void BeginFrame(int frameIndex);
+
+        VkDescriptorSetLayout GetDescriptorSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+        VkDescriptorSet GetDescriptorSet() const { return descriptorSet; }
+        Statistics GetStatistics();
+
+    private:
+        void WriteSlot(uint32_t binding, uint32_t slot, const VkDescriptorImageInfo* imageInfo, const VkDescriptorBufferInfo* bufferInfo);
+
+        VulkanDevice& device;
+        std::unique_ptr<VulkanDescriptorSetLayout> setLayout;
+        std::unique_ptr<LveDescriptorPool> pool;
+        VkDescriptorSet descriptorSet{ VK_NULL_HANDLE };
+
+        std::mutex mutex;
+        BindlessSlotAllocator imageSlots;
+        BindlessSlotAllocator storageBufferSlots;
+        int frameIndex{ 0 };
+    };
+
+}  // namespace lve
@@ -20,15 +20,23 @@ namespace lve {
                 VkDescriptorType descriptorType,
                 VkShaderStageFlags stageFlags,
                 uint32_t count = 1);
+            // VkDescriptorBindingFlags of an added binding, needs VK_EXT_descriptor_indexing
+            Builder& setBindingFlags(uint32_t binding, VkDescriptorBindingFlags flags);
+            Builder& setLayoutFlags(VkDescriptorSetLayoutCreateFlags flags);
             std::unique_ptr<VulkanDescriptorSetLayout> build() const;
 
         private:
             VulkanDevice& VulkanDevice;
             std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+            std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags{};
+            VkDescriptorSetLayoutCreateFlags layoutFlags = 0;
         };
 
         VulkanDescriptorSetLayout(
-            VulkanDevice& VulkanDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+            VulkanDevice& VulkanDevice,
+            std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+            const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& bindingFlags = {},
+            VkDescriptorSetLayoutCreateFlags layoutFlags = 0);
         ~VulkanDescriptorSetLayout();
         VulkanDescriptorSetLayout(const VulkanDescriptorSetLayout&) = delete;
         VulkanDescriptorSetLayout& operator=(const VulkanDescriptorSetLayout&) = delete;
@@ -0,0 +1,91 @@
+#include "geometryArena.h"
+
+namespace lve {
+
+	GeometryArena::GeometryArena(VulkanDevice& device, VertexLayout vertexLayout, uint32_t vertexCapacity, uint32_t indexCapacity, uint32_t shortIndexCapacity)
+		: vertexLayout{ vertexLayout }, vertexAllocator{ vertexCapacity }, indexAllocator{ indexCapacity }, shortIndexAllocator{ shortIndexCapacity } {
+
+		vertexBuffer = std::make_unique<VulkanBuffer>
+			(
+				device,
+				VulkanModel::GetVertexStride(vertexLayout),
+				vertexCapacity,
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+
+		indexBuffer = std::make_unique<VulkanBuffer>
+			(
+				device,
+				sizeof(uint32_t),
+				indexCapacity,
+				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+
+		shortIndexBuffer = std::make_unique<VulkanBuffer>
+			(
+				device,
+				sizeof(uint16_t),
+				shortIndexCapacity,
+				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+	}
+
+	bool GeometryArena::Allocate(uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType, Allocation& allocation) {
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		uint64_t firstVertex = vertexAllocator.Allocate(vertexCount);
+		if (firstVertex == TlsfAllocator::INVALID_OFFSET) {
+			return false;
+		}
+
+		uint64_t firstIndex = 0;
+		if (indexCount > 0) {
+			firstIndex = GetIndexAllocator(indexType).Allocate(indexCount);
+			if (firstIndex == TlsfAllocator::INVALID_OFFSET) {
+				vertexAllocator.Free(firstVertex);
+				return false;
+			}
+		}
+
+		allocation.firstVertex = static_cast<uint32_t>(firstVertex);
+		allocation.vertexCount = vertexCount;
+		allocation.firstIndex = static_cast<uint32_t>(firstIndex);
+		allocation.indexCount = indexCount;
+		allocation.indexType = indexType;
+		return true;
+	}
+
+	void GeometryArena::Free(const Allocation& allocation) {
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		vertexAllocator.Free(allocation.firstVertex);
+		if (allocation.indexCount > 0) {
+			GetIndexAllocator(allocation.indexType).Free(allocation.firstIndex);
+		}
+	}
+
+	void GeometryArena::Bind(VkCommandBuffer commandBuffer, VkIndexType indexType) {
+		VkBuffer buffers[] = { vertexBuffer->GetBuffer() };
+		VkDeviceSize offsets[] = { 0 };
+
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, GetIndexBuffer(indexType).GetBuffer(), 0, indexType);
+	}
+
+	GeometryArena::Statistics GeometryArena::GetStatistics() {
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		Statistics statistics{};
+		statistics.allocationCount = vertexAllocator.GetAllocationCount();
+		statistics.usedVertices = vertexAllocator.GetUsedSize();
+		statistics.vertexCapacity = vertexAllocator.GetSize();
+		statistics.usedIndices = indexAllocator.GetUsedSize();
+		statistics.indexCapacity = indexAllocator.GetSize();
+		statistics.usedShortIndices = shortIndexAllocator.GetUsedSize();
+		statistics.shortIndexCapacity = shortIndexAllocator.GetSize();
+		return statistics;
+	}
+}
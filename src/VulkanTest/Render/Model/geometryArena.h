@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "vulkanModel.h"
+#include "../Buffer/tlsfAllocator.h"
+
+namespace lve {
+
+	/*
+	* One device local vertex buffer plus a 32 bit and a 16 bit index buffer shared by every model of a vertex layout.
+	* Models get a range of the vertex buffer and of the index buffer of their index type through TLSF allocators and
+	* draw with firstIndex and vertexOffset, so consecutive objects of one index type need no rebinding and can go
+	* through one indirect draw. 16 bit meshes keep their halved index size instead of being widened.
+	* Ranges are counted in vertices and indices, not bytes. Allocate and Free are safe to call from several threads.
+	*/
+	class GeometryArena {
+	public:
+		struct Allocation {
+			uint32_t firstVertex{0};
+			uint32_t vertexCount{0};
+			uint32_t firstIndex{0};
+			uint32_t indexCount{0};
+			VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+		};
+
+		struct Statistics {
+			uint32_t allocationCount{0};
+			uint64_t usedVertices{0};
+			uint64_t vertexCapacity{0};
+			uint64_t usedIndices{0};
+			uint64_t indexCapacity{0};
+			uint64_t usedShortIndices{0};
+			uint64_t shortIndexCapacity{0};
+		};
+
+		// indexCapacity is for 32 bit indices, shortIndexCapacity for 16 bit ones
+		GeometryArena(VulkanDevice& device, VertexLayout vertexLayout, uint32_t vertexCapacity, uint32_t indexCapacity, uint32_t shortIndexCapacity);
+
+		GeometryArena(const GeometryArena&) = delete;
+		GeometryArena& operator=(const GeometryArena&) = delete;
+
+		// False when either buffer has no free range large enough, allocation is left untouched then
+		bool Allocate(uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType, Allocation& allocation);
+		// The range can be handed out again right away, only free it once no frame in flight draws from it
+		void Free(const Allocation& allocation);
+
+		// Binds the vertex buffer and the index buffer of indexType
+		void Bind(VkCommandBuffer commandBuffer, VkIndexType indexType);
+
+		VertexLayout GetVertexLayout() const { return vertexLayout; }
+		VulkanBuffer& GetVertexBuffer() { return *vertexBuffer; }
+		VulkanBuffer& GetIndexBuffer(VkIndexType indexType) { return indexType == VK_INDEX_TYPE_UINT16 ? *shortIndexBuffer : *indexBuffer; }
+		Statistics GetStatistics();
+
+	private:
+		VertexLayout vertexLayout;
+
+		std::unique_ptr<VulkanBuffer> vertexBuffer;
+		std::unique_ptr<VulkanBuffer> indexBuffer;
+		std::unique_ptr<VulkanBuffer> shortIndexBuffer;
+
+		std::mutex mutex;
+		TlsfAllocator vertexAllocator;
+		TlsfAllocator indexAllocator;
+		TlsfAllocator shortIndexAllocator;
+
+		TlsfAllocator& GetIndexAllocator(VkIndexType indexType) { return indexType == VK_INDEX_TYPE_UINT16 ? shortIndexAllocator : indexAllocator; }
+	};
+}
@@ -0,0 +1,368 @@
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "meshCache.h"
+#include "../utils.h"
+
+namespace lve {
+
+	namespace {
+		constexpr uint64_t BLOB_ALIGNMENT = 16;
+
+		uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+
+		struct SourceInfo {
+			uint64_t size{0};
+			int64_t writeTime{0};
+			bool exists{false};
+		};
+
+		SourceInfo GetSourceInfo(const std::string& sourcePath) {
+			SourceInfo info{};
+			std::error_code error{};
+			info.size = std::filesystem::file_size(sourcePath, error);
+			if (error) {
+				return info;
+			}
+			auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+			if (error) {
+				return info;
+			}
+			info.writeTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+			info.exists = true;
+			return info;
+		}
+
+		// Sizes of the blobs following the header, in file order
+		struct BlobSizes {
+			uint64_t vertexBytes;
+			uint64_t indexBytes;
+			uint64_t submeshBytes;
+			uint64_t lodBytes;
+			uint64_t meshletBytes;
+			uint64_t meshletBoundsBytes;
+			uint64_t meshletVertexBytes;
+			uint64_t meshletTriangleBytes;
+		};
+
+		BlobSizes GetBlobSizes(const MeshCacheHeader& header) {
+			BlobSizes sizes{};
+			sizes.vertexBytes = static_cast<uint64_t>(header.vertexStride) * header.vertexCount;
+			sizes.indexBytes = static_cast<uint64_t>(header.indexSize) * header.indexCount;
+			sizes.submeshBytes = sizeof(VulkanModel::Submesh) * static_cast<uint64_t>(header.submeshCount);
+			sizes.lodBytes = sizeof(VulkanModel::Lod) * static_cast<uint64_t>(header.lodCount);
+			sizes.meshletBytes = sizeof(VulkanModel::Meshlet) * static_cast<uint64_t>(header.meshletCount);
+			sizes.meshletBoundsBytes = sizeof(VulkanModel::MeshletBounds) * static_cast<uint64_t>(header.meshletCount);
+			sizes.meshletVertexBytes = sizeof(uint32_t) * static_cast<uint64_t>(header.meshletVertexCount);
+			sizes.meshletTriangleBytes = header.meshletTriangleBytes;
+			return sizes;
+		}
+
+		bool BlobFits(uint64_t offset, uint64_t size, uint64_t fileSize) {
+			return offset <= fileSize && size <= fileSize - offset;
+		}
+
+		uint64_t HashSourceFile(const std::string& sourcePath) {
+			MappedFile source{sourcePath};
+			if (!source.IsOpen()) {
+				return 0;
+			}
+			return hashBytes(source.GetData(), source.GetSize());
+		}
+
+		// Unique per process and write, so streaming threads or processes writing the same cache never share a temp file
+		std::string MakeTempPath(const std::string& cachePath) {
+			static std::atomic<uint64_t> writeCounter{0};
+#ifdef _WIN32
+			unsigned long processId = GetCurrentProcessId();
+#else
+			unsigned long processId = static_cast<unsigned long>(getpid());
+#endif
+			return cachePath + "." + std::to_string(processId) + "." + std::to_string(writeCounter++) + ".tmp";
+		}
+	}
+
+	// *************** Mapped File *********************
+
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::string& filePath) {
+		HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return;
+		}
+		fileHandle = file;
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+			return;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr) {
+			return;
+		}
+		mappingHandle = mapping;
+
+		data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data != nullptr) {
+			size = static_cast<size_t>(fileSize.QuadPart);
+		}
+	}
+
+	MappedFile::~MappedFile() {
+		if (data != nullptr) {
+			UnmapViewOfFile(data);
+		}
+		if (mappingHandle != nullptr) {
+			CloseHandle(mappingHandle);
+		}
+		if (fileHandle != nullptr) {
+			CloseHandle(fileHandle);
+		}
+	}
+#else
+	MappedFile::MappedFile(const std::string& filePath) {
+		int file = open(filePath.c_str(), O_RDONLY);
+		if (file < 0) {
+			return;
+		}
+
+		struct stat fileStat{};
+		if (fstat(file, &fileStat) == 0 && fileStat.st_size > 0) {
+			void* mapping = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+			if (mapping != MAP_FAILED) {
+				data = mapping;
+				size = static_cast<size_t>(fileStat.st_size);
+			}
+		}
+
+		// The mapping keeps the file alive on its own
+		close(file);
+	}
+
+	MappedFile::~MappedFile() {
+		if (data != nullptr) {
+			munmap(const_cast<void*>(data), size);
+		}
+	}
+#endif
+
+	// *************** Mesh Cache *********************
+
+	std::string MeshCache::GetCachePath(const std::string& sourcePath, const ModelLoadSettings& settings) {
+		std::string cachePath = sourcePath;
+		cachePath += settings.vertexLayout == VertexLayout::Compact ? ".compact" : ".full";
+		cachePath += settings.optimizeMesh ? ".optimized" : "";
+		cachePath += settings.buildMeshlets ? ".meshlets" : "";
+		cachePath += settings.buildLods ? ".lods" : "";
+		return cachePath + ".meshcache";
+	}
+
+	MeshCache::MeshCache(const std::string& cachePath) : file{cachePath} {
+		if (file.IsOpen() && file.GetSize() >= sizeof(MeshCacheHeader)) {
+			header = static_cast<const MeshCacheHeader*>(file.GetData());
+		}
+	}
+
+	std::unique_ptr<MeshCache> MeshCache::Open(
+		const std::string& cachePath,
+		const std::string& sourcePath,
+		const ModelLoadSettings& settings) {
+
+		std::unique_ptr<MeshCache> cache{new MeshCache(cachePath)};
+
+		const MeshCacheHeader* header = cache->header;
+		if (header == nullptr) {
+			return nullptr;
+		}
+
+		if (header->magic != MeshCacheHeader::MAGIC ||
+			header->version != MeshCacheHeader::VERSION ||
+			header->vertexLayout != static_cast<uint32_t>(settings.vertexLayout) ||
+			header->vertexStride != VulkanModel::GetVertexStride(settings.vertexLayout) ||
+			(header->indexSize != sizeof(uint16_t) && header->indexSize != sizeof(uint32_t))) {
+			return nullptr;
+		}
+
+		if (((header->flags & MeshCacheHeader::OPTIMIZED_BIT) != 0) != settings.optimizeMesh ||
+			((header->flags & MeshCacheHeader::MESHLETS_BIT) != 0) != settings.buildMeshlets ||
+			((header->flags & MeshCacheHeader::LODS_BIT) != 0) != settings.buildLods) {
+			return nullptr;
+		}
+
+		uint64_t fileSize = cache->file.GetSize();
+		BlobSizes sizes = GetBlobSizes(*header);
+		if (!BlobFits(header->vertexOffset, sizes.vertexBytes, fileSize) ||
+			!BlobFits(header->indexOffset, sizes.indexBytes, fileSize) ||
+			!BlobFits(header->submeshOffset, sizes.submeshBytes, fileSize) ||
+			!BlobFits(header->lodOffset, sizes.lodBytes, fileSize) ||
+			!BlobFits(header->meshletOffset, sizes.meshletBytes, fileSize) ||
+			!BlobFits(header->meshletBoundsOffset, sizes.meshletBoundsBytes, fileSize) ||
+			!BlobFits(header->meshletVertexOffset, sizes.meshletVertexBytes, fileSize) ||
+			!BlobFits(header->meshletTriangleOffset, sizes.meshletTriangleBytes, fileSize)) {
+			std::cout << "Mesh cache " << cachePath << " is truncated\n";
+			return nullptr;
+		}
+
+		SourceInfo source = GetSourceInfo(sourcePath);
+		if (source.exists) {
+			if (source.size != header->sourceSize) {
+				return nullptr;
+			}
+			// Checkouts and copies touch the timestamp without changing the file
+			if (source.writeTime != header->sourceWriteTime && HashSourceFile(sourcePath) != header->sourceHash) {
+				return nullptr;
+			}
+		}
+
+		return cache;
+	}
+
+	bool MeshCache::Write(
+		const std::string& cachePath,
+		const std::string& sourcePath,
+		const VulkanModel::Builder& builder,
+		float coldLoadMilliseconds,
+		const ModelLoadSettings& settings) {
+
+		SourceInfo source = GetSourceInfo(sourcePath);
+		if (!source.exists) {
+			return false;
+		}
+
+		VulkanModel::MeshView meshView = builder.GetMeshView();
+
+		MeshCacheHeader header{};
+		header.magic = MeshCacheHeader::MAGIC;
+		header.version = MeshCacheHeader::VERSION;
+		header.vertexStride = VulkanModel::GetVertexStride(meshView.vertexLayout);
+		header.vertexCount = meshView.vertexCount;
+		header.indexSize = meshView.indexSize;
+		header.indexCount = meshView.indexCount;
+		header.vertexLayout = static_cast<uint32_t>(meshView.vertexLayout);
+		header.submeshCount = meshView.submeshCount;
+		header.lodCount = meshView.lodCount;
+		header.meshletCount = meshView.meshletCount;
+		header.meshletVertexCount = meshView.meshletVertexCount;
+		header.meshletTriangleBytes = meshView.meshletTriangleBytes;
+
+		BlobSizes sizes = GetBlobSizes(header);
+		header.vertexOffset = AlignUp(sizeof(MeshCacheHeader), BLOB_ALIGNMENT);
+		header.indexOffset = AlignUp(header.vertexOffset + sizes.vertexBytes, BLOB_ALIGNMENT);
+		header.submeshOffset = AlignUp(header.indexOffset + sizes.indexBytes, BLOB_ALIGNMENT);
+		header.lodOffset = AlignUp(header.submeshOffset + sizes.submeshBytes, BLOB_ALIGNMENT);
+		header.meshletOffset = AlignUp(header.lodOffset + sizes.lodBytes, BLOB_ALIGNMENT);
+		header.meshletBoundsOffset = AlignUp(header.meshletOffset + sizes.meshletBytes, BLOB_ALIGNMENT);
+		header.meshletVertexOffset = AlignUp(header.meshletBoundsOffset + sizes.meshletBoundsBytes, BLOB_ALIGNMENT);
+		header.meshletTriangleOffset = AlignUp(header.meshletVertexOffset + sizes.meshletVertexBytes, BLOB_ALIGNMENT);
+
+		for (int i = 0; i < 3; i++) {
+			header.minBounds[i] = meshView.minBounds[i];
+			header.maxBounds[i] = meshView.maxBounds[i];
+			header.sphereCenter[i] = meshView.sphereCenter[i];
+		}
+		header.sphereRadius = meshView.sphereRadius;
+
+		header.sourceSize = source.size;
+		header.sourceWriteTime = source.writeTime;
+		header.sourceHash = HashSourceFile(sourcePath);
+		header.coldLoadMilliseconds = coldLoadMilliseconds;
+		header.flags = (settings.optimizeMesh ? MeshCacheHeader::OPTIMIZED_BIT : 0) |
+			(settings.buildMeshlets ? MeshCacheHeader::MESHLETS_BIT : 0) |
+			(settings.buildLods ? MeshCacheHeader::LODS_BIT : 0);
+
+		// Write next to the real file and rename so a crash never leaves a half written cache behind.
+		// Two writers of the same cache each rename a complete file, whichever lands last wins
+		std::string tempPath = MakeTempPath(cachePath);
+		{
+			std::ofstream out{ tempPath, std::ios::binary | std::ios::trunc };
+			if (!out.is_open()) {
+				std::cout << "Could not write mesh cache " << cachePath << "\n";
+				return false;
+			}
+
+			struct Blob {
+				const void* data;
+				uint64_t offset;
+				uint64_t size;
+			};
+			const Blob blobs[] = {
+				{ &header, 0, sizeof(header) },
+				{ meshView.vertices, header.vertexOffset, sizes.vertexBytes },
+				{ meshView.indicies, header.indexOffset, sizes.indexBytes },
+				{ meshView.submeshes, header.submeshOffset, sizes.submeshBytes },
+				{ meshView.lods, header.lodOffset, sizes.lodBytes },
+				{ meshView.meshlets, header.meshletOffset, sizes.meshletBytes },
+				{ meshView.meshletBounds, header.meshletBoundsOffset, sizes.meshletBoundsBytes },
+				{ meshView.meshletVertices, header.meshletVertexOffset, sizes.meshletVertexBytes },
+				{ meshView.meshletTriangles, header.meshletTriangleOffset, sizes.meshletTriangleBytes },
+			};
+
+			const char padding[BLOB_ALIGNMENT] = {};
+			uint64_t written = 0;
+			for (const auto& blob : blobs) {
+				out.write(padding, blob.offset - written);
+				out.write(static_cast<const char*>(blob.data), blob.size);
+				written = blob.offset + blob.size;
+			}
+
+			if (!out.good()) {
+				std::cout << "Could not write mesh cache " << cachePath << "\n";
+				return false;
+			}
+		}
+
+		std::error_code error{};
+		std::filesystem::rename(tempPath, cachePath, error);
+		if (error) {
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	VulkanModel::MeshView MeshCache::GetMeshView() const {
+		const char* base = static_cast<const char*>(file.GetData());
+
+		VulkanModel::MeshView meshView{};
+		meshView.vertexLayout = static_cast<VertexLayout>(header->vertexLayout);
+		meshView.vertices = base + header->vertexOffset;
+		meshView.vertexCount = header->vertexCount;
+		meshView.indicies = base + header->indexOffset;
+		meshView.indexCount = header->indexCount;
+		meshView.indexSize = header->indexSize;
+		meshView.submeshes = reinterpret_cast<const VulkanModel::Submesh*>(base + header->submeshOffset);
+		meshView.submeshCount = header->submeshCount;
+		meshView.lods = reinterpret_cast<const VulkanModel::Lod*>(base + header->lodOffset);
+		meshView.lodCount = header->lodCount;
+		meshView.meshlets = reinterpret_cast<const VulkanModel::Meshlet*>(base + header->meshletOffset);
+		meshView.meshletBounds = reinterpret_cast<const VulkanModel::MeshletBounds*>(base + header->meshletBoundsOffset);
+		meshView.meshletCount = header->meshletCount;
+		meshView.meshletVertices = reinterpret_cast<const uint32_t*>(base + header->meshletVertexOffset);
+		meshView.meshletVertexCount = header->meshletVertexCount;
+		meshView.meshletTriangles = reinterpret_cast<const uint8_t*>(base + header->meshletTriangleOffset);
+		meshView.meshletTriangleBytes = header->meshletTriangleBytes;
+		meshView.minBounds = { header->minBounds[0], header->minBounds[1], header->minBounds[2] };
+		meshView.maxBounds = { header->maxBounds[0], header->maxBounds[1], header->maxBounds[2] };
+		meshView.sphereCenter = { header->sphereCenter[0], header->sphereCenter[1], header->sphereCenter[2] };
+		meshView.sphereRadius = header->sphereRadius;
+		return meshView;
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "vulkanModel.h"
+
+namespace lve {
+
+	// Read only memory mapping of a whole file
+	class MappedFile {
+		const void* data{nullptr};
+		size_t size{0};
+#ifdef _WIN32
+		void* fileHandle{nullptr};
+		void* mappingHandle{nullptr};
+#endif
+
+	public:
+		MappedFile(const std::string& filePath);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool IsOpen() const { return data != nullptr; }
+		const void* GetData() const { return data; }
+		size_t GetSize() const { return size; }
+	};
+
+	/*
+	* Binary copy of a loaded model so later runs can skip OBJ parsing.
+	* Layout: MeshCacheHeader, vertex blob, index blob, submesh blob, LOD blob, then the meshlet, meshlet bounds,
+	* meshlet vertex and meshlet triangle blobs when meshlets were built. The vertex blob is stored in the
+	* layout it was loaded with and the index blob in the width SelectIndexType picked. Blobs start at the offsets in the header
+	* and are mapped straight into the staging buffers, nothing is copied into a std::vector.
+	*/
+	struct MeshCacheHeader {
+		static constexpr uint32_t MAGIC = 0x4d45564c; // "LVEM"
+		static constexpr uint32_t VERSION = 7;
+
+		// flags
+		static constexpr uint32_t OPTIMIZED_BIT = 1u << 0; // Went through Builder::Optimize
+		static constexpr uint32_t MESHLETS_BIT = 1u << 1;  // Has the meshlet blobs
+		static constexpr uint32_t LODS_BIT = 1u << 2;      // Went through Builder::BuildLods
+
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertexStride;
+		uint32_t vertexCount;
+		uint32_t indexSize;
+		uint32_t indexCount;
+		uint32_t vertexLayout; // VertexLayout of the vertex blob
+		uint32_t submeshCount;
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+		uint64_t submeshOffset;
+
+		uint32_t meshletCount;
+		uint32_t meshletVertexCount;
+		uint32_t meshletTriangleBytes;
+		uint32_t lodCount;
+		uint64_t lodOffset;
+		uint64_t meshletOffset;
+		uint64_t meshletBoundsOffset;
+		uint64_t meshletVertexOffset;
+		uint64_t meshletTriangleOffset;
+		float minBounds[3];
+		float maxBounds[3];
+		float sphereCenter[3];
+		float sphereRadius;
+
+		// Used to notice the source OBJ changed, the hash is only checked when the timestamp differs
+		uint64_t sourceSize;
+		int64_t sourceWriteTime;
+		uint64_t sourceHash;
+
+		// How long the OBJ took to parse when the cache was written, for comparing against warm loads
+		float coldLoadMilliseconds;
+		uint32_t flags;
+	};
+
+	class MeshCache {
+		MappedFile file;
+		const MeshCacheHeader* header{nullptr};
+
+		MeshCache(const std::string& cachePath);
+
+	public:
+		MeshCache(const MeshCache&) = delete;
+		MeshCache& operator=(const MeshCache&) = delete;
+
+		// One file per source and settings, so loads with different settings don't keep replacing each other's cache
+		static std::string GetCachePath(const std::string& sourcePath, const ModelLoadSettings& settings);
+
+		// Returns nullptr when there is no cache, it is out of date or it was written with different load settings
+		static std::unique_ptr<MeshCache> Open(
+			const std::string& cachePath,
+			const std::string& sourcePath,
+			const ModelLoadSettings& settings
+		);
+
+		// Returns false if the cache could not be written, loading still works without it
+		static bool Write(
+			const std::string& cachePath,
+			const std::string& sourcePath,
+			const VulkanModel::Builder& builder,
+			float coldLoadMilliseconds,
+			const ModelLoadSettings& settings
+		);
+
+		VulkanModel::MeshView GetMeshView() const;
+		float GetColdLoadMilliseconds() const { return header->coldLoadMilliseconds; }
+	};
+}
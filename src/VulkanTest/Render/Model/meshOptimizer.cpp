@@ -0,0 +1,336 @@
+#include <algorithm>
+#include <cmath>
+
+#include "meshOptimizer.h"
+
+namespace lve {
+
+	namespace {
+		constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+		// Forsyth's tuning values, the cache is modelled as LRU which is close enough for FIFO hardware
+		constexpr int FORSYTH_CACHE_SIZE = 32;
+		constexpr float CACHE_DECAY_POWER = 1.5f;
+		constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+		constexpr float VALENCE_BOOST_SCALE = 2.0f;
+		constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+		float VertexScore(int cachePosition, uint32_t remainingValence) {
+			if (remainingValence == 0) {
+				// Nothing left to draw with this vertex
+				return -1.f;
+			}
+
+			float score = 0.f;
+			if (cachePosition >= 0) {
+				if (cachePosition < 3) {
+					// Used by the last triangle, a fixed score stops the same strip being favoured forever
+					score = LAST_TRIANGLE_SCORE;
+				}
+				else {
+					const float scaler = 1.f / (FORSYTH_CACHE_SIZE - 3);
+					score = std::pow(1.f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+				}
+			}
+
+			// Boost vertices with few triangles left so they get finished instead of leaving lone triangles behind
+			score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingValence), -VALENCE_BOOST_POWER);
+			return score;
+		}
+
+		// FIFO post transform cache, returns how many of the triangle's vertices had to be transformed
+		class FifoCache {
+			std::vector<uint32_t> timestamps;
+			uint32_t cacheSize;
+			uint32_t time;
+
+		public:
+			FifoCache(size_t vertexCount, uint32_t cacheSize) : timestamps(vertexCount, 0), cacheSize{cacheSize}, time{cacheSize + 1} {}
+
+			// Everything currently cached becomes older than the cache size
+			void Reset() { time += cacheSize + 1; }
+
+			uint32_t Process(const uint32_t* triangle) {
+				uint32_t misses = 0;
+				for (int i = 0; i < 3; i++) {
+					uint32_t index = triangle[i];
+					if (time - timestamps[index] > cacheSize) {
+						timestamps[index] = time++;
+						misses++;
+					}
+				}
+				return misses;
+			}
+		};
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0) {
+			return;
+		}
+
+		// Triangles using each vertex, packed per vertex. The active part of a vertex's range shrinks as triangles are drawn
+		std::vector<uint32_t> remainingValence(vertexCount, 0);
+		for (uint32_t index : indices) {
+			remainingValence[index]++;
+		}
+
+		std::vector<uint32_t> triangleOffsets(vertexCount, 0);
+		uint32_t offset = 0;
+		for (size_t i = 0; i < vertexCount; i++) {
+			triangleOffsets[i] = offset;
+			offset += remainingValence[i];
+		}
+
+		std::vector<uint32_t> adjacentTriangles(indices.size());
+		{
+			std::vector<uint32_t> fill = triangleOffsets;
+			for (size_t i = 0; i < indices.size(); i++) {
+				adjacentTriangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		std::vector<int> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++) {
+			vertexScores[i] = VertexScore(-1, remainingValence[i]);
+		}
+
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<bool> triangleEmitted(triangleCount, false);
+		for (size_t i = 0; i < triangleCount; i++) {
+			const uint32_t* triangle = &indices[i * 3];
+			triangleScores[i] = vertexScores[triangle[0]] + vertexScores[triangle[1]] + vertexScores[triangle[2]];
+		}
+
+		uint32_t bestTriangle = static_cast<uint32_t>(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+		size_t scanCursor = 0;
+
+		// Room for a full cache plus the 3 vertices pushed in front of it before the tail is dropped
+		std::vector<uint32_t> cache{};
+		std::vector<uint32_t> nextCache{};
+		cache.reserve(FORSYTH_CACHE_SIZE + 3);
+		nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+		std::vector<uint32_t> result{};
+		result.reserve(indices.size());
+
+		for (size_t emitted = 0; emitted < triangleCount; emitted++) {
+			if (bestTriangle == INVALID_INDEX) {
+				// Nothing in the cache has triangles left, continue with the next unused triangle in the input
+				while (triangleEmitted[scanCursor]) {
+					scanCursor++;
+				}
+				bestTriangle = static_cast<uint32_t>(scanCursor);
+			}
+
+			const uint32_t* triangle = &indices[bestTriangle * 3];
+			result.insert(result.end(), triangle, triangle + 3);
+			triangleEmitted[bestTriangle] = true;
+
+			nextCache.clear();
+			for (int i = 0; i < 3; i++) {
+				uint32_t vertex = triangle[i];
+				nextCache.push_back(vertex);
+
+				// Swap the drawn triangle out of the active part of the vertex's list
+				uint32_t* begin = &adjacentTriangles[triangleOffsets[vertex]];
+				uint32_t* end = begin + remainingValence[vertex];
+				*std::find(begin, end, bestTriangle) = *(end - 1);
+				remainingValence[vertex]--;
+			}
+			for (uint32_t vertex : cache) {
+				if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]) {
+					nextCache.push_back(vertex);
+				}
+			}
+
+			// Rescore every vertex whose cache position or valence changed and push the difference into its triangles
+			for (size_t i = 0; i < nextCache.size(); i++) {
+				uint32_t vertex = nextCache[i];
+				int cachePosition = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+				cachePositions[vertex] = cachePosition;
+
+				float score = VertexScore(cachePosition, remainingValence[vertex]);
+				float delta = score - vertexScores[vertex];
+				vertexScores[vertex] = score;
+
+				const uint32_t* begin = &adjacentTriangles[triangleOffsets[vertex]];
+				for (uint32_t j = 0; j < remainingValence[vertex]; j++) {
+					triangleScores[begin[j]] += delta;
+				}
+			}
+
+			if (nextCache.size() > FORSYTH_CACHE_SIZE) {
+				nextCache.resize(FORSYTH_CACHE_SIZE);
+			}
+			cache.swap(nextCache);
+
+			// Only triangles touching the cache can have gained score, the rest of the mesh is not searched
+			bestTriangle = INVALID_INDEX;
+			float bestScore = -1.f;
+			for (uint32_t vertex : cache) {
+				const uint32_t* begin = &adjacentTriangles[triangleOffsets[vertex]];
+				for (uint32_t j = 0; j < remainingValence[vertex]; j++) {
+					uint32_t candidate = begin[j];
+					if (triangleScores[candidate] > bestScore) {
+						bestScore = triangleScores[candidate];
+						bestTriangle = candidate;
+					}
+				}
+			}
+		}
+
+		indices.swap(result);
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(
+		std::vector<uint32_t>& indices,
+		const std::vector<VulkanModel::Vertex>& vertices,
+		float threshold) {
+
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0) {
+			return;
+		}
+
+		VertexCacheStatistics meshStatistics = AnalyzeVertexCache(indices, vertices.size());
+		float clusterThreshold = threshold * meshStatistics.acmr;
+
+		// Hard boundaries are where all 3 vertices miss, the cache has effectively restarted there so
+		// moving the cluster costs nothing. Clusters are cut further wherever their own ACMR is good enough
+		std::vector<uint32_t> clusterStarts{0};
+		{
+			FifoCache hardCache{vertices.size(), FIFO_CACHE_SIZE};
+			FifoCache softCache{vertices.size(), FIFO_CACHE_SIZE};
+			uint32_t clusterStart = 0;
+			uint32_t clusterMisses = 0;
+
+			for (uint32_t i = 0; i < triangleCount; i++) {
+				const uint32_t* triangle = &indices[i * 3];
+				if (hardCache.Process(triangle) == 3 && i > clusterStart) {
+					clusterStarts.push_back(i);
+					clusterStart = i;
+					clusterMisses = 0;
+					softCache.Reset();
+				}
+
+				clusterMisses += softCache.Process(triangle);
+				float clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(i - clusterStart + 1);
+				if (clusterAcmr <= clusterThreshold && i + 1 < triangleCount) {
+					clusterStarts.push_back(i + 1);
+					clusterStart = i + 1;
+					clusterMisses = 0;
+					softCache.Reset();
+				}
+			}
+		}
+
+		size_t clusterCount = clusterStarts.size();
+		clusterStarts.push_back(static_cast<uint32_t>(triangleCount));
+
+		// Area weighted centroid and normal per cluster, outward facing clusters sort first
+		std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3{0.f});
+		std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3{0.f});
+		std::vector<float> clusterAreas(clusterCount, 0.f);
+		glm::vec3 meshCentroid{0.f};
+		float meshArea = 0.f;
+
+		for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+			for (uint32_t i = clusterStarts[cluster]; i < clusterStarts[cluster + 1]; i++) {
+				const glm::vec3& a = vertices[indices[i * 3 + 0]].position;
+				const glm::vec3& b = vertices[indices[i * 3 + 1]].position;
+				const glm::vec3& c = vertices[indices[i * 3 + 2]].position;
+
+				// Length of the cross product is twice the area, the factor cancels out
+				glm::vec3 normal = glm::cross(b - a, c - a);
+				float area = glm::length(normal);
+
+				clusterCentroids[cluster] += (a + b + c) * (area / 3.f);
+				clusterNormals[cluster] += normal;
+				clusterAreas[cluster] += area;
+			}
+
+			meshCentroid += clusterCentroids[cluster];
+			meshArea += clusterAreas[cluster];
+		}
+		if (meshArea > 0.f) {
+			meshCentroid /= meshArea;
+		}
+
+		std::vector<float> clusterKeys(clusterCount, 0.f);
+		for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+			if (clusterAreas[cluster] <= 0.f) {
+				continue;
+			}
+			glm::vec3 centroid = clusterCentroids[cluster] / clusterAreas[cluster];
+			float normalLength = glm::length(clusterNormals[cluster]);
+			if (normalLength > 0.f) {
+				clusterKeys[cluster] = glm::dot(centroid - meshCentroid, clusterNormals[cluster] / normalLength);
+			}
+		}
+
+		std::vector<uint32_t> clusterOrder(clusterCount);
+		for (uint32_t i = 0; i < clusterCount; i++) {
+			clusterOrder[i] = i;
+		}
+		// Stable so equal keys keep their cache friendly order
+		std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint32_t left, uint32_t right) {
+			return clusterKeys[left] > clusterKeys[right];
+		});
+
+		std::vector<uint32_t> result{};
+		result.reserve(indices.size());
+		for (uint32_t cluster : clusterOrder) {
+			result.insert(result.end(), indices.begin() + clusterStarts[cluster] * 3, indices.begin() + clusterStarts[cluster + 1] * 3);
+		}
+		indices.swap(result);
+	}
+
+	void MeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<VulkanModel::Vertex>& vertices) {
+		std::vector<uint32_t> remap(vertices.size(), INVALID_INDEX);
+		std::vector<VulkanModel::Vertex> result{};
+		result.reserve(vertices.size());
+
+		for (uint32_t& index : indices) {
+			if (remap[index] == INVALID_INDEX) {
+				remap[index] = static_cast<uint32_t>(result.size());
+				result.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+
+		vertices.swap(result);
+	}
+
+	VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(
+		const std::vector<uint32_t>& indices,
+		size_t vertexCount,
+		uint32_t cacheSize) {
+
+		VertexCacheStatistics statistics{};
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0) {
+			return statistics;
+		}
+
+		FifoCache cache{vertexCount, cacheSize};
+		std::vector<bool> referenced(vertexCount, false);
+		uint32_t referencedCount = 0;
+
+		for (size_t i = 0; i < triangleCount; i++) {
+			statistics.vertexTransforms += cache.Process(&indices[i * 3]);
+		}
+		for (uint32_t index : indices) {
+			if (!referenced[index]) {
+				referenced[index] = true;
+				referencedCount++;
+			}
+		}
+
+		statistics.acmr = static_cast<float>(statistics.vertexTransforms) / static_cast<float>(triangleCount);
+		statistics.atvr = static_cast<float>(statistics.vertexTransforms) / static_cast<float>(referencedCount);
+		return statistics;
+	}
+}
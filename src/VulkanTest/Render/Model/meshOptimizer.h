@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vulkanModel.h"
+
+namespace lve {
+
+	struct VertexCacheStatistics {
+		uint32_t vertexTransforms{0};
+		float acmr{0.f}; // Average cache miss ratio, transformed vertices per triangle. 0.5 is the best possible, 3 the worst
+		float atvr{0.f}; // Average transform to vertex ratio, 1 means every vertex is transformed exactly once
+	};
+
+	/*
+	* Index and vertex reordering for indexed triangle lists, all CPU side so the results can be checked offline.
+	* Intended order is OptimizeVertexCache, then OptimizeOverdraw, then OptimizeVertexFetch.
+	*/
+	class MeshOptimizer {
+	public:
+		// Post transform cache size assumed by AnalyzeVertexCache, a FIFO like most hardware
+		static constexpr uint32_t FIFO_CACHE_SIZE = 16;
+
+		// Reorders triangles for post transform cache hits with Tom Forsyth's linear speed algorithm
+		static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+		/*
+		* Splits the cache optimized triangles into clusters at cache restarts (Sander et al. "Fast Triangle
+		* Reordering for Vertex Locality and Reduced Overdraw") and sorts the clusters so outward facing ones
+		* draw first and occlude the rest. threshold is how much worse than the whole mesh a cluster's ACMR may get.
+		*/
+		static void OptimizeOverdraw(
+			std::vector<uint32_t>& indices,
+			const std::vector<VulkanModel::Vertex>& vertices,
+			float threshold = 1.05f
+		);
+
+		// Renumbers vertices in order of first use and drops unreferenced ones
+		static void OptimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<VulkanModel::Vertex>& vertices);
+
+		static VertexCacheStatistics AnalyzeVertexCache(
+			const std::vector<uint32_t>& indices,
+			size_t vertexCount,
+			uint32_t cacheSize = FIFO_CACHE_SIZE
+		);
+	};
+}
@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "meshSimplifier.h"
+
+namespace lve {
+
+	namespace {
+		// Open edges get an extra plane at right angles to the surface so holes and outlines keep their shape
+		constexpr double BORDER_WEIGHT = 10.0;
+
+		// A collapse may not turn any remaining triangle further than about 75 degrees
+		constexpr float MIN_NORMAL_AGREEMENT = 0.25f;
+
+		// Sum of squared distances to a set of planes, stored as the upper half of the symmetric 4x4 matrix
+		struct Quadric {
+			double a2{0}, ab{0}, ac{0}, ad{0};
+			double b2{0}, bc{0}, bd{0};
+			double c2{0}, cd{0};
+			double d2{0};
+			double weight{0};
+
+			static Quadric FromPlane(double a, double b, double c, double d, double weight) {
+				Quadric quadric{};
+				quadric.a2 = a * a * weight;
+				quadric.ab = a * b * weight;
+				quadric.ac = a * c * weight;
+				quadric.ad = a * d * weight;
+				quadric.b2 = b * b * weight;
+				quadric.bc = b * c * weight;
+				quadric.bd = b * d * weight;
+				quadric.c2 = c * c * weight;
+				quadric.cd = c * d * weight;
+				quadric.d2 = d * d * weight;
+				quadric.weight = weight;
+				return quadric;
+			}
+
+			Quadric& operator+=(const Quadric& other) {
+				a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+				b2 += other.b2; bc += other.bc; bd += other.bd;
+				c2 += other.c2; cd += other.cd;
+				d2 += other.d2;
+				weight += other.weight;
+				return *this;
+			}
+
+			// Weighted mean squared distance of position to the planes
+			double Evaluate(const glm::vec3& position) const {
+				if (weight <= 0.0) {
+					return 0.0;
+				}
+				double x = position.x, y = position.y, z = position.z;
+				double error =
+					a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x +
+					b2 * y * y + 2 * bc * y * z + 2 * bd * y +
+					c2 * z * z + 2 * cd * z +
+					d2;
+				return std::max(error, 0.0) / weight;
+			}
+		};
+
+		struct Collapse {
+			uint32_t from;
+			uint32_t to;
+			double error;
+		};
+
+		uint64_t EdgeKey(uint32_t from, uint32_t to) {
+			return (static_cast<uint64_t>(from) << 32) | to;
+		}
+
+		glm::vec3 TriangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+			return glm::cross(b - a, c - a);
+		}
+
+		// How alike two vertices at the same position are, used to pick a replacement across seams
+		float AttributeSimilarity(const VulkanModel::Vertex& a, const VulkanModel::Vertex& b) {
+			glm::vec2 uvDifference = a.uv - b.uv;
+			glm::vec3 colorDifference = a.color - b.color;
+			return glm::dot(a.normal, b.normal) - glm::dot(uvDifference, uvDifference) - glm::dot(colorDifference, colorDifference);
+		}
+	}
+
+	float MeshSimplifier::Simplify(
+		const std::vector<uint32_t>& indices,
+		const std::vector<VulkanModel::Vertex>& vertices,
+		size_t targetIndexCount,
+		float targetError,
+		std::vector<uint32_t>& result) {
+
+		size_t vertexCount = vertices.size();
+
+		// Group vertices that only differ in normal, color or uv, the topology is simplified on positions alone
+		std::vector<uint32_t> sortedVertices(vertexCount);
+		std::iota(sortedVertices.begin(), sortedVertices.end(), 0);
+		auto positionLess = [&](uint32_t left, uint32_t right) {
+			const glm::vec3& a = vertices[left].position;
+			const glm::vec3& b = vertices[right].position;
+			if (a.x != b.x) return a.x < b.x;
+			if (a.y != b.y) return a.y < b.y;
+			return a.z < b.z;
+		};
+		std::sort(sortedVertices.begin(), sortedVertices.end(), positionLess);
+
+		// canonical[v] is the first vertex at v's position, sortedVertices[wedgeBegin[c]..wedgeEnd[c]) are all vertices there
+		std::vector<uint32_t> canonical(vertexCount);
+		std::vector<uint32_t> wedgeBegin(vertexCount, 0);
+		std::vector<uint32_t> wedgeEnd(vertexCount, 0);
+		for (size_t i = 0; i < vertexCount;) {
+			size_t end = i + 1;
+			while (end < vertexCount && !positionLess(sortedVertices[i], sortedVertices[end])) {
+				end++;
+			}
+			uint32_t first = sortedVertices[i];
+			for (size_t j = i; j < end; j++) {
+				canonical[sortedVertices[j]] = first;
+			}
+			wedgeBegin[first] = static_cast<uint32_t>(i);
+			wedgeEnd[first] = static_cast<uint32_t>(end);
+			i = end;
+		}
+
+		auto position = [&](uint32_t vertex) -> const glm::vec3& { return vertices[vertex].position; };
+
+		// Triangles keep their real vertex indices, topology questions go through canonical
+		result.clear();
+		result.reserve(indices.size());
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			uint32_t a = canonical[indices[i]], b = canonical[indices[i + 1]], c = canonical[indices[i + 2]];
+			if (a != b && b != c && a != c) {
+				result.insert(result.end(), { indices[i], indices[i + 1], indices[i + 2] });
+			}
+		}
+
+		// Directed edges present in the mesh, an edge without its reverse is on a border
+		std::vector<uint64_t> edges{};
+		auto buildEdges = [&]() {
+			edges.clear();
+			edges.reserve(result.size());
+			for (size_t i = 0; i < result.size(); i += 3) {
+				for (int e = 0; e < 3; e++) {
+					edges.push_back(EdgeKey(canonical[result[i + e]], canonical[result[i + (e + 1) % 3]]));
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+		};
+		auto isBorderEdge = [&](uint32_t from, uint32_t to) {
+			return !std::binary_search(edges.begin(), edges.end(), EdgeKey(to, from));
+		};
+
+		buildEdges();
+
+		std::vector<Quadric> quadrics(vertexCount);
+		std::vector<bool> borderVertex(vertexCount, false);
+		for (size_t i = 0; i < result.size(); i += 3) {
+			uint32_t corners[3] = { canonical[result[i]], canonical[result[i + 1]], canonical[result[i + 2]] };
+			glm::vec3 normal = TriangleNormal(position(corners[0]), position(corners[1]), position(corners[2]));
+			float length = glm::length(normal);
+			if (length == 0.f) {
+				continue;
+			}
+			normal /= length;
+
+			double distance = -glm::dot(normal, position(corners[0]));
+			Quadric plane = Quadric::FromPlane(normal.x, normal.y, normal.z, distance, length * 0.5);
+			for (uint32_t corner : corners) {
+				quadrics[corner] += plane;
+			}
+
+			for (int e = 0; e < 3; e++) {
+				uint32_t from = corners[e];
+				uint32_t to = corners[(e + 1) % 3];
+				if (!isBorderEdge(from, to)) {
+					continue;
+				}
+				borderVertex[from] = borderVertex[to] = true;
+
+				glm::vec3 edge = position(to) - position(from);
+				float edgeLength = glm::length(edge);
+				if (edgeLength == 0.f) {
+					continue;
+				}
+				glm::vec3 borderNormal = glm::normalize(glm::cross(edge, normal));
+				Quadric borderPlane = Quadric::FromPlane(
+					borderNormal.x, borderNormal.y, borderNormal.z,
+					-glm::dot(borderNormal, position(from)),
+					edgeLength * edgeLength * BORDER_WEIGHT);
+				quadrics[from] += borderPlane;
+				quadrics[to] += borderPlane;
+			}
+		}
+
+		double maxError = static_cast<double>(targetError) * targetError;
+		double reachedError = 0.0;
+
+		std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+		std::vector<uint32_t> adjacentTriangles{};
+		std::vector<uint32_t> collapseTarget(vertexCount);
+		std::vector<bool> locked(vertexCount);
+		std::vector<Collapse> collapses{};
+
+		while (result.size() > targetIndexCount) {
+			size_t triangleCount = result.size() / 3;
+
+			// Triangles around each canonical vertex
+			std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+			for (uint32_t index : result) {
+				triangleOffsets[canonical[index] + 1]++;
+			}
+			std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+			adjacentTriangles.resize(result.size());
+			{
+				std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+				for (size_t i = 0; i < result.size(); i++) {
+					adjacentTriangles[fill[canonical[result[i]]]++] = static_cast<uint32_t>(i / 3);
+				}
+			}
+
+			// Cheapest allowed direction of every edge. Border vertices may only slide along the border
+			collapses.clear();
+			for (size_t i = 0; i < result.size(); i += 3) {
+				for (int e = 0; e < 3; e++) {
+					uint32_t a = canonical[result[i + e]];
+					uint32_t b = canonical[result[i + (e + 1) % 3]];
+					bool borderEdge = isBorderEdge(a, b);
+					if (!borderEdge && a > b) {
+						// Interior edges show up from both triangles, only take them once
+						continue;
+					}
+
+					Quadric combined = quadrics[a];
+					combined += quadrics[b];
+
+					bool aToB = !borderVertex[a] || borderEdge;
+					bool bToA = !borderVertex[b] || borderEdge;
+					double errorAToB = combined.Evaluate(position(b));
+					double errorBToA = combined.Evaluate(position(a));
+
+					if (aToB && (!bToA || errorAToB <= errorBToA)) {
+						collapses.push_back({ a, b, errorAToB });
+					}
+					else if (bToA) {
+						collapses.push_back({ b, a, errorBToA });
+					}
+				}
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& left, const Collapse& right) {
+				return left.error < right.error;
+			});
+
+			std::iota(collapseTarget.begin(), collapseTarget.end(), 0);
+			std::fill(locked.begin(), locked.end(), false);
+
+			// Each collapse removes about two triangles, stop once the target is reached
+			size_t trianglesToRemove = triangleCount - targetIndexCount / 3;
+			size_t trianglesRemoved = 0;
+			size_t applied = 0;
+
+			for (const auto& collapse : collapses) {
+				if (collapse.error > maxError || trianglesRemoved >= trianglesToRemove) {
+					break;
+				}
+				if (locked[collapse.from] || locked[collapse.to]) {
+					continue;
+				}
+
+				// Reject collapses that flip or squash a remaining triangle
+				bool flips = false;
+				size_t removes = 0;
+				for (uint32_t j = triangleOffsets[collapse.from]; j < triangleOffsets[collapse.from + 1] && !flips; j++) {
+					const uint32_t* triangle = &result[adjacentTriangles[j] * 3];
+					uint32_t corners[3] = { canonical[triangle[0]], canonical[triangle[1]], canonical[triangle[2]] };
+					if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to) {
+						removes++;
+						continue;
+					}
+
+					glm::vec3 before = TriangleNormal(position(corners[0]), position(corners[1]), position(corners[2]));
+					for (uint32_t& corner : corners) {
+						if (corner == collapse.from) {
+							corner = collapse.to;
+						}
+					}
+					glm::vec3 after = TriangleNormal(position(corners[0]), position(corners[1]), position(corners[2]));
+					flips = glm::dot(before, after) < MIN_NORMAL_AGREEMENT * glm::length(before) * glm::length(after);
+				}
+				if (flips) {
+					continue;
+				}
+
+				collapseTarget[collapse.from] = collapse.to;
+				quadrics[collapse.to] += quadrics[collapse.from];
+				reachedError = std::max(reachedError, collapse.error);
+				trianglesRemoved += removes;
+				applied++;
+
+				// Lock the whole neighbourhood so later collapses this pass see the triangles the flip test saw
+				for (uint32_t j = triangleOffsets[collapse.from]; j < triangleOffsets[collapse.from + 1]; j++) {
+					const uint32_t* triangle = &result[adjacentTriangles[j] * 3];
+					for (int k = 0; k < 3; k++) {
+						locked[canonical[triangle[k]]] = true;
+					}
+				}
+			}
+
+			if (applied == 0) {
+				break;
+			}
+
+			// Move collapsed corners to the most similar vertex at the target position and drop degenerate triangles
+			size_t write = 0;
+			for (size_t i = 0; i < result.size(); i += 3) {
+				uint32_t triangle[3];
+				for (int k = 0; k < 3; k++) {
+					uint32_t vertex = result[i + k];
+					uint32_t target = collapseTarget[canonical[vertex]];
+					if (target != canonical[vertex]) {
+						uint32_t best = target;
+						float bestSimilarity = -1e30f;
+						for (uint32_t w = wedgeBegin[target]; w < wedgeEnd[target]; w++) {
+							float similarity = AttributeSimilarity(vertices[vertex], vertices[sortedVertices[w]]);
+							if (similarity > bestSimilarity) {
+								bestSimilarity = similarity;
+								best = sortedVertices[w];
+							}
+						}
+						vertex = best;
+					}
+					triangle[k] = vertex;
+				}
+
+				uint32_t a = canonical[triangle[0]], b = canonical[triangle[1]], c = canonical[triangle[2]];
+				if (a != b && b != c && a != c) {
+					result[write++] = triangle[0];
+					result[write++] = triangle[1];
+					result[write++] = triangle[2];
+				}
+			}
+			result.resize(write);
+
+			buildEdges();
+		}
+
+		return static_cast<float>(std::sqrt(reachedError));
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vulkanModel.h"
+
+namespace lve {
+
+	/*
+	* Quadric error edge collapse (Garland and Heckbert) for building LODs.
+	* Collapses only ever move a vertex onto a neighbour, so every LOD indexes the original vertex array
+	* and all LODs of a model share one vertex buffer. Vertices at the same position are simplified as one,
+	* normal and uv seams pick the closest matching vertex on the other side of a collapse.
+	*/
+	class MeshSimplifier {
+	public:
+		/*
+		* Writes a simplified copy of indices to result with at most targetIndexCount indices, unless that would
+		* need a collapse with an error above targetError. Errors are distances in model space.
+		* Returns the largest error of the collapses that were made.
+		*/
+		static float Simplify(
+			const std::vector<uint32_t>& indices,
+			const std::vector<VulkanModel::Vertex>& vertices,
+			size_t targetIndexCount,
+			float targetError,
+			std::vector<uint32_t>& result
+		);
+	};
+}
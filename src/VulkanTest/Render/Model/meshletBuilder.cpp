@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "meshletBuilder.h"
+
+namespace lve {
+
+	namespace {
+		constexpr uint8_t UNUSED = 0xff;
+
+		// Below this the cone covers nearly a hemisphere and would almost never cull anything
+		constexpr float MIN_CONE_DOT = 0.1f;
+
+		float DistanceSquared(const glm::vec3& a, const glm::vec3& b) {
+			glm::vec3 difference = a - b;
+			return glm::dot(difference, difference);
+		}
+	}
+
+	void MeshletBuilder::Build(VulkanModel::Builder& builder, uint32_t maxVertices, uint32_t maxTriangles) {
+		assert(maxVertices >= 3 && maxVertices < UNUSED && "meshlet vertices must fit in uint8_t local indices");
+		assert(maxTriangles >= 1 && "meshlets need room for a triangle");
+
+		builder.meshlets.clear();
+		builder.meshletBounds.clear();
+		builder.meshletVertices.clear();
+		builder.meshletTriangles.clear();
+
+		const std::vector<uint32_t>& indices = builder.indicies;
+		std::vector<VulkanModel::Submesh> ranges = builder.submeshes;
+		if (ranges.empty()) {
+			ranges.push_back({ 0, static_cast<uint32_t>(indices.size()), 0 });
+		}
+		// Only the full detail LOD is clustered, coarser LODs are drawn whole
+		if (!builder.lods.empty()) {
+			uint32_t lod0End = builder.lods[0].firstIndex + builder.lods[0].indexCount;
+			ranges.erase(std::remove_if(ranges.begin(), ranges.end(), [&](const VulkanModel::Submesh& range) {
+				return range.firstIndex >= lod0End;
+			}), ranges.end());
+		}
+
+		// Position of each vertex inside the meshlet being filled, reset when the meshlet is flushed
+		std::vector<uint8_t> localIndices(builder.vertices.size(), UNUSED);
+
+		VulkanModel::Meshlet meshlet{};
+		auto flush = [&]() {
+			if (meshlet.triangleCount == 0) {
+				return;
+			}
+			for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+				localIndices[builder.meshletVertices[meshlet.vertexOffset + i]] = UNUSED;
+			}
+			builder.meshlets.push_back(meshlet);
+		};
+		auto start = [&](uint32_t firstIndex, int32_t baseVertex) {
+			meshlet = {};
+			meshlet.firstIndex = firstIndex;
+			meshlet.baseVertex = baseVertex;
+			meshlet.vertexOffset = static_cast<uint32_t>(builder.meshletVertices.size());
+			meshlet.triangleOffset = static_cast<uint32_t>(builder.meshletTriangles.size() / 3);
+		};
+
+		for (const auto& range : ranges) {
+			start(range.firstIndex, range.vertexOffset);
+
+			for (uint32_t i = range.firstIndex; i + 2 < range.firstIndex + range.indexCount; i += 3) {
+				uint32_t a = indices[i + 0];
+				uint32_t b = indices[i + 1];
+				uint32_t c = indices[i + 2];
+
+				uint32_t newVertices = (localIndices[a] == UNUSED) + (localIndices[b] == UNUSED && b != a) +
+					(localIndices[c] == UNUSED && c != a && c != b);
+
+				if (meshlet.vertexCount + newVertices > maxVertices || meshlet.triangleCount + 1 > maxTriangles) {
+					flush();
+					start(i, range.vertexOffset);
+				}
+
+				for (uint32_t vertex : { a, b, c }) {
+					if (localIndices[vertex] == UNUSED) {
+						localIndices[vertex] = static_cast<uint8_t>(meshlet.vertexCount++);
+						builder.meshletVertices.push_back(vertex);
+					}
+					builder.meshletTriangles.push_back(localIndices[vertex]);
+				}
+				meshlet.triangleCount++;
+			}
+			flush();
+		}
+
+		// Storage buffers are read as uint so the byte stream is padded to a whole word
+		while (builder.meshletTriangles.size() % 4 != 0) {
+			builder.meshletTriangles.push_back(0);
+		}
+
+		builder.meshletBounds.reserve(builder.meshlets.size());
+		for (const auto& cluster : builder.meshlets) {
+			builder.meshletBounds.push_back(ComputeBounds(cluster, builder.meshletVertices, builder.meshletTriangles, builder.vertices));
+		}
+	}
+
+	VulkanModel::MeshletBounds MeshletBuilder::ComputeBounds(
+		const VulkanModel::Meshlet& meshlet,
+		const std::vector<uint32_t>& meshletVertices,
+		const std::vector<uint8_t>& meshletTriangles,
+		const std::vector<VulkanModel::Vertex>& vertices) {
+
+		VulkanModel::MeshletBounds bounds{};
+		if (meshlet.vertexCount == 0) {
+			return bounds;
+		}
+
+		auto position = [&](uint32_t localIndex) -> const glm::vec3& {
+			return vertices[meshletVertices[meshlet.vertexOffset + localIndex]].position;
+		};
+
+		// Ritter: start from the farthest pair found by two sweeps, then grow the sphere over the stragglers
+		glm::vec3 first = position(0);
+		glm::vec3 second = first;
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+			if (DistanceSquared(position(i), first) > DistanceSquared(second, first)) {
+				second = position(i);
+			}
+		}
+		glm::vec3 third = second;
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+			if (DistanceSquared(position(i), second) > DistanceSquared(third, second)) {
+				third = position(i);
+			}
+		}
+
+		glm::vec3 center = (second + third) * 0.5f;
+		float radius = std::sqrt(DistanceSquared(second, third)) * 0.5f;
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+			float distance = std::sqrt(DistanceSquared(position(i), center));
+			if (distance > radius) {
+				float newRadius = (radius + distance) * 0.5f;
+				center += (position(i) - center) * ((newRadius - radius) / distance);
+				radius = newRadius;
+			}
+		}
+		bounds.center = center;
+		bounds.radius = radius;
+		bounds.coneApex = center;
+
+		// Normal cone around the average facing direction, ignoring degenerate triangles
+		struct TrianglePlane {
+			glm::vec3 normal;
+			glm::vec3 corner;
+		};
+		std::vector<TrianglePlane> planes{};
+		planes.reserve(meshlet.triangleCount);
+		glm::vec3 normalSum{0.f};
+		for (uint32_t i = 0; i < meshlet.triangleCount; i++) {
+			const uint8_t* triangle = &meshletTriangles[(meshlet.triangleOffset + i) * 3];
+			glm::vec3 normal = glm::cross(position(triangle[1]) - position(triangle[0]), position(triangle[2]) - position(triangle[0]));
+			float area = glm::length(normal);
+			if (area > 0.f) {
+				planes.push_back({ normal / area, position(triangle[0]) });
+				normalSum += normal / area;
+			}
+		}
+
+		float sumLength = glm::length(normalSum);
+		if (planes.empty() || sumLength == 0.f) {
+			return bounds;
+		}
+		glm::vec3 axis = normalSum / sumLength;
+
+		float minDot = 1.f;
+		for (const auto& plane : planes) {
+			minDot = std::min(minDot, glm::dot(plane.normal, axis));
+		}
+		if (minDot <= MIN_CONE_DOT) {
+			return bounds;
+		}
+
+		// Move the apex back along the axis until every triangle plane is in front of it,
+		// then the cone test from any camera position is conservative
+		float maxDistance = 0.f;
+		for (const auto& plane : planes) {
+			float distance = glm::dot(center - plane.corner, plane.normal) / glm::dot(plane.normal, axis);
+			maxDistance = std::max(maxDistance, distance);
+		}
+
+		bounds.coneApex = center - axis * maxDistance;
+		bounds.coneAxis = axis;
+		bounds.coneCutoff = std::sqrt(1.f - minDot * minDot);
+		return bounds;
+	}
+}
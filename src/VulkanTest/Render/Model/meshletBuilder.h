@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vulkanModel.h"
+
+namespace lve {
+
+	/*
+	* Splits an indexed triangle list into meshlets by scanning it in order, so run it on the final
+	* (cache optimized) index order and every meshlet stays a contiguous index range.
+	* Meshlets never cross submesh boundaries and only cover LOD 0.
+	*/
+	class MeshletBuilder {
+	public:
+		// 64 / 124 fits the usual mesh shader output limits, local indices are stored as uint8_t
+		static constexpr uint32_t MAX_VERTICES = 64;
+		static constexpr uint32_t MAX_TRIANGLES = 124;
+
+		// Fills builder.meshlets, meshletBounds, meshletVertices and meshletTriangles from builder.indicies
+		static void Build(
+			VulkanModel::Builder& builder,
+			uint32_t maxVertices = MAX_VERTICES,
+			uint32_t maxTriangles = MAX_TRIANGLES
+		);
+
+		// Bounding sphere (Ritter) and normal cone of one meshlet
+		static VulkanModel::MeshletBounds ComputeBounds(
+			const VulkanModel::Meshlet& meshlet,
+			const std::vector<uint32_t>& meshletVertices,
+			const std::vector<uint8_t>& meshletTriangles,
+			const std::vector<VulkanModel::Vertex>& vertices
+		);
+	};
+}
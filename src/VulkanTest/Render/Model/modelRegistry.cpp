@@ -0,0 +1,165 @@
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+
+#include "modelRegistry.h"
+#include "../utils.h"
+
+namespace lve {
+
+	namespace {
+		uint64_t HashMeshView(const VulkanModel::MeshView& meshView, const ModelLoadSettings& settings) {
+			uint32_t header[] = {
+				static_cast<uint32_t>(meshView.vertexLayout),
+				meshView.vertexCount,
+				meshView.indexCount,
+				meshView.indexSize,
+				settings.buildMeshlets,
+				settings.buildLods
+			};
+			uint64_t hash = hashBytes(header, sizeof(header));
+			hash = hashBytes(meshView.vertices, static_cast<size_t>(meshView.vertexCount) * VulkanModel::GetVertexStride(meshView.vertexLayout), hash);
+			hash = hashBytes(meshView.indicies, static_cast<size_t>(meshView.indexCount) * meshView.indexSize, hash);
+			hash = hashBytes(meshView.submeshes, meshView.submeshCount * sizeof(VulkanModel::Submesh), hash);
+			hash = hashBytes(meshView.lods, meshView.lodCount * sizeof(VulkanModel::Lod), hash);
+			return hash;
+		}
+
+		template<typename Map>
+		void EraseExpired(Map& map) {
+			for (auto it = map.begin(); it != map.end();) {
+				it = it->second.expired() ? map.erase(it) : std::next(it);
+			}
+		}
+	}
+
+	ModelRegistry::ModelRegistry(VulkanDevice& device, GeometryArena* arena) : device{ device }, arena{ arena }, residentCounters{ std::make_shared<ResidentCounters>() } {}
+
+	ModelRegistry::~ModelRegistry() {
+		std::vector<std::pair<VulkanModel*, VkDeviceSize>> released{};
+		{
+			std::lock_guard<std::mutex> lock{ residentCounters->releaseMutex };
+			residentCounters->registryAlive = false;
+			for (auto& frameReleased : residentCounters->released) {
+				released.insert(released.end(), frameReleased.begin(), frameReleased.end());
+				frameReleased.clear();
+			}
+		}
+		for (const auto& [model, size] : released) {
+			residentCounters->Destroy(model, size);
+		}
+	}
+
+	void ModelRegistry::BeginFrame(uint32_t frameIndex) {
+		assert(frameIndex < vulkanSwapChain::MAX_FRAMES_IN_FLIGHT && "frame index out of range");
+
+		// Destroyed outside the lock, a model frees its arena ranges which takes the arena's lock
+		std::vector<std::pair<VulkanModel*, VkDeviceSize>> released{};
+		{
+			std::lock_guard<std::mutex> lock{ residentCounters->releaseMutex };
+			residentCounters->frameIndex = frameIndex;
+			released.swap(residentCounters->released[frameIndex]);
+		}
+		for (const auto& [model, size] : released) {
+			residentCounters->Destroy(model, size);
+		}
+	}
+
+	void ModelRegistry::ResidentCounters::Destroy(VulkanModel* model, VkDeviceSize size) {
+		bytes -= size;
+		models--;
+		delete model;
+	}
+
+	std::string ModelRegistry::MakeKey(const std::string& filePath, const ModelLoadSettings& settings) {
+		std::error_code error{};
+		std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(filePath, error);
+		std::string key = error ? filePath : canonicalPath.generic_string();
+
+		key += "|layout=" + std::to_string(static_cast<uint32_t>(settings.vertexLayout));
+		key += settings.optimizeMesh ? "|optimized" : "";
+		key += settings.buildMeshlets ? "|meshlets" : "";
+		key += settings.buildLods ? "|lods" : "";
+		return key;
+	}
+
+	std::shared_ptr<VulkanModel> ModelRegistry::Find(const std::string& filePath, const ModelLoadSettings& settings) {
+		std::string key = MakeKey(filePath, settings);
+		std::lock_guard<std::mutex> lock{ mutex };
+		return FindLocked(key);
+	}
+
+	std::shared_ptr<VulkanModel> ModelRegistry::Acquire(const std::string& filePath, const ModelLoadSettings& settings) {
+		std::string key = MakeKey(filePath, settings);
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (auto model = FindLocked(key)) {
+				hits++;
+				return model;
+			}
+		}
+
+		// Parsing and building run unlocked, two threads loading the same new path both parse it
+		// and the second one finds the first one's model below
+		VulkanModel::MeshData meshData = VulkanModel::LoadMeshData(filePath, settings);
+		VulkanModel::MeshView meshView = meshData.GetMeshView();
+		uint64_t contentHash = HashMeshView(meshView, settings);
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		if (auto model = FindLocked(key)) {
+			hits++;
+			return model;
+		}
+
+		auto content = modelsByContent.find(contentHash);
+		if (content != modelsByContent.end()) {
+			if (auto model = content->second.lock()) {
+				contentHits++;
+				modelsByPath[key] = model;
+				std::cout << filePath << " has the same geometry as a resident model, sharing its buffers\n";
+				return model;
+			}
+		}
+
+		// Created under the lock so nobody can find the path or hash before its uploads are recorded
+		misses++;
+		auto model = std::make_unique<VulkanModel>(device, meshView, arena);
+		VkDeviceSize size = model->GetDeviceMemorySize();
+		residentCounters->bytes += size;
+		residentCounters->models++;
+
+		std::shared_ptr<ResidentCounters> counters = residentCounters;
+		std::shared_ptr<VulkanModel> shared{ model.release(), [counters, size](VulkanModel* released) {
+			// Can run on any thread, frames recorded up to now may still draw the model
+			std::unique_lock<std::mutex> lock{ counters->releaseMutex };
+			if (counters->registryAlive) {
+				counters->released[counters->frameIndex].push_back({ released, size });
+				return;
+			}
+			lock.unlock();
+			counters->Destroy(released, size);
+		} };
+
+		EraseExpired(modelsByPath);
+		EraseExpired(modelsByContent);
+		modelsByPath[key] = shared;
+		modelsByContent[contentHash] = shared;
+		return shared;
+	}
+
+	ModelRegistry::Statistics ModelRegistry::GetStatistics() {
+		std::lock_guard<std::mutex> lock{ mutex };
+		Statistics statistics{};
+		statistics.hits = hits;
+		statistics.contentHits = contentHits;
+		statistics.misses = misses;
+		statistics.residentBytes = residentCounters->bytes;
+		statistics.residentModels = residentCounters->models;
+		return statistics;
+	}
+
+	std::shared_ptr<VulkanModel> ModelRegistry::FindLocked(const std::string& key) {
+		auto entry = modelsByPath.find(key);
+		return entry != modelsByPath.end() ? entry->second.lock() : nullptr;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "vulkanModel.h"
+#include "../SwapChain/vulkanSwapChain.h"
+
+namespace lve {
+
+	/*
+	* Hands out shared models so each mesh is resident once. Lookups go by canonical path and load settings,
+	* then by a hash of the vertex and index data, so two files with the same geometry share buffers too.
+	* The registry only keeps weak references. When the last shared_ptr of a model goes away the model is queued on the
+	* frame being recorded and destroyed in BeginFrame once that frame index comes around again, so frames in flight
+	* never draw from freed buffers or arena ranges, and a freed range can't be handed to an upload in the same frame.
+	* Safe to call from several threads, files are parsed in parallel and only buffer creation is serialized.
+	*/
+	class ModelRegistry {
+	public:
+		struct Statistics {
+			uint64_t hits{0};          // Path was already resident
+			uint64_t contentHits{0};   // Different path, same geometry as a resident model
+			uint64_t misses{0};        // Had to create buffers
+			uint64_t residentBytes{0};
+			uint32_t residentModels{0};
+		};
+
+		// Models are created in arena when it is set and has room
+		ModelRegistry(VulkanDevice& device, GeometryArena* arena = nullptr);
+		// Destroys every queued model, the device has to be idle. Models released after this are destroyed right away
+		~ModelRegistry();
+
+		ModelRegistry(const ModelRegistry&) = delete;
+		ModelRegistry& operator=(const ModelRegistry&) = delete;
+
+		// Returns the resident model for filePath or loads it, blocks while loading
+		std::shared_ptr<VulkanModel> Acquire(const std::string& filePath, const ModelLoadSettings& settings = {});
+		// Returns the resident model for filePath without loading, null when there is none
+		std::shared_ptr<VulkanModel> Find(const std::string& filePath, const ModelLoadSettings& settings = {});
+
+		// Destroys the models released the last time frameIndex was recorded, call once that frame's fence has signaled
+		void BeginFrame(uint32_t frameIndex);
+
+		Statistics GetStatistics();
+
+		// Canonical path plus everything in settings that changes the built mesh
+		static std::string MakeKey(const std::string& filePath, const ModelLoadSettings& settings);
+
+	private:
+		// Shared with the deleters of handed out models so they can outlive the registry
+		struct ResidentCounters {
+			std::atomic<uint64_t> bytes{0};
+			std::atomic<uint32_t> models{0};
+
+			// Released models with their size, per frame index they were released in
+			std::mutex releaseMutex;
+			uint32_t frameIndex{0};
+			bool registryAlive{true};
+			std::array<std::vector<std::pair<VulkanModel*, VkDeviceSize>>, vulkanSwapChain::MAX_FRAMES_IN_FLIGHT> released{};
+
+			void Destroy(VulkanModel* model, VkDeviceSize size);
+		};
+
+		std::shared_ptr<VulkanModel> FindLocked(const std::string& key);
+
+		VulkanDevice& device;
+		GeometryArena* arena;
+
+		std::mutex mutex;
+		std::unordered_map<std::string, std::weak_ptr<VulkanModel>> modelsByPath{};
+		std::unordered_map<uint64_t, std::weak_ptr<VulkanModel>> modelsByContent{};
+
+		uint64_t hits{0};
+		uint64_t contentHits{0};
+		uint64_t misses{0};
+		std::shared_ptr<ResidentCounters> residentCounters;
+	};
+}
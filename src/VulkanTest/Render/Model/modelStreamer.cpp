@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+#include "modelStreamer.h"
+#include "../Buffer/vulkanUploadContext.h"
+
+namespace lve {
+
+	ModelStreamer::ModelStreamer(VulkanDevice& device, ModelRegistry& registry, uint32_t threadCount)
+		: device{ device }, registry{ registry } {
+		threadCount = std::max(threadCount, 1u);
+		for (uint32_t i = 0; i < threadCount; i++) {
+			workers.emplace_back(&ModelStreamer::WorkerLoop, this);
+		}
+	}
+
+	ModelStreamer::~ModelStreamer() {
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+		}
+		jobAvailable.notify_all();
+		for (auto& worker : workers) {
+			worker.join();
+		}
+
+		// Models still uploading are freed with the streamer, their copies have to be done first
+		device.getUploadContext().WaitIdle();
+	}
+
+	std::shared_ptr<StreamedModel> ModelStreamer::Load(const std::string& filePath, const ModelLoadSettings& settings) {
+		std::string key = ModelRegistry::MakeKey(filePath, settings);
+
+		std::unique_lock<std::mutex> lock{ mutex };
+		auto handle = handles.find(key);
+		if (handle != handles.end()) {
+			auto streamedModel = handle->second.lock();
+			if (streamedModel && streamedModel->GetState() != StreamedModel::State::Failed) {
+				return streamedModel;
+			}
+		}
+
+		for (auto it = handles.begin(); it != handles.end();) {
+			it = it->second.expired() ? handles.erase(it) : std::next(it);
+		}
+
+		auto streamedModel = std::make_shared<StreamedModel>();
+		streamedModel->filePath = filePath;
+		streamedModel->settings = settings;
+		handles[key] = streamedModel;
+
+		// Already resident through an earlier handle that is gone now, nothing to stream
+		if (auto model = registry.Find(filePath, settings)) {
+			streamedModel->model = std::move(model);
+			streamedModel->uploadBatch = device.getUploadContext().Submit();
+			streamedModel->state.store(StreamedModel::State::Uploading, std::memory_order_release);
+			uploading.push_back(streamedModel);
+			return streamedModel;
+		}
+
+		queued.push_back(streamedModel);
+		lock.unlock();
+		jobAvailable.notify_one();
+		return streamedModel;
+	}
+
+	void ModelStreamer::Update() {
+		std::lock_guard<std::mutex> lock{ mutex };
+		if (uploading.empty()) {
+			return;
+		}
+
+		VulkanUploadContext& uploadContext = device.getUploadContext();
+		uploading.erase(std::remove_if(uploading.begin(), uploading.end(), [&](const std::shared_ptr<StreamedModel>& streamedModel) {
+			if (!uploadContext.IsComplete(streamedModel->uploadBatch)) {
+				return false;
+			}
+			streamedModel->state.store(StreamedModel::State::Resident, std::memory_order_release);
+			return true;
+		}), uploading.end());
+	}
+
+	uint32_t ModelStreamer::GetPendingCount() {
+		std::lock_guard<std::mutex> lock{ mutex };
+		return static_cast<uint32_t>(queued.size() + uploading.size()) + loadingCount;
+	}
+
+	void ModelStreamer::WorkerLoop() {
+		while (true) {
+			std::shared_ptr<StreamedModel> streamedModel;
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				jobAvailable.wait(lock, [&]() { return stopping || !queued.empty(); });
+				if (stopping) {
+					return;
+				}
+				streamedModel = std::move(queued.front());
+				queued.pop_front();
+				loadingCount++;
+			}
+
+			streamedModel->state.store(StreamedModel::State::Loading, std::memory_order_release);
+			try {
+				streamedModel->model = registry.Acquire(streamedModel->filePath, streamedModel->settings);
+				// Sends this model's uploads and whatever other threads recorded with them
+				streamedModel->uploadBatch = device.getUploadContext().Submit();
+			}
+			catch (const std::exception& e) {
+				std::cout << "Failed to stream " << streamedModel->filePath << ": " << e.what() << "\n";
+				streamedModel->model.reset();
+			}
+
+			std::lock_guard<std::mutex> lock{ mutex };
+			loadingCount--;
+			if (streamedModel->model) {
+				streamedModel->state.store(StreamedModel::State::Uploading, std::memory_order_release);
+				uploading.push_back(std::move(streamedModel));
+			}
+			else {
+				streamedModel->state.store(StreamedModel::State::Failed, std::memory_order_release);
+			}
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "vulkanModel.h"
+#include "modelRegistry.h"
+
+namespace lve {
+
+	/*
+	* Model that is loaded by a ModelStreamer thread. Handles are returned right away and never block,
+	* GetModel stays null until the upload fence of the model has signaled.
+	*/
+	class StreamedModel {
+	public:
+		enum class State : uint32_t {
+			Queued,
+			Loading,
+			// Buffers are created, waiting for the upload batch to complete on the GPU
+			Uploading,
+			Resident,
+			Failed
+		};
+
+		State GetState() const { return state.load(std::memory_order_acquire); }
+		bool IsResident() const { return GetState() == State::Resident; }
+		std::shared_ptr<VulkanModel> GetModel() const { return IsResident() ? model : nullptr; }
+		const std::string& GetFilePath() const { return filePath; }
+
+	private:
+		friend class ModelStreamer;
+
+		std::string filePath;
+		ModelLoadSettings settings;
+		std::atomic<State> state{State::Queued};
+		// Written by the loading thread before state leaves Loading
+		std::shared_ptr<VulkanModel> model{};
+		uint64_t uploadBatch{0};
+	};
+
+	/*
+	* Parses, builds and uploads models on background threads so loading never stalls a frame.
+	* Models come from the registry so a file is streamed once no matter how many objects use it.
+	* The threads record into the device upload context and submit their own batches,
+	* Update polls the batch fences on the main thread and marks finished models resident.
+	*/
+	class ModelStreamer {
+	public:
+		ModelStreamer(VulkanDevice& device, ModelRegistry& registry, uint32_t threadCount = 1);
+		~ModelStreamer();
+
+		ModelStreamer(const ModelStreamer&) = delete;
+		ModelStreamer& operator=(const ModelStreamer&) = delete;
+
+		// Queues filePath and returns immediately, loads of the same file that are still alive share one handle
+		std::shared_ptr<StreamedModel> Load(const std::string& filePath, const ModelLoadSettings& settings = {});
+
+		// Promotes models whose upload fence signaled to Resident, never blocks. Call once per frame
+		void Update();
+
+		uint32_t GetPendingCount();
+
+	private:
+		void WorkerLoop();
+
+		VulkanDevice& device;
+		ModelRegistry& registry;
+
+		std::mutex mutex;
+		std::condition_variable jobAvailable;
+		std::deque<std::shared_ptr<StreamedModel>> queued{};
+		std::vector<std::shared_ptr<StreamedModel>> uploading{};
+		std::unordered_map<std::string, std::weak_ptr<StreamedModel>> handles{};
+		uint32_t loadingCount{0};
+		bool stopping{false};
+
+		std::vector<std::thread> workers{};
+	};
+}
@@ -0,0 +1,476 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#include "objParser.h"
+
+namespace lve {
+
+	namespace {
+		// Smaller chunks cost more in thread startup than they save
+		constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+		constexpr unsigned CHUNKS_PER_THREAD = 4;
+		constexpr size_t NO_INVALID_INDEX = SIZE_MAX;
+
+		struct ObjChunk {
+			const char* begin = nullptr;
+			const char* end = nullptr;
+
+			std::vector<float> vertices{};
+			std::vector<float> colors{};
+			std::vector<float> normals{};
+			std::vector<float> texcoords{};
+			std::vector<ObjIndex> indices{};
+
+			// Negative OBJ indices are relative to the elements read so far, which a chunk only knows
+			// locally. These are (indexPosition * 3 + component) of the ones that need the chunk offset added
+			std::vector<size_t> relativeIndices{};
+
+			size_t vertexOffset = 0;
+			size_t normalOffset = 0;
+			size_t texcoordOffset = 0;
+			size_t indexOffset = 0;
+
+			// First position in indices that is out of range once merged, NO_INVALID_INDEX if there is none
+			size_t invalidIndex = NO_INVALID_INDEX;
+		};
+
+		struct FaceCorner {
+			ObjIndex index;
+			uint8_t relativeMask;
+		};
+
+		void ParallelFor(size_t count, unsigned threadCount, const std::function<void(size_t)>& function) {
+			if (threadCount <= 1 || count <= 1) {
+				for (size_t i = 0; i < count; i++) {
+					function(i);
+				}
+				return;
+			}
+
+			std::atomic<size_t> next{0};
+			auto worker = [&]() {
+				for (size_t i = next++; i < count; i = next++) {
+					function(i);
+				}
+			};
+
+			std::vector<std::thread> workers{};
+			size_t workerCount = std::min<size_t>(threadCount, count);
+			for (size_t i = 1; i < workerCount; i++) {
+				workers.emplace_back(worker);
+			}
+			worker();
+
+			for (auto& thread : workers) {
+				thread.join();
+			}
+		}
+
+		bool IsSpace(char c) {
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		bool IsDigit(char c) {
+			return c >= '0' && c <= '9';
+		}
+
+		const char* SkipSpace(const char* p, const char* end) {
+			while (p < end && IsSpace(*p)) {
+				p++;
+			}
+			return p;
+		}
+
+		double PowerOfTen(int exponent) {
+			//Every power up to 22 is exact in a double
+			static const double powers[] = {
+				1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+			};
+			double result = 1.0;
+			while (exponent > 22) {
+				result *= powers[22];
+				exponent -= 22;
+			}
+			return result * powers[exponent];
+		}
+
+		// Enough of strtod for OBJ numbers, without the locale lookup or the null terminator requirement
+		bool ParseFloat(const char*& p, const char* end, float& out) {
+			const char* s = p;
+			bool negative = false;
+			if (s < end && (*s == '-' || *s == '+')) {
+				negative = *s == '-';
+				s++;
+			}
+
+			uint64_t mantissa = 0;
+			int exponent = 0;
+			int significantDigits = 0;
+			bool hasDigits = false;
+
+			for (; s < end && IsDigit(*s); s++) {
+				hasDigits = true;
+				if (significantDigits < 19) {
+					mantissa = mantissa * 10 + static_cast<uint64_t>(*s - '0');
+					significantDigits += mantissa != 0;
+				}
+				else {
+					exponent++;
+				}
+			}
+			if (s < end && *s == '.') {
+				for (s++; s < end && IsDigit(*s); s++) {
+					hasDigits = true;
+					if (significantDigits < 19) {
+						mantissa = mantissa * 10 + static_cast<uint64_t>(*s - '0');
+						significantDigits += mantissa != 0;
+						exponent--;
+					}
+				}
+			}
+			if (!hasDigits) {
+				return false;
+			}
+
+			if (s < end && (*s == 'e' || *s == 'E')) {
+				const char* e = s + 1;
+				bool negativeExponent = false;
+				if (e < end && (*e == '-' || *e == '+')) {
+					negativeExponent = *e == '-';
+					e++;
+				}
+				if (e < end && IsDigit(*e)) {
+					int value = 0;
+					for (; e < end && IsDigit(*e); e++) {
+						if (value < 10000) {
+							value = value * 10 + (*e - '0');
+						}
+					}
+					exponent += negativeExponent ? -value : value;
+					s = e;
+				}
+			}
+
+			double value = static_cast<double>(mantissa);
+			if (exponent < 0) {
+				value /= PowerOfTen(std::min(-exponent, 400));
+			}
+			else if (exponent > 0) {
+				value *= PowerOfTen(std::min(exponent, 400));
+			}
+
+			out = static_cast<float>(negative ? -value : value);
+			p = s;
+			return true;
+		}
+
+		bool ParseInt(const char*& p, const char* end, int& out) {
+			const char* s = p;
+			bool negative = false;
+			if (s < end && (*s == '-' || *s == '+')) {
+				negative = *s == '-';
+				s++;
+			}
+			if (s >= end || !IsDigit(*s)) {
+				return false;
+			}
+			int64_t value = 0;
+			for (; s < end && IsDigit(*s); s++) {
+				if (value <= INT32_MAX) {
+					value = value * 10 + (*s - '0');
+				}
+			}
+			value = std::min<int64_t>(value, INT32_MAX);
+			out = static_cast<int>(negative ? -value : value);
+			p = s;
+			return true;
+		}
+
+		// Reads up to maxCount floats and returns how many were found
+		int ParseFloats(const char* p, const char* end, float* values, int maxCount) {
+			int count = 0;
+			p = SkipSpace(p, end);
+			while (count < maxCount && p < end && ParseFloat(p, end, values[count])) {
+				count++;
+				p = SkipSpace(p, end);
+			}
+			return count;
+		}
+
+		// Converts a 1 based (or negative relative) OBJ index to 0 based, -1 if missing
+		int ResolveIndex(int rawIndex, size_t elementCount, bool& relative) {
+			relative = false;
+			if (rawIndex > 0) {
+				return rawIndex - 1;
+			}
+			if (rawIndex < 0) {
+				relative = true;
+				return static_cast<int>(elementCount) + rawIndex;
+			}
+			return -1;
+		}
+
+		void ParseFace(ObjChunk& chunk, const char* p, const char* end, std::vector<FaceCorner>& face) {
+			face.clear();
+
+			p = SkipSpace(p, end);
+			while (p < end) {
+				int raw[3] = { 0, 0, 0 }; // v, vt, vn
+
+				if (!ParseInt(p, end, raw[0])) {
+					break;
+				}
+				if (p < end && *p == '/') {
+					p++;
+					ParseInt(p, end, raw[1]);
+					if (p < end && *p == '/') {
+						p++;
+						ParseInt(p, end, raw[2]);
+					}
+				}
+
+				FaceCorner corner{};
+				bool relative = false;
+				corner.index.vertexIndex = ResolveIndex(raw[0], chunk.vertices.size() / 3, relative);
+				corner.relativeMask |= relative ? 1 : 0;
+				corner.index.normalIndex = ResolveIndex(raw[2], chunk.normals.size() / 3, relative);
+				corner.relativeMask |= relative ? 2 : 0;
+				corner.index.texcoordIndex = ResolveIndex(raw[1], chunk.texcoords.size() / 2, relative);
+				corner.relativeMask |= relative ? 4 : 0;
+				face.push_back(corner);
+
+				while (p < end && !IsSpace(*p)) {
+					p++;
+				}
+				p = SkipSpace(p, end);
+			}
+
+			auto emit = [&chunk](const FaceCorner& corner) {
+				size_t position = chunk.indices.size() * 3;
+				for (size_t component = 0; component < 3; component++) {
+					if (corner.relativeMask & (1 << component)) {
+						chunk.relativeIndices.push_back(position + component);
+					}
+				}
+				chunk.indices.push_back(corner.index);
+			};
+
+			for (size_t i = 2; i < face.size(); i++) {
+				emit(face[0]);
+				emit(face[i - 1]);
+				emit(face[i]);
+			}
+		}
+
+		void ParseChunk(ObjChunk& chunk) {
+			std::vector<FaceCorner> face{};
+			float values[7];
+
+			const char* p = chunk.begin;
+			const char* end = chunk.end;
+			while (p < end) {
+				const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+				if (lineEnd == nullptr) {
+					lineEnd = end;
+				}
+
+				p = SkipSpace(p, lineEnd);
+				if (lineEnd - p >= 2) {
+					if (p[0] == 'v' && IsSpace(p[1])) {
+						// "v x y z" or "v x y z r g b"
+						int count = ParseFloats(p + 2, lineEnd, values, 7);
+						for (int i = count; i < 3; i++) {
+							values[i] = 0.f;
+						}
+						chunk.vertices.insert(chunk.vertices.end(), values, values + 3);
+						if (count >= 6) {
+							chunk.colors.insert(chunk.colors.end(), values + 3, values + 6);
+						}
+						else {
+							chunk.colors.insert(chunk.colors.end(), { 1.f, 1.f, 1.f });
+						}
+					}
+					else if (p[0] == 'v' && p[1] == 'n' && lineEnd - p >= 3 && IsSpace(p[2])) {
+						int count = ParseFloats(p + 3, lineEnd, values, 3);
+						for (int i = count; i < 3; i++) {
+							values[i] = 0.f;
+						}
+						chunk.normals.insert(chunk.normals.end(), values, values + 3);
+					}
+					else if (p[0] == 'v' && p[1] == 't' && lineEnd - p >= 3 && IsSpace(p[2])) {
+						int count = ParseFloats(p + 3, lineEnd, values, 2);
+						for (int i = count; i < 2; i++) {
+							values[i] = 0.f;
+						}
+						chunk.texcoords.insert(chunk.texcoords.end(), values, values + 2);
+					}
+					else if (p[0] == 'f' && IsSpace(p[1])) {
+						ParseFace(chunk, p + 2, lineEnd, face);
+					}
+				}
+
+				p = lineEnd + 1;
+			}
+		}
+
+		// Slow path for error messages, finds the f line that produced chunk.indices[indexPosition]
+		const char* FindFaceLine(const ObjChunk& chunk, size_t indexPosition) {
+			ObjChunk scratch{};
+			std::vector<FaceCorner> face{};
+
+			const char* p = chunk.begin;
+			while (p < chunk.end) {
+				const char* lineStart = p;
+				const char* lineEnd = static_cast<const char*>(memchr(p, '\n', chunk.end - p));
+				if (lineEnd == nullptr) {
+					lineEnd = chunk.end;
+				}
+
+				p = SkipSpace(p, lineEnd);
+				if (lineEnd - p >= 2 && p[0] == 'f' && IsSpace(p[1])) {
+					ParseFace(scratch, p + 2, lineEnd, face);
+					if (scratch.indices.size() > indexPosition) {
+						return lineStart;
+					}
+				}
+
+				p = lineEnd + 1;
+			}
+			return chunk.end;
+		}
+
+		bool IsValidIndex(int index, size_t elementCount, bool required) {
+			if (index < 0) {
+				return !required && index == -1;
+			}
+			return static_cast<size_t>(index) < elementCount;
+		}
+
+		template<typename T>
+		void CopyInto(std::vector<T>& destination, const std::vector<T>& source, size_t offset) {
+			if (!source.empty()) {
+				std::copy(source.begin(), source.end(), destination.begin() + offset);
+			}
+		}
+	}
+
+	ObjData ObjParser::ParseFile(const std::string& filePath, unsigned threadCount) {
+		std::ifstream file{ filePath, std::ios::ate | std::ios::binary };
+
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open file: " + filePath);
+		}
+
+		size_t fileSize = static_cast<size_t>(file.tellg());
+
+		std::vector<char> buffer(fileSize);
+
+		file.seekg(0);
+		file.read(buffer.data(), fileSize);
+
+		file.close();
+
+		return ParseBuffer(buffer.data(), buffer.size(), threadCount, filePath);
+	}
+
+	ObjData ObjParser::ParseBuffer(const char* data, size_t size, unsigned threadCount, const std::string& sourceName) {
+		if (threadCount == 0) {
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		size_t chunkCount = std::max<size_t>(1, size / MIN_CHUNK_SIZE);
+		chunkCount = std::min<size_t>(chunkCount, static_cast<size_t>(threadCount) * CHUNKS_PER_THREAD);
+
+		// Split at the first line break after each even split point
+		std::vector<ObjChunk> chunks(chunkCount);
+		const char* end = data + size;
+		const char* begin = data;
+		for (size_t i = 0; i < chunkCount; i++) {
+			const char* split = end;
+			if (i + 1 < chunkCount) {
+				split = std::max(begin, data + (size * (i + 1)) / chunkCount);
+				const char* lineBreak = static_cast<const char*>(memchr(split, '\n', end - split));
+				split = lineBreak ? lineBreak + 1 : end;
+			}
+			chunks[i].begin = begin;
+			chunks[i].end = split;
+			begin = split;
+		}
+
+		ParallelFor(chunkCount, threadCount, [&chunks](size_t i) { ParseChunk(chunks[i]); });
+
+		// Prefix sums in file order keep the merged output deterministic
+		size_t vertexCount = 0;
+		size_t normalCount = 0;
+		size_t texcoordCount = 0;
+		size_t indexCount = 0;
+		for (auto& chunk : chunks) {
+			chunk.vertexOffset = vertexCount;
+			chunk.normalOffset = normalCount;
+			chunk.texcoordOffset = texcoordCount;
+			chunk.indexOffset = indexCount;
+			vertexCount += chunk.vertices.size() / 3;
+			normalCount += chunk.normals.size() / 3;
+			texcoordCount += chunk.texcoords.size() / 2;
+			indexCount += chunk.indices.size();
+		}
+
+		ObjData objData{};
+		objData.vertices.resize(vertexCount * 3);
+		objData.colors.resize(vertexCount * 3);
+		objData.normals.resize(normalCount * 3);
+		objData.texcoords.resize(texcoordCount * 2);
+		objData.indices.resize(indexCount);
+
+		ParallelFor(chunkCount, threadCount, [&](size_t i) {
+			ObjChunk& chunk = chunks[i];
+
+			for (size_t position : chunk.relativeIndices) {
+				ObjIndex& index = chunk.indices[position / 3];
+				int* value = nullptr;
+				switch (position % 3) {
+				case 0: value = &index.vertexIndex; *value += static_cast<int>(chunk.vertexOffset); break;
+				case 1: value = &index.normalIndex; *value += static_cast<int>(chunk.normalOffset); break;
+				case 2: value = &index.texcoordIndex; *value += static_cast<int>(chunk.texcoordOffset); break;
+				}
+				// Reaching back past the start of the file, even to -1 which would otherwise read as missing
+				if (*value < 0) {
+					chunk.invalidIndex = std::min(chunk.invalidIndex, position / 3);
+				}
+			}
+
+			for (size_t position = 0; position < chunk.indices.size() && position < chunk.invalidIndex; position++) {
+				const ObjIndex& index = chunk.indices[position];
+				if (!IsValidIndex(index.vertexIndex, vertexCount, true) ||
+					!IsValidIndex(index.normalIndex, normalCount, false) ||
+					!IsValidIndex(index.texcoordIndex, texcoordCount, false)) {
+					chunk.invalidIndex = position;
+				}
+			}
+
+			CopyInto(objData.vertices, chunk.vertices, chunk.vertexOffset * 3);
+			CopyInto(objData.colors, chunk.colors, chunk.vertexOffset * 3);
+			CopyInto(objData.normals, chunk.normals, chunk.normalOffset * 3);
+			CopyInto(objData.texcoords, chunk.texcoords, chunk.texcoordOffset * 2);
+			CopyInto(objData.indices, chunk.indices, chunk.indexOffset);
+		});
+
+		// Out of range indices would be read unchecked when the vertices are built
+		for (const auto& chunk : chunks) {
+			if (chunk.invalidIndex != NO_INVALID_INDEX) {
+				const char* line = FindFaceLine(chunk, chunk.invalidIndex);
+				size_t lineNumber = 1 + std::count(data, line, '\n');
+				throw std::runtime_error("failed to parse " + sourceName + ": face index out of range on line " + std::to_string(lineNumber));
+			}
+		}
+
+		return objData;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	// Same layout as tinyobj::index_t, -1 means the attribute is missing
+	struct ObjIndex {
+		int vertexIndex;
+		int normalIndex;
+		int texcoordIndex;
+	};
+
+	// Flat attribute arrays in the same shape as tinyobj::attrib_t so LoadModel can use either
+	struct ObjData {
+		std::vector<float> vertices{};  // xyz
+		std::vector<float> colors{};    // rgb, 1.0 when the file has no vertex colors
+		std::vector<float> normals{};   // xyz
+		std::vector<float> texcoords{}; // uv
+
+		// Faces are fan triangulated so every 3 indices is one triangle
+		std::vector<ObjIndex> indices{};
+	};
+
+	/*
+	* Parses v/vn/vt/f records of an OBJ file.
+	* The file is split into line aligned chunks that are parsed on worker threads,
+	* the chunks are then merged in file order so the output does not depend on thread count.
+	* Face indices are checked against the merged element counts, an index out of range throws with its line.
+	*/
+	class ObjParser {
+	public:
+		// threadCount 0 means std::thread::hardware_concurrency()
+		static ObjData ParseFile(const std::string& filePath, unsigned threadCount = 0);
+		// sourceName is only used in error messages
+		static ObjData ParseBuffer(const char* data, size_t size, unsigned threadCount = 0, const std::string& sourceName = "OBJ buffer");
+	};
+}
@@ -0,0 +1,177 @@
+#include <cstring>
+
+#include "vertexDedup.h"
+
+namespace lve {
+
+	namespace {
+		size_t NextPowerOfTwo(size_t value) {
+			size_t result = 16;
+			while (result < value) {
+				result <<= 1;
+			}
+			return result;
+		}
+
+		// Murmur3 finalizer
+		uint32_t Mix(uint32_t hash) {
+			hash ^= hash >> 16;
+			hash *= 0x85ebca6b;
+			hash ^= hash >> 13;
+			hash *= 0xc2b2ae35;
+			hash ^= hash >> 16;
+			return hash;
+		}
+
+		uint32_t HashCorner(int vertexIndex, int normalIndex, int texcoordIndex) {
+			uint32_t hash = static_cast<uint32_t>(vertexIndex) * 0x9e3779b1u;
+			hash ^= static_cast<uint32_t>(normalIndex) * 0x85ebca77u;
+			hash ^= static_cast<uint32_t>(texcoordIndex) * 0xc2b2ae3du;
+			return Mix(hash);
+		}
+
+		uint32_t HashVertex(const VulkanModel::Vertex& vertex) {
+			const float values[] = {
+				vertex.position.x, vertex.position.y, vertex.position.z,
+				vertex.color.x, vertex.color.y, vertex.color.z,
+				vertex.normal.x, vertex.normal.y, vertex.normal.z,
+				vertex.uv.x, vertex.uv.y
+			};
+
+			uint32_t hash = 0x811c9dc5u;
+			for (float value : values) {
+				// -0.0 == 0.0 for operator== so they have to hash the same
+				uint32_t bits = 0;
+				if (value != 0.f) {
+					memcpy(&bits, &value, sizeof(bits));
+				}
+				hash = (hash ^ bits) * 0x01000193u;
+				hash ^= hash >> 15;
+			}
+			return Mix(hash);
+		}
+
+		VulkanModel::Vertex MakeVertex(const ObjIndex& index, const ObjData& objData) {
+			VulkanModel::Vertex vertex{};
+
+			if (index.vertexIndex >= 0) {
+				vertex.position = {
+					objData.vertices[3 * index.vertexIndex + 0],
+					objData.vertices[3 * index.vertexIndex + 1],
+					objData.vertices[3 * index.vertexIndex + 2]
+				};
+
+				vertex.color = {
+					objData.colors[3 * index.vertexIndex + 0],
+					objData.colors[3 * index.vertexIndex + 1],
+					objData.colors[3 * index.vertexIndex + 2]
+				};
+			}
+			if (index.normalIndex >= 0) {
+				vertex.normal = {
+					objData.normals[3 * index.normalIndex + 0],
+					objData.normals[3 * index.normalIndex + 1],
+					objData.normals[3 * index.normalIndex + 2]
+				};
+			}
+			if (index.texcoordIndex >= 0) {
+				vertex.uv = {
+					objData.texcoords[2 * index.texcoordIndex + 0],
+					objData.texcoords[2 * index.texcoordIndex + 1]
+				};
+			}
+
+			return vertex;
+		}
+	}
+
+	VertexDedupTable::VertexDedupTable(size_t expectedVertexCount) {
+		size_t capacity = NextPowerOfTwo(expectedVertexCount * 2);
+		cornerSlots.assign(capacity, CornerSlot{ 0, 0, 0, EMPTY });
+		vertexSlots.assign(capacity, VertexSlot{ 0, EMPTY });
+	}
+
+	uint32_t VertexDedupTable::FindOrAdd(const ObjIndex& index, const ObjData& objData, std::vector<VulkanModel::Vertex>& vertices) {
+		if ((cornerCount + 1) * 4 > cornerSlots.size() * 3) {
+			GrowCorners();
+		}
+
+		size_t mask = cornerSlots.size() - 1;
+		size_t slot = HashCorner(index.vertexIndex, index.normalIndex, index.texcoordIndex) & mask;
+		while (true) {
+			CornerSlot& corner = cornerSlots[slot];
+			if (corner.value == EMPTY) {
+				corner.vertexIndex = index.vertexIndex;
+				corner.normalIndex = index.normalIndex;
+				corner.texcoordIndex = index.texcoordIndex;
+				corner.value = FindOrAddVertex(MakeVertex(index, objData), vertices);
+				cornerCount++;
+				return corner.value;
+			}
+			if (corner.vertexIndex == index.vertexIndex &&
+				corner.normalIndex == index.normalIndex &&
+				corner.texcoordIndex == index.texcoordIndex) {
+				return corner.value;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+
+	uint32_t VertexDedupTable::FindOrAddVertex(const VulkanModel::Vertex& vertex, std::vector<VulkanModel::Vertex>& vertices) {
+		if ((vertexCount + 1) * 4 > vertexSlots.size() * 3) {
+			GrowVertices();
+		}
+
+		uint32_t hash = HashVertex(vertex);
+		size_t mask = vertexSlots.size() - 1;
+		size_t slot = hash & mask;
+		while (true) {
+			VertexSlot& entry = vertexSlots[slot];
+			if (entry.value == EMPTY) {
+				entry.hash = hash;
+				entry.value = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(vertex);
+				vertexCount++;
+				return entry.value;
+			}
+			if (entry.hash == hash && vertices[entry.value] == vertex) {
+				return entry.value;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+
+	void VertexDedupTable::GrowCorners() {
+		std::vector<CornerSlot> oldSlots(cornerSlots.size() * 2, CornerSlot{ 0, 0, 0, EMPTY });
+		oldSlots.swap(cornerSlots);
+
+		size_t mask = cornerSlots.size() - 1;
+		for (const auto& corner : oldSlots) {
+			if (corner.value == EMPTY) {
+				continue;
+			}
+			size_t slot = HashCorner(corner.vertexIndex, corner.normalIndex, corner.texcoordIndex) & mask;
+			while (cornerSlots[slot].value != EMPTY) {
+				slot = (slot + 1) & mask;
+			}
+			cornerSlots[slot] = corner;
+		}
+	}
+
+	void VertexDedupTable::GrowVertices() {
+		std::vector<VertexSlot> oldSlots(vertexSlots.size() * 2, VertexSlot{ 0, EMPTY });
+		oldSlots.swap(vertexSlots);
+
+		size_t mask = vertexSlots.size() - 1;
+		for (const auto& entry : oldSlots) {
+			if (entry.value == EMPTY) {
+				continue;
+			}
+			size_t slot = entry.hash & mask;
+			while (vertexSlots[slot].value != EMPTY) {
+				slot = (slot + 1) & mask;
+			}
+			vertexSlots[slot] = entry;
+		}
+	}
+}
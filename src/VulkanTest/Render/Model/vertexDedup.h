@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vulkanModel.h"
+#include "objParser.h"
+
+namespace lve {
+
+	/*
+	* Flat open addressing tables used by Builder::LoadModel to turn OBJ corners into unique vertices.
+	* Corners are looked up by their v/vn/vt index triple first, which is one probe per corner in the common case.
+	* Only a new triple builds the full vertex and checks it against the vertex table, so different triples
+	* that end up with identical vertex data still share one vertex.
+	* Slots live in two arrays that are sized up front and only grow past 75% load, nothing is allocated per vertex.
+	*/
+	class VertexDedupTable {
+		static constexpr uint32_t EMPTY = UINT32_MAX;
+
+		struct CornerSlot {
+			int vertexIndex;
+			int normalIndex;
+			int texcoordIndex;
+			uint32_t value;
+		};
+
+		struct VertexSlot {
+			uint32_t hash;
+			uint32_t value;
+		};
+
+		std::vector<CornerSlot> cornerSlots{};
+		size_t cornerCount{0};
+
+		std::vector<VertexSlot> vertexSlots{};
+		size_t vertexCount{0};
+
+		void GrowCorners();
+		void GrowVertices();
+
+		uint32_t FindOrAddVertex(const VulkanModel::Vertex& vertex, std::vector<VulkanModel::Vertex>& vertices);
+
+	public:
+		explicit VertexDedupTable(size_t expectedVertexCount);
+
+		// Returns the index into vertices for this corner, appending the vertex if it has not been seen
+		uint32_t FindOrAdd(const ObjIndex& index, const ObjData& objData, std::vector<VulkanModel::Vertex>& vertices);
+	};
+}
@@ -1,68 +1,227 @@
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <iostream>
-#include <unordered_map>
 
 
 #include "vulkanModel.h"
-#include "../utils.h"
-
+#include "../Buffer/vulkanUploadContext.h"
+#include "geometryArena.h"
+#include "meshCache.h"
+#include "meshletBuilder.h"
+#include "meshOptimizer.h"
+#include "meshSimplifier.h"
+#include "objParser.h"
+#include "vertexDedup.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// Define LVE_USE_TINYOBJ to load through tinyobjloader instead of ObjParser, for comparing load times
+#ifdef LVE_USE_TINYOBJ
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
-#define GLM_ENABLE_EXPERIMENTAL
-#include "glm/gtx/hash.hpp"
+#endif
+
+namespace lve {
+
+	namespace {
+		// Below this many indices per submesh the extra draws cost more than the halved index fetch saves
+		constexpr uint32_t MIN_INDICES_PER_SUBMESH = 3 * 8192;
 
+		// Triangle count of each LOD relative to LOD 0
+		constexpr float LOD_RATIOS[] = { 0.5f, 0.25f, 0.125f };
+		// No LOD may be further than this fraction of the bounds diagonal from LOD 0
+		constexpr float MAX_LOD_ERROR = 0.05f;
+		// A LOD that keeps more than this fraction of the previous one is not worth a level
+		constexpr float MIN_LOD_REDUCTION = 0.9f;
 
-namespace std {
-	template<>
-	struct hash<lve::VulkanModel::Vertex> 
-	{
-		size_t operator()(lve::VulkanModel::Vertex const& vertex) const 
-		{
-			size_t seed = 0;
-			lve::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-			return seed;
+		uint16_t EncodeUnorm16(float value) {
+			return static_cast<uint16_t>(std::lround(std::clamp(value, 0.f, 1.f) * 65535.f));
 		}
-	};
-}
 
-namespace lve {
+		int16_t EncodeSnorm16(float value) {
+			return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+		}
+
+		uint8_t EncodeUnorm8(float value) {
+			return static_cast<uint8_t>(std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+		}
+
+		// Folds the lower hemisphere over the diagonals, OctDecode in simpleShaderCompact.vert undoes it
+		glm::vec2 OctEncode(glm::vec3 normal) {
+			float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+			if (length == 0.f) {
+				return glm::vec2{0.f};
+			}
+			normal /= length;
+
+			glm::vec2 encoded{normal.x, normal.y};
+			if (normal.z < 0.f) {
+				encoded.x = (1.f - std::abs(normal.y)) * (normal.x >= 0.f ? 1.f : -1.f);
+				encoded.y = (1.f - std::abs(normal.x)) * (normal.y >= 0.f ? 1.f : -1.f);
+			}
+			return encoded;
+		}
+	}
 
 	//NOTE TO SELF CHECK VULKAN DEVICE IF ERROR
-	VulkanModel::VulkanModel(VulkanDevice& device, const VulkanModel::Builder & builder) : vulkanDevice{device} {
-		CreateVertexBuffers(builder.vertices);
-		CreateIndexBuffers(builder.indicies);
+	VulkanModel::VulkanModel(VulkanDevice& device, const VulkanModel::Builder & builder) : VulkanModel{device, builder.GetMeshView()} {}
+
+	// Models are created on the streaming threads as well
+	static std::atomic<uint32_t> nextSortId{0};
+
+	VulkanModel::VulkanModel(VulkanDevice& device, const VulkanModel::MeshView& meshView, GeometryArena* geometryArena)
+		: vulkanDevice{device}, sortId{nextSortId.fetch_add(1, std::memory_order_relaxed)} {
+		minBounds = meshView.minBounds;
+		maxBounds = meshView.maxBounds;
+		sphereCenter = meshView.sphereCenter;
+		sphereRadius = meshView.sphereRadius;
+		vertexLayout = meshView.vertexLayout;
+
+		if (geometryArena == nullptr || !AllocateInArena(*geometryArena, meshView)) {
+			CreateVertexBuffers(meshView.vertices, meshView.vertexCount);
+			CreateIndexBuffers(meshView.indicies, meshView.indexCount, meshView.indexSize);
+		}
+
+		if (meshView.lodCount > 0) {
+			lods.assign(meshView.lods, meshView.lods + meshView.lodCount);
+		}
+		else {
+			lods.push_back({ 0, meshView.indexCount, 0.f });
+		}
+
+		if (meshView.submeshCount > 0) {
+			submeshes.assign(meshView.submeshes, meshView.submeshes + meshView.submeshCount);
+		}
+		else {
+			for (const auto& lod : lods) {
+				submeshes.push_back({ lod.firstIndex, lod.indexCount, 0 });
+			}
+		}
+
+		for (auto& lod : lods) {
+			lod.firstIndex += baseIndex;
+		}
+		for (auto& submesh : submeshes) {
+			submesh.firstIndex += baseIndex;
+			submesh.vertexOffset += static_cast<int32_t>(baseVertex);
+		}
+
+		// Submeshes never straddle a LOD boundary so each LOD is a run of them
+		for (const auto& lod : lods) {
+			uint32_t first = 0;
+			while (first < submeshes.size() && submeshes[first].firstIndex < lod.firstIndex) {
+				first++;
+			}
+			uint32_t count = 0;
+			while (first + count < submeshes.size() && submeshes[first + count].firstIndex < lod.firstIndex + lod.indexCount) {
+				count++;
+			}
+			lodFirstSubmesh.push_back(first);
+			lodSubmeshCount.push_back(count);
+		}
+
+		CreateMeshletBuffers(meshView);
 	}
-	VulkanModel::~VulkanModel() {}
+	VulkanModel::~VulkanModel() {
+		if (arena != nullptr) {
+			arena->Free({ baseVertex, vertexCount, baseIndex, indexCount, indexType });
+		}
+	}
+
+	std::unique_ptr<VulkanModel> VulkanModel::CreateModelFromDevice(
+		VulkanDevice& device,
+		const std::string& filePath,
+		const ModelLoadSettings& settings,
+		GeometryArena* arena) {
+
+		// The mesh data has to outlive the upload, the model copies out of it in the constructor
+		MeshData meshData = LoadMeshData(filePath, settings);
+		return std::make_unique<VulkanModel>(device, meshData.GetMeshView(), arena);
+	}
+
+	VulkanModel::MeshData VulkanModel::LoadMeshData(const std::string& filePath, const ModelLoadSettings& settings) {
+		MeshData meshData{};
+		std::string cachePath = MeshCache::GetCachePath(filePath, settings);
 
-	std::unique_ptr<VulkanModel> VulkanModel::CreateModelFromDevice(VulkanDevice& device, const std::string& filePath) {
-		Builder builder{};
+		auto loadStart = std::chrono::high_resolution_clock::now();
+		if (auto meshCache = MeshCache::Open(cachePath, filePath, settings)) {
+			MeshView meshView = meshCache->GetMeshView();
+			auto loadEnd = std::chrono::high_resolution_clock::now();
 
+			std::cout << "Vertex count: " << meshView.vertexCount << "\n";
+			std::cout << "Loaded " << filePath << " warm in "
+				<< std::chrono::duration<float, std::chrono::milliseconds::period>(loadEnd - loadStart).count() << "ms"
+				<< " (cold " << meshCache->GetColdLoadMilliseconds() << "ms)\n";
+
+			meshData.cache = std::move(meshCache);
+			return meshData;
+		}
+
+		Builder& builder = meshData.builder;
 		builder.LoadModel(filePath);
 
+		if (settings.optimizeMesh) {
+			VertexCacheStatistics before = MeshOptimizer::AnalyzeVertexCache(builder.indicies, builder.vertices.size());
+			builder.Optimize();
+			VertexCacheStatistics after = MeshOptimizer::AnalyzeVertexCache(builder.indicies, builder.vertices.size());
+
+			std::cout << "Optimized " << filePath << " ACMR " << before.acmr << " -> " << after.acmr
+				<< ", ATVR " << before.atvr << " -> " << after.atvr << "\n";
+		}
+		if (settings.buildLods) {
+			builder.BuildLods();
+			std::cout << "Built " << builder.lods.size() << " LODs for " << filePath << "\n";
+		}
+		if (settings.vertexLayout == VertexLayout::Compact) {
+			builder.Quantize();
+		}
+		builder.SelectIndexType();
+		if (settings.buildMeshlets) {
+			builder.BuildMeshlets();
+			std::cout << "Built " << builder.meshlets.size() << " meshlets for " << filePath << "\n";
+		}
+		auto loadEnd = std::chrono::high_resolution_clock::now();
+		float coldLoadMilliseconds = std::chrono::duration<float, std::chrono::milliseconds::period>(loadEnd - loadStart).count();
+
 		std::cout << "Vertex count: " << builder.vertices.size() << "\n";
+		std::cout << "Loaded " << filePath << " cold in " << coldLoadMilliseconds << "ms, "
+			<< (builder.shortIndicies.empty() ? 32 : 16) << " bit indices in " << std::max<size_t>(builder.submeshes.size(), 1) << " submeshes\n";
 
-		return std::make_unique<VulkanModel>(device, builder);
+		MeshCache::Write(cachePath, filePath, builder, coldLoadMilliseconds, settings);
+
+		return meshData;
 	}
 
-	void VulkanModel::CreateVertexBuffers(const std::vector<Vertex>& vertices) {
-		vertexCount = static_cast<uint32_t>(vertices.size());
+	VulkanModel::MeshView VulkanModel::MeshData::GetMeshView() const {
+		return cache ? cache->GetMeshView() : builder.GetMeshView();
+	}
 
-		assert(vertexCount >= 3 && "vertex count must be atleast 3");
+	VkDeviceSize VulkanModel::GetDeviceMemorySize() const {
+		VkDeviceSize size = 0;
+		if (arena != nullptr) {
+			VkDeviceSize indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+			size += static_cast<VkDeviceSize>(GetVertexStride(vertexLayout)) * vertexCount + indexSize * indexCount;
+		}
+		for (const VulkanBuffer* buffer : { vertexBuffer.get(), indexBuffer.get(), meshletBuffer.get(),
+			meshletBoundsBuffer.get(), meshletVertexBuffer.get(), meshletTriangleBuffer.get() }) {
+			if (buffer != nullptr) {
+				size += buffer->GetBufferSize();
+			}
+		}
+		return size;
+	}
 
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
+	void VulkanModel::CreateVertexBuffers(const void* vertices, uint32_t vertexCount) {
+		this->vertexCount = vertexCount;
 
-		uint32_t vertexSize = sizeof(vertices[0]);
+		assert(vertexCount >= 3 && "vertex count must be atleast 3");
 
-		VulkanBuffer stagingBuffer{
-			vulkanDevice,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
+		uint32_t vertexSize = GetVertexStride(vertexLayout);
 
-		stagingBuffer.Map();
-		stagingBuffer.WriteToBuffer((void*) vertices.data());
+		VkDeviceSize bufferSize = static_cast<VkDeviceSize>(vertexSize) * vertexCount;
 
 		vertexBuffer = std::make_unique<VulkanBuffer>
 			(
@@ -73,11 +232,11 @@ namespace lve {
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 			); 
 
-		vulkanDevice.copyBuffer(stagingBuffer.GetBuffer(), vertexBuffer->GetBuffer(), bufferSize);
+		vulkanDevice.getUploadContext().UploadBuffer(vertexBuffer->GetBuffer(), vertices, bufferSize);
 	}
 
-	void VulkanModel::CreateIndexBuffers(const std::vector<uint32_t>& indecies) {
-		indexCount = static_cast<uint32_t>(indecies.size());
+	void VulkanModel::CreateIndexBuffers(const void* indicies, uint32_t indexCount, uint32_t indexSize) {
+		this->indexCount = indexCount;
 
 		hasIndexBuffer = indexCount > 0;
 
@@ -85,42 +244,172 @@ namespace lve {
 			return;
 		}
 
-		VkDeviceSize bufferSize = sizeof(indecies[0]) * indexCount;
-		uint32_t indexSize = sizeof(indecies[0]);
-
-		VulkanBuffer stagingBuffer{
-			vulkanDevice,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
+		assert((indexSize == sizeof(uint16_t) || indexSize == sizeof(uint32_t)) && "index size must be 2 or 4 bytes");
+		indexType = indexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
 
-		stagingBuffer.Map();
-		stagingBuffer.WriteToBuffer((void*)indecies.data());
+		VkDeviceSize bufferSize = static_cast<VkDeviceSize>(indexSize) * indexCount;
 
 		indexBuffer = std::make_unique<VulkanBuffer>
 			(
 				vulkanDevice,
-				indexCount,
+				indexSize,
 				indexCount,
 				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 			);
 
-		vulkanDevice.copyBuffer(stagingBuffer.GetBuffer(), indexBuffer->GetBuffer(), bufferSize);
+		vulkanDevice.getUploadContext().UploadBuffer(indexBuffer->GetBuffer(), indicies, bufferSize);
+	}
+
+	bool VulkanModel::AllocateInArena(GeometryArena& geometryArena, const MeshView& meshView) {
+		if (geometryArena.GetVertexLayout() != meshView.vertexLayout) {
+			return false;
+		}
+
+		assert((meshView.indexCount == 0 || meshView.indexSize == sizeof(uint16_t) || meshView.indexSize == sizeof(uint32_t)) && "index size must be 2 or 4 bytes");
+		VkIndexType meshIndexType = meshView.indexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+		GeometryArena::Allocation allocation{};
+		if (!geometryArena.Allocate(meshView.vertexCount, meshView.indexCount, meshIndexType, allocation)) {
+			std::cout << "Geometry arena is full, model gets its own buffers\n";
+			return false;
+		}
+
+		arena = &geometryArena;
+		baseVertex = allocation.firstVertex;
+		baseIndex = allocation.firstIndex;
+		vertexCount = meshView.vertexCount;
+		indexCount = meshView.indexCount;
+		hasIndexBuffer = indexCount > 0;
+		indexType = meshIndexType;
+
+		VulkanUploadContext& uploadContext = vulkanDevice.getUploadContext();
+		uint32_t vertexSize = GetVertexStride(vertexLayout);
+		uploadContext.UploadBuffer(
+			arena->GetVertexBuffer().GetBuffer(),
+			meshView.vertices,
+			static_cast<VkDeviceSize>(vertexSize) * vertexCount,
+			static_cast<VkDeviceSize>(vertexSize) * baseVertex);
+
+		if (hasIndexBuffer) {
+			// 16 bit meshes go to the arena's 16 bit index buffer, so they keep the halved size
+			VkDeviceSize indexSize = meshView.indexSize;
+			uploadContext.UploadBuffer(
+				arena->GetIndexBuffer(indexType).GetBuffer(),
+				meshView.indicies,
+				indexSize * indexCount,
+				indexSize * baseIndex);
+		}
+		return true;
+	}
+
+	void VulkanModel::CreateMeshletBuffers(const MeshView& meshView) {
+		if (meshView.meshletCount == 0) {
+			return;
+		}
+
+		meshlets.assign(meshView.meshlets, meshView.meshlets + meshView.meshletCount);
+		meshletBounds.assign(meshView.meshletBounds, meshView.meshletBounds + meshView.meshletCount);
+		for (auto& meshlet : meshlets) {
+			meshlet.firstIndex += baseIndex;
+			meshlet.baseVertex += static_cast<int32_t>(baseVertex);
+		}
+
+		meshletBuffer = CreateDeviceLocalBuffer(meshlets.data(), sizeof(Meshlet), meshView.meshletCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		meshletBoundsBuffer = CreateDeviceLocalBuffer(meshView.meshletBounds, sizeof(MeshletBounds), meshView.meshletCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		meshletVertexBuffer = CreateDeviceLocalBuffer(meshView.meshletVertices, sizeof(uint32_t), meshView.meshletVertexCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		meshletTriangleBuffer = CreateDeviceLocalBuffer(meshView.meshletTriangles, sizeof(uint32_t), meshView.meshletTriangleBytes / sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	}
+
+	std::unique_ptr<VulkanBuffer> VulkanModel::CreateDeviceLocalBuffer(
+		const void* data,
+		VkDeviceSize instanceSize,
+		uint32_t instanceCount,
+		VkBufferUsageFlags usage) {
+
+		auto buffer = std::make_unique<VulkanBuffer>
+			(
+				vulkanDevice,
+				instanceSize,
+				instanceCount,
+				usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+
+		vulkanDevice.getUploadContext().UploadBuffer(buffer->GetBuffer(), data, instanceSize * instanceCount);
+		return buffer;
 	}
 
 	void VulkanModel::Draw(VkCommandBuffer commandBuffer) {
+		Draw(commandBuffer, 0);
+	}
+
+	void VulkanModel::Draw(VkCommandBuffer commandBuffer, uint32_t lod) {
+		DrawInstanced(commandBuffer, lod, 1, 0);
+	}
+
+	void VulkanModel::DrawInstanced(VkCommandBuffer commandBuffer, uint32_t lod, uint32_t instanceCount, uint32_t firstInstance) {
 		if (hasIndexBuffer) {
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+			assert(lod < lods.size() && "lod out of range");
+			for (uint32_t i = lodFirstSubmesh[lod]; i < lodFirstSubmesh[lod] + lodSubmeshCount[lod]; i++) {
+				const Submesh& submesh = submeshes[i];
+				vkCmdDrawIndexed(commandBuffer, submesh.indexCount, instanceCount, submesh.firstIndex, submesh.vertexOffset, firstInstance);
+			}
 		}
 		else {
-			vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+			vkCmdDraw(commandBuffer, vertexCount, instanceCount, baseVertex, firstInstance);
+		}
+	}
+
+	uint32_t VulkanModel::SelectLod(float errorToScreen, float maxScreenError) const {
+		uint32_t selected = 0;
+		for (uint32_t i = 1; i < lods.size(); i++) {
+			if (lods[i].error * errorToScreen > maxScreenError) {
+				break;
+			}
+			selected = i;
+		}
+		return selected;
+	}
+
+	void VulkanModel::DrawVisibleMeshlets(VkCommandBuffer commandBuffer, glm::vec3 cameraPosition) {
+		if (meshlets.empty()) {
+			Draw(commandBuffer);
+			return;
+		}
+
+		// Neighbouring visible meshlets are neighbouring index ranges, merge them into one draw
+		uint32_t runFirstIndex = 0;
+		uint32_t runIndexCount = 0;
+		int32_t runBaseVertex = 0;
+		for (size_t i = 0; i < meshlets.size(); i++) {
+			if (meshletBounds[i].IsBackfacing(cameraPosition)) {
+				continue;
+			}
+
+			const Meshlet& meshlet = meshlets[i];
+			if (runIndexCount > 0 && runFirstIndex + runIndexCount == meshlet.firstIndex && runBaseVertex == meshlet.baseVertex) {
+				runIndexCount += meshlet.triangleCount * 3;
+				continue;
+			}
+			if (runIndexCount > 0) {
+				vkCmdDrawIndexed(commandBuffer, runIndexCount, 1, runFirstIndex, runBaseVertex, 0);
+			}
+			runFirstIndex = meshlet.firstIndex;
+			runIndexCount = meshlet.triangleCount * 3;
+			runBaseVertex = meshlet.baseVertex;
+		}
+		if (runIndexCount > 0) {
+			vkCmdDrawIndexed(commandBuffer, runIndexCount, 1, runFirstIndex, runBaseVertex, 0);
 		}
 	}
 
 	void VulkanModel::Bind(VkCommandBuffer commandBuffer) {
+		if (arena != nullptr) {
+			arena->Bind(commandBuffer, indexType);
+			return;
+		}
+
 		VkBuffer buffers[] = {vertexBuffer->GetBuffer()};
 
 		VkDeviceSize offsets[] = { 0 };
@@ -128,7 +417,20 @@ namespace lve {
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
 
 		if (hasIndexBuffer) {
-			vkCmdBindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, indexType);
+		}
+	}
+
+	void VulkanModel::Bind(VkCommandBuffer commandBuffer, BindStateTracker& bindState) {
+		if (arena != nullptr) {
+			bindState.BindVertexBuffer(commandBuffer, arena->GetVertexBuffer().GetBuffer());
+			bindState.BindIndexBuffer(commandBuffer, arena->GetIndexBuffer(indexType).GetBuffer(), 0, indexType);
+			return;
+		}
+
+		bindState.BindVertexBuffer(commandBuffer, vertexBuffer->GetBuffer());
+		if (hasIndexBuffer) {
+			bindState.BindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, indexType);
 		}
 	}
 
@@ -159,7 +461,65 @@ namespace lve {
 		return attributeDescriptions;
 	}
 
+	VulkanModel::CompactVertex VulkanModel::CompactVertex::Encode(const Vertex& vertex, glm::vec3 minBounds, glm::vec3 maxBounds) {
+		CompactVertex compactVertex{};
+
+		glm::vec3 extent = maxBounds - minBounds;
+		for (int i = 0; i < 3; i++) {
+			float relative = extent[i] > 0.f ? (vertex.position[i] - minBounds[i]) / extent[i] : 0.f;
+			compactVertex.position[i] = EncodeUnorm16(relative);
+			compactVertex.color[i] = EncodeUnorm8(vertex.color[i]);
+		}
+		compactVertex.color[3] = 255;
+
+		glm::vec2 normal = OctEncode(vertex.normal);
+		compactVertex.normal[0] = EncodeSnorm16(normal.x);
+		compactVertex.normal[1] = EncodeSnorm16(normal.y);
+
+		compactVertex.uv[0] = EncodeUnorm16(vertex.uv.x);
+		compactVertex.uv[1] = EncodeUnorm16(vertex.uv.y);
+
+		return compactVertex;
+	}
+
+	std::vector<VkVertexInputBindingDescription> VulkanModel::CompactVertex::GetBindingDescriptions() {
+		return {{0, sizeof(CompactVertex), VK_VERTEX_INPUT_RATE_VERTEX}};
+	}
+
+	std::vector<VkVertexInputAttributeDescription> VulkanModel::CompactVertex::GetAttributeDescriptions() {
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompactVertex, position) });
+		attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(CompactVertex, color) });
+		attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, normal) });
+		attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R16G16_UNORM, offsetof(CompactVertex, uv) });
+
+		return attributeDescriptions;
+	}
+
+	uint32_t VulkanModel::GetVertexStride(VertexLayout vertexLayout) {
+		return vertexLayout == VertexLayout::Compact ? sizeof(CompactVertex) : sizeof(Vertex);
+	}
+
+	std::vector<VkVertexInputBindingDescription> VulkanModel::GetBindingDescriptions(VertexLayout vertexLayout) {
+		return vertexLayout == VertexLayout::Compact ? CompactVertex::GetBindingDescriptions() : Vertex::GetBindingDescriptions();
+	}
+
+	std::vector<VkVertexInputAttributeDescription> VulkanModel::GetAttributeDescriptions(VertexLayout vertexLayout) {
+		return vertexLayout == VertexLayout::Compact ? CompactVertex::GetAttributeDescriptions() : Vertex::GetAttributeDescriptions();
+	}
+
+	glm::mat4 VulkanModel::GetPositionDecodeMatrix() const {
+		if (vertexLayout != VertexLayout::Compact) {
+			return glm::mat4{1.f};
+		}
+		// Compact positions are 0..1 across the bounds
+		glm::mat4 decode = glm::translate(glm::mat4{1.f}, minBounds);
+		return glm::scale(decode, maxBounds - minBounds);
+	}
+
 	void VulkanModel::Builder::LoadModel(const std::string& filepath) {
+#ifdef LVE_USE_TINYOBJ
 		tinyobj::attrib_t attrib;
 		std::vector<tinyobj::shape_t> shapes;
 		std::vector<tinyobj::material_t> materials;
@@ -169,48 +529,216 @@ namespace lve {
 			throw std::runtime_error(warn + err);	
 		}
 
+		ObjData objData{};
+		objData.vertices = std::move(attrib.vertices);
+		objData.colors = std::move(attrib.colors);
+		objData.normals = std::move(attrib.normals);
+		objData.texcoords = std::move(attrib.texcoords);
+		for (const auto& shape : shapes) {
+			for (const auto& index : shape.mesh.indices) {
+				objData.indices.push_back({ index.vertex_index, index.normal_index, index.texcoord_index });
+			}
+		}
+#else
+		ObjData objData = ObjParser::ParseFile(filepath);
+#endif
+
 		vertices.clear();
 		indicies.clear();
+		compactVertices.clear();
+		vertexLayout = VertexLayout::Full;
+		shortIndicies.clear();
+		submeshes.clear();
+		lods.clear();
+		meshlets.clear();
+		meshletBounds.clear();
+		meshletVertices.clear();
+		meshletTriangles.clear();
+		indicies.reserve(objData.indices.size());
+
+		size_t expectedVertexCount = std::max({ objData.vertices.size() / 3, objData.normals.size() / 3, objData.texcoords.size() / 2 });
+		vertices.reserve(expectedVertexCount);
+
+		VertexDedupTable uniqueVertecies{expectedVertexCount};
+		for (const auto& index : objData.indices) {
+			indicies.push_back(uniqueVertecies.FindOrAdd(index, objData, vertices));
+		}
 
-		std::unordered_map<Vertex, uint32_t> uniqueVertecies{};
+		ComputeBounds();
+	}
 
-		for (const auto& shape : shapes) {
-			for (const auto& index : shape.mesh.indices) {
-				Vertex vertex{};
-
-				if (index.vertex_index >= 0) {
-					vertex.position = { 
-						attrib.vertices[3 * index.vertex_index + 0],
-						attrib.vertices[3 * index.vertex_index + 1],
-						attrib.vertices[3 * index.vertex_index + 2]
-					};
-
-					vertex.color = {
-						attrib.colors[3 * index.vertex_index + 0],
-						attrib.colors[3 * index.vertex_index + 1],
-						attrib.colors[3 * index.vertex_index + 2]
-					};
-				}
-				if (index.normal_index >= 0) {
-					vertex.normal = { 
-						attrib.normals[3 * index.normal_index + 0],
-						attrib.normals[3 * index.normal_index + 1],
-						attrib.normals[3 * index.normal_index + 2]
-					};
-				}
-				if (index.texcoord_index >= 0) {
-					vertex.uv = { 
-						attrib.texcoords[2 * index.texcoord_index + 0],
-						attrib.texcoords[2 * index.texcoord_index + 1]
-					};
+	void VulkanModel::Builder::ComputeBounds() {
+		if (vertices.empty()) {
+			minBounds = maxBounds = sphereCenter = glm::vec3{0.f};
+			sphereRadius = 0.f;
+			return;
+		}
+
+		minBounds = maxBounds = vertices[0].position;
+		for (const auto& vertex : vertices) {
+			minBounds = glm::min(minBounds, vertex.position);
+			maxBounds = glm::max(maxBounds, vertex.position);
+		}
+
+		// Farthest vertex from the box center rather than half the diagonal, the corners are rarely occupied
+		sphereCenter = (minBounds + maxBounds) * 0.5f;
+		float radiusSquared = 0.f;
+		for (const auto& vertex : vertices) {
+			glm::vec3 offset = vertex.position - sphereCenter;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+		sphereRadius = std::sqrt(radiusSquared);
+	}
+
+	void VulkanModel::Builder::Optimize() {
+		MeshOptimizer::OptimizeVertexCache(indicies, vertices.size());
+		MeshOptimizer::OptimizeOverdraw(indicies, vertices);
+		MeshOptimizer::OptimizeVertexFetch(indicies, vertices);
+	}
+
+	void VulkanModel::Builder::BuildLods() {
+		lods.clear();
+		if (indicies.empty()) {
+			return;
+		}
+
+		std::vector<uint32_t> baseIndices = indicies;
+		lods.push_back({ 0, static_cast<uint32_t>(baseIndices.size()), 0.f });
+
+		float maxError = glm::length(maxBounds - minBounds) * MAX_LOD_ERROR;
+		std::vector<uint32_t> lodIndices{};
+		for (float ratio : LOD_RATIOS) {
+			size_t targetIndexCount = static_cast<size_t>(baseIndices.size() / 3 * ratio) * 3;
+
+			// Always simplify from LOD 0 so the error is measured against the real surface
+			float error = MeshSimplifier::Simplify(baseIndices, vertices, targetIndexCount, maxError, lodIndices);
+			if (lodIndices.empty() || lodIndices.size() > lods.back().indexCount * MIN_LOD_REDUCTION) {
+				break;
+			}
+
+			MeshOptimizer::OptimizeVertexCache(lodIndices, vertices.size());
+			lods.push_back({ static_cast<uint32_t>(indicies.size()), static_cast<uint32_t>(lodIndices.size()), error });
+			indicies.insert(indicies.end(), lodIndices.begin(), lodIndices.end());
+		}
+
+		if (lods.size() == 1) {
+			lods.clear();
+		}
+	}
+
+	void VulkanModel::Builder::Quantize() {
+		compactVertices.clear();
+		compactVertices.reserve(vertices.size());
+		for (const auto& vertex : vertices) {
+			compactVertices.push_back(CompactVertex::Encode(vertex, minBounds, maxBounds));
+		}
+		vertexLayout = VertexLayout::Compact;
+	}
+
+	void VulkanModel::Builder::SelectIndexType() {
+		shortIndicies.clear();
+		submeshes.clear();
+
+		if (indicies.empty()) {
+			return;
+		}
+
+		// Cut the triangle list wherever the vertex range it touches would no longer fit in 16 bits.
+		// After Optimize vertices are numbered by first use so the ranges stay narrow and cuts are rare.
+		// Every LOD starts a new submesh so each LOD can be drawn on its own
+		std::vector<Lod> ranges = lods;
+		if (ranges.empty()) {
+			ranges.push_back({ 0, static_cast<uint32_t>(indicies.size()), 0.f });
+		}
+
+		std::vector<Submesh> candidates{};
+		for (const auto& range : ranges) {
+			uint32_t rangeMin = UINT32_MAX;
+			uint32_t rangeMax = 0;
+			uint32_t submeshStart = range.firstIndex;
+			uint32_t rangeEnd = range.firstIndex + range.indexCount;
+
+			for (uint32_t i = range.firstIndex; i + 2 < rangeEnd; i += 3) {
+				uint32_t triangleMin = std::min({ indicies[i], indicies[i + 1], indicies[i + 2] });
+				uint32_t triangleMax = std::max({ indicies[i], indicies[i + 1], indicies[i + 2] });
+				if (triangleMax - triangleMin > UINT16_MAX) {
+					// A single triangle spanning more than 16 bits can never be drawn with short indices
+					return;
 				}
 
-				if (uniqueVertecies.count(vertex) == 0) {
-					uniqueVertecies[vertex] = static_cast<uint32_t>(vertices.size());
-					vertices.push_back(vertex);
+				uint32_t newMin = std::min(rangeMin, triangleMin);
+				uint32_t newMax = std::max(rangeMax, triangleMax);
+				if (newMax - newMin > UINT16_MAX) {
+					candidates.push_back({ submeshStart, i - submeshStart, static_cast<int32_t>(rangeMin) });
+					submeshStart = i;
+					newMin = triangleMin;
+					newMax = triangleMax;
 				}
-				indicies.push_back(uniqueVertecies[vertex]);
+				rangeMin = newMin;
+				rangeMax = newMax;
+			}
+			candidates.push_back({ submeshStart, rangeEnd - submeshStart, static_cast<int32_t>(rangeMin == UINT32_MAX ? 0 : rangeMin) });
+		}
+
+		// Only the cuts made for 16 bits cost extra draws, LOD boundaries are drawn separately anyway
+		if (candidates.size() > ranges.size() && indicies.size() / candidates.size() < MIN_INDICES_PER_SUBMESH) {
+			return;
+		}
+
+		shortIndicies.resize(indicies.size());
+		for (const auto& submesh : candidates) {
+			for (uint32_t i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i++) {
+				shortIndicies[i] = static_cast<uint16_t>(indicies[i] - static_cast<uint32_t>(submesh.vertexOffset));
 			}
 		}
+
+		// One submesh per LOD at offset 0 is the default, no need to store it
+		bool defaultSubmeshes = candidates.size() == ranges.size() &&
+			std::all_of(candidates.begin(), candidates.end(), [](const Submesh& submesh) { return submesh.vertexOffset == 0; });
+		if (!defaultSubmeshes) {
+			submeshes = std::move(candidates);
+		}
+	}
+
+	void VulkanModel::Builder::BuildMeshlets() {
+		MeshletBuilder::Build(*this);
+	}
+
+	VulkanModel::MeshView VulkanModel::Builder::GetMeshView() const {
+		MeshView meshView{};
+		meshView.vertexLayout = vertexLayout;
+		if (vertexLayout == VertexLayout::Compact) {
+			meshView.vertices = compactVertices.data();
+			meshView.vertexCount = static_cast<uint32_t>(compactVertices.size());
+		}
+		else {
+			meshView.vertices = vertices.data();
+			meshView.vertexCount = static_cast<uint32_t>(vertices.size());
+		}
+		if (!shortIndicies.empty()) {
+			meshView.indicies = shortIndicies.data();
+			meshView.indexSize = sizeof(uint16_t);
+		}
+		else {
+			meshView.indicies = indicies.data();
+			meshView.indexSize = sizeof(uint32_t);
+		}
+		meshView.indexCount = static_cast<uint32_t>(indicies.size());
+		meshView.submeshes = submeshes.data();
+		meshView.submeshCount = static_cast<uint32_t>(submeshes.size());
+		meshView.lods = lods.data();
+		meshView.lodCount = static_cast<uint32_t>(lods.size());
+		meshView.meshlets = meshlets.data();
+		meshView.meshletBounds = meshletBounds.data();
+		meshView.meshletCount = static_cast<uint32_t>(meshlets.size());
+		meshView.meshletVertices = meshletVertices.data();
+		meshView.meshletVertexCount = static_cast<uint32_t>(meshletVertices.size());
+		meshView.meshletTriangles = meshletTriangles.data();
+		meshView.meshletTriangleBytes = static_cast<uint32_t>(meshletTriangles.size());
+		meshView.minBounds = minBounds;
+		meshView.maxBounds = maxBounds;
+		meshView.sphereCenter = sphereCenter;
+		meshView.sphereRadius = sphereRadius;
+		return meshView;
 	}
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "../vulkanDevice.h"
 #include "../Buffer/vulkanBuffer.h"
+#include "../Renderer/bindStateTracker.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -11,6 +12,22 @@
 
 namespace lve {
 
+	class MeshCache;
+	class GeometryArena;
+
+	enum class VertexLayout : uint32_t {
+		Full,   // VulkanModel::Vertex, 44 bytes of floats
+		Compact // VulkanModel::CompactVertex, 20 bytes, needs the simpleShaderCompact.vert decode
+	};
+
+	// How CreateModelFromDevice prepares a mesh, the mesh cache is rebuilt when these change
+	struct ModelLoadSettings {
+		bool optimizeMesh{true};
+		bool buildMeshlets{false};
+		bool buildLods{false};
+		VertexLayout vertexLayout{VertexLayout::Full};
+	};
+
 	struct VulkanModel {
 		struct Vertex
 		{
@@ -26,27 +43,216 @@ namespace lve {
 				return position == other.position && color == other.color && normal == other.normal && uv == other.uv;
 			}
 		};
+		/*
+		* Quantized vertex for VertexLayout::Compact.
+		* position is unorm16 inside the mesh bounds, GetPositionDecodeMatrix maps it back to model space.
+		* normal is octahedral encoded snorm16, color is unorm8 and uv is unorm16 so it is clamped to [0, 1].
+		*/
+		struct CompactVertex
+		{
+			uint16_t position[4]{}; // w is padding
+			int16_t normal[2]{};
+			uint8_t color[4]{};     // a is padding
+			uint16_t uv[2]{};
+
+			static CompactVertex Encode(const Vertex& vertex, glm::vec3 minBounds, glm::vec3 maxBounds);
+
+			static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
+		};
+		// One vkCmdDrawIndexed worth of the index buffer, indices are relative to vertexOffset
+		struct Submesh {
+			uint32_t firstIndex{0};
+			uint32_t indexCount{0};
+			int32_t vertexOffset{0};
+		};
+
+		// Index range of one level of detail, error is how far it may be from LOD 0 in model space
+		struct Lod {
+			uint32_t firstIndex{0};
+			uint32_t indexCount{0};
+			float error{0.f};
+		};
+
+		/*
+		* Cluster of at most MeshletBuilder::MAX_VERTICES vertices and MAX_TRIANGLES triangles.
+		* The triangles are also a contiguous range of the index buffer, so a culled set of meshlets
+		* can be drawn through the plain indexed pipeline as well as read by a cluster shader.
+		*/
+		struct Meshlet {
+			uint32_t firstIndex{0};     // Into the index buffer
+			int32_t baseVertex{0};      // vertexOffset of the submesh the meshlet belongs to
+			uint32_t vertexOffset{0};   // Into meshletVertices
+			uint32_t triangleOffset{0}; // Into meshletTriangles, counted in triangles
+			uint32_t vertexCount{0};
+			uint32_t triangleCount{0};
+		};
+
+		// Laid out for std430 so the buffer can be read by a culling shader as is
+		struct MeshletBounds {
+			glm::vec3 center{};
+			float radius{0.f};
+			glm::vec3 coneApex{};
+			float coneCutoff{1.f}; // sin of the cone half angle, 1 means the cone is too wide to cull
+			glm::vec3 coneAxis{};
+			float padding{0.f};
+
+			// Every triangle in the meshlet faces away from cameraPosition, which is in model space
+			bool IsBackfacing(glm::vec3 cameraPosition) const {
+				glm::vec3 toApex = coneApex - cameraPosition;
+				float distance = glm::length(toApex);
+				return coneCutoff < 1.f && distance > 0.f && glm::dot(toApex / distance, coneAxis) >= coneCutoff;
+			}
+		};
+
+		// Upload ready vertex and index data, the memory belongs to whoever made the view
+		struct MeshView {
+			VertexLayout vertexLayout{VertexLayout::Full};
+			const void* vertices{nullptr}; // Vertex or CompactVertex depending on vertexLayout
+			uint32_t vertexCount{0};
+			const void* indicies{nullptr}; // uint16_t or uint32_t depending on indexSize
+			uint32_t indexCount{0};
+			uint32_t indexSize{sizeof(uint32_t)};
+			// Empty means one submesh covering every index
+			const Submesh* submeshes{nullptr};
+			uint32_t submeshCount{0};
+			// Empty means the whole index buffer is LOD 0
+			const Lod* lods{nullptr};
+			uint32_t lodCount{0};
+			// Empty unless meshlets were built
+			const Meshlet* meshlets{nullptr};
+			const MeshletBounds* meshletBounds{nullptr};
+			uint32_t meshletCount{0};
+			const uint32_t* meshletVertices{nullptr};
+			uint32_t meshletVertexCount{0};
+			const uint8_t* meshletTriangles{nullptr}; // 3 local vertex indices per triangle, padded to 4 bytes
+			uint32_t meshletTriangleBytes{0};
+			glm::vec3 minBounds{};
+			glm::vec3 maxBounds{};
+			glm::vec3 sphereCenter{};
+			float sphereRadius{0.f};
+		};
+
 		struct Builder {
 			std::vector<Vertex> vertices{};
 			std::vector<uint32_t> indicies{};
+			// Filled by Quantize, GetMeshView hands these out instead of vertices once set
+			std::vector<CompactVertex> compactVertices{};
+			VertexLayout vertexLayout{VertexLayout::Full};
+			// Filled by SelectIndexType when 16 bit indices fit, GetMeshView hands these out instead of indicies
+			std::vector<uint16_t> shortIndicies{};
+			std::vector<Submesh> submeshes{};
+			// Filled by BuildLods, LOD 0 stays at the front of indicies and the rest are appended after it
+			std::vector<Lod> lods{};
+			// Filled by BuildMeshlets, only covers LOD 0
+			std::vector<Meshlet> meshlets{};
+			std::vector<MeshletBounds> meshletBounds{};
+			std::vector<uint32_t> meshletVertices{};
+			std::vector<uint8_t> meshletTriangles{};
+			// Model space bounds of LOD 0, set by ComputeBounds
+			glm::vec3 minBounds{};
+			glm::vec3 maxBounds{};
+			glm::vec3 sphereCenter{};
+			float sphereRadius{0.f};
 
 			void LoadModel(const std::string &filePath);
+			// Axis aligned box and a bounding sphere around its center that is usually tighter than the box corners
+			void ComputeBounds();
+			// Reorders triangles and vertices for the post transform cache, overdraw and vertex fetch, see MeshOptimizer
+			void Optimize();
+			// Appends simplified copies of the index buffer as LODs, call after Optimize
+			void BuildLods();
+			// Encodes vertices into compactVertices, call after ComputeBounds and Optimize
+			void Quantize();
+			// Switches to 16 bit indices when every submesh spans less than 65536 vertices, call after Optimize
+			void SelectIndexType();
+			// Partitions the index buffer into meshlets with bounds, call last so the meshlets match the final index order
+			void BuildMeshlets();
+
+			MeshView GetMeshView() const;
+		};
+
+		// CPU side result of loading a model file, either a mapped mesh cache or a freshly built mesh
+		struct MeshData {
+			Builder builder{};
+			std::shared_ptr<MeshCache> cache{};
+
+			MeshView GetMeshView() const;
 		};
 
 		VulkanModel(VulkanDevice& vulkanDevice, const VulkanModel::Builder& builder);
+		// With an arena of the same vertex layout the model only holds ranges of the arena buffers,
+		// it falls back to buffers of its own when the arena is full
+		VulkanModel(VulkanDevice& vulkanDevice, const VulkanModel::MeshView& meshView, GeometryArena* arena = nullptr);
 		~VulkanModel();
 
 		VulkanModel(const VulkanModel&) = delete;
 		VulkanModel& operator=(const VulkanModel&) = delete;
 
-		static std::unique_ptr<VulkanModel> CreateModelFromDevice(VulkanDevice& device, const std::string &filePath);
+		// Buffers are filled through the device upload context, they are ready once its batch was submitted
+		static std::unique_ptr<VulkanModel> CreateModelFromDevice(
+			VulkanDevice& device,
+			const std::string &filePath,
+			const ModelLoadSettings& settings = {},
+			GeometryArena* arena = nullptr
+		);
+		// Everything CreateModelFromDevice does before touching the device, reads the mesh cache or builds and writes it
+		static MeshData LoadMeshData(const std::string& filePath, const ModelLoadSettings& settings = {});
+
+		static uint32_t GetVertexStride(VertexLayout vertexLayout);
+		static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions(VertexLayout vertexLayout);
+		static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions(VertexLayout vertexLayout);
 
+		// Binds the arena buffers for models in an arena, drawing another model of the same arena and index type needs no new Bind
 		void Bind(VkCommandBuffer commandBuffer);
+		// Same buffers as Bind, but leaves out whatever bindState says is bound already
+		void Bind(VkCommandBuffer commandBuffer, BindStateTracker& bindState);
 		void Draw(VkCommandBuffer commandBuffer);
+		void Draw(VkCommandBuffer commandBuffer, uint32_t lod);
+		// gl_InstanceIndex runs from firstInstance to firstInstance + instanceCount - 1
+		void DrawInstanced(VkCommandBuffer commandBuffer, uint32_t lod, uint32_t instanceCount, uint32_t firstInstance);
+		// Draws only the meshlets not facing away from cameraPosition (model space), falls back to Draw without meshlets.
+		// Only matches Draw when the pipeline culls back faces, the default pipeline draws both sides
+		// and its open meshes like the vases show their back faces
+		void DrawVisibleMeshlets(VkCommandBuffer commandBuffer, glm::vec3 cameraPosition);
+
+		uint32_t GetLodCount() const { return static_cast<uint32_t>(lods.size()); }
+		const Lod& GetLod(uint32_t lod) const { return lods[lod]; }
+		// The draws Draw issues for lod, already offset into the arena
+		uint32_t GetLodSubmeshCount(uint32_t lod) const { return lodSubmeshCount[lod]; }
+		const Submesh& GetLodSubmesh(uint32_t lod, uint32_t submesh) const { return submeshes[lodFirstSubmesh[lod] + submesh]; }
+		bool HasIndexBuffer() const { return hasIndexBuffer; }
+		// Coarsest LOD whose error stays within maxScreenError once multiplied by errorToScreen
+		uint32_t SelectLod(float errorToScreen, float maxScreenError) const;
+
+		bool HasMeshlets() const { return !meshlets.empty(); }
+		const std::vector<Meshlet>& GetMeshlets() const { return meshlets; }
+		const std::vector<MeshletBounds>& GetMeshletBounds() const { return meshletBounds; }
+		// Storage buffers for cluster culling on the GPU, null without meshlets
+		VulkanBuffer* GetMeshletBuffer() const { return meshletBuffer.get(); }
+		VulkanBuffer* GetMeshletBoundsBuffer() const { return meshletBoundsBuffer.get(); }
+		VulkanBuffer* GetMeshletVertexBuffer() const { return meshletVertexBuffer.get(); }
+		VulkanBuffer* GetMeshletTriangleBuffer() const { return meshletTriangleBuffer.get(); }
+
+		glm::vec3 GetMinBounds() const { return minBounds; }
+		glm::vec3 GetMaxBounds() const { return maxBounds; }
+		glm::vec3 GetSphereCenter() const { return sphereCenter; }
+		float GetSphereRadius() const { return sphereRadius; }
+		VertexLayout GetVertexLayout() const { return vertexLayout; }
+		VkIndexType GetIndexType() const { return indexType; }
+		// Null when the model owns its buffers
+		GeometryArena* GetArena() const { return arena; }
+		// Unique per model created in this run, for draw sort keys
+		uint32_t GetSortId() const { return sortId; }
+		// Bytes of device memory held by the vertex, index and meshlet buffers, or by the arena ranges
+		VkDeviceSize GetDeviceMemorySize() const;
+		// Multiply onto the model matrix, identity unless positions are quantized
+		glm::mat4 GetPositionDecodeMatrix() const;
 
 	private:		
 		
 		VulkanDevice& vulkanDevice;
+		uint32_t sortId;
 
 		//Vertex
 		std::unique_ptr<VulkanBuffer> vertexBuffer;
@@ -55,11 +261,49 @@ namespace lve {
 		//Index
 		std::unique_ptr<VulkanBuffer> indexBuffer;
 		uint32_t indexCount;
+		VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+		std::vector<Submesh> submeshes{};
 
 		bool hasIndexBuffer{false};
 
-		void CreateVertexBuffers(const std::vector<Vertex>& vertices);
+		//Arena, every index, submesh and meshlet range is already offset by baseIndex and baseVertex
+		GeometryArena* arena{nullptr};
+		uint32_t baseVertex{0};
+		uint32_t baseIndex{0};
+
+		//LODs, the submeshes of each LOD are a contiguous run of submeshes
+		std::vector<Lod> lods{};
+		std::vector<uint32_t> lodFirstSubmesh{};
+		std::vector<uint32_t> lodSubmeshCount{};
+
+		//Meshlets
+		std::vector<Meshlet> meshlets{};
+		std::vector<MeshletBounds> meshletBounds{};
+		std::unique_ptr<VulkanBuffer> meshletBuffer;
+		std::unique_ptr<VulkanBuffer> meshletBoundsBuffer;
+		std::unique_ptr<VulkanBuffer> meshletVertexBuffer;
+		std::unique_ptr<VulkanBuffer> meshletTriangleBuffer;
+
+		glm::vec3 minBounds{};
+		glm::vec3 maxBounds{};
+		glm::vec3 sphereCenter{};
+		float sphereRadius{0.f};
+
+		VertexLayout vertexLayout{VertexLayout::Full};
+
+		void CreateVertexBuffers(const void* vertices, uint32_t vertexCount);
+
+		void CreateIndexBuffers(const void* indicies, uint32_t indexCount, uint32_t indexSize);
+
+		bool AllocateInArena(GeometryArena& geometryArena, const MeshView& meshView);
+
+		void CreateMeshletBuffers(const MeshView& meshView);
 
-		void CreateIndexBuffers(const std::vector<uint32_t>& indicies);
+		std::unique_ptr<VulkanBuffer> CreateDeviceLocalBuffer(
+			const void* data,
+			VkDeviceSize instanceSize,
+			uint32_t instanceCount,
+			VkBufferUsageFlags usage
+		);
 	};
 }
\ No newline at end of file
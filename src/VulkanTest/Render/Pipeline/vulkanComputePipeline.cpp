@@ -0,0 +1,46 @@
+#include <stdexcept>
+#include <cassert>
+
+#include "vulkanComputePipeline.h"
+#include "vulkanPipeline.h"
+
+namespace lve {
+
+	VulkanComputePipeline::VulkanComputePipeline(VulkanDevice& device, const std::string& compFilePath, VkPipelineLayout pipelineLayout) : vulkanDevice{device} {
+		assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline:: no pipelineLayout provided");
+
+		auto compCode = VulkanPipeline::readFile(compFilePath);
+
+		VkShaderModuleCreateInfo moduleInfo{};
+		moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		moduleInfo.codeSize = compCode.size();
+		moduleInfo.pCode = reinterpret_cast<const uint32_t*>(compCode.data());
+
+		if (vkCreateShaderModule(vulkanDevice.device(), &moduleInfo, nullptr, &compShaderModule) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create a shader module");
+		}
+
+		VkComputePipelineCreateInfo pipelineData{};
+		pipelineData.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineData.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineData.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineData.stage.module = compShaderModule;
+		pipelineData.stage.pName = "main";
+		pipelineData.layout = pipelineLayout;
+		pipelineData.basePipelineIndex = -1;
+		pipelineData.basePipelineHandle = VK_NULL_HANDLE;
+
+		if (vkCreateComputePipelines(vulkanDevice.device(), VK_NULL_HANDLE, 1, &pipelineData, nullptr, &computePipeline) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create compute pipeline");
+		}
+	}
+
+	VulkanComputePipeline::~VulkanComputePipeline() {
+		vkDestroyShaderModule(vulkanDevice.device(), compShaderModule, nullptr);
+		vkDestroyPipeline(vulkanDevice.device(), computePipeline, nullptr);
+	}
+
+	void VulkanComputePipeline::bind(VkCommandBuffer commandBuffer) {
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+	}
+}
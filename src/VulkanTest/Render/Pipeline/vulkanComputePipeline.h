@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+
+#include "../vulkanDevice.h"
+
+namespace lve {
+
+	// Compute counterpart of VulkanPipeline, one shader and a layout owned by the caller
+	class VulkanComputePipeline {
+
+		VulkanDevice& vulkanDevice;
+		VkPipeline computePipeline;
+		VkShaderModule compShaderModule;
+
+	public:
+		VulkanComputePipeline(
+			VulkanDevice& device,
+			const std::string& compFilePath,
+			VkPipelineLayout pipelineLayout
+		);
+		~VulkanComputePipeline();
+
+		VulkanComputePipeline(const VulkanComputePipeline&) = delete;
+		VulkanComputePipeline& operator=(const VulkanComputePipeline&) = delete;
+
+		void bind(VkCommandBuffer commandBuffer);
+	};
+}
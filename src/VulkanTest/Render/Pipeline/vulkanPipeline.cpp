@@ -68,8 +68,8 @@ namespace lve {
 		shaderStages[1].pSpecializationInfo = nullptr;
 
 
-		auto bindingDescriptions = VulkanModel::Vertex::GetBindingDescriptions();
-		auto attributeDescriptions = VulkanModel::Vertex::GetAttributeDescriptions();
+		auto& bindingDescriptions = configData.bindingDescriptions;
+		auto& attributeDescriptions = configData.attributeDescriptions;
 		VkPipelineVertexInputStateCreateInfo vertexInputData{};
 		vertexInputData.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 		vertexInputData.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
@@ -194,5 +194,8 @@ namespace lve {
 		configData.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configData.dynamicStateEnables.size());
 		configData.dynamicStateInfo.flags = 0;
 
+		configData.bindingDescriptions = VulkanModel::GetBindingDescriptions(VertexLayout::Full);
+		configData.attributeDescriptions = VulkanModel::GetAttributeDescriptions(VertexLayout::Full);
+
 	}
 }
\ No newline at end of file
@@ -11,6 +11,8 @@ namespace lve {
 		PipelineConfigData(const PipelineConfigData&) = delete;
 		PipelineConfigData& operator=(const PipelineConfigData&) = delete;
 
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 		VkPipelineViewportStateCreateInfo viewportInfo;
 		VkPipelineInputAssemblyStateCreateInfo inputAssemblyData;
 		VkPipelineRasterizationStateCreateInfo rasterizationInfo;
@@ -27,7 +29,6 @@ namespace lve {
 
 	class VulkanPipeline {
 
-		static std::vector<char> readFile(const std::string& filepath);
 		VulkanDevice& vulkanDevice;
 		VkPipeline graphicsPipeline;
 		VkShaderModule vertShaderModule;
@@ -46,6 +47,8 @@ namespace lve {
 		);
 
 	public:
+		static std::vector<char> readFile(const std::string& filepath);
+
 		VulkanPipeline(
 			VulkanDevice &device, 
 			const std::string &vertFilePath, 
@@ -58,6 +61,7 @@ namespace lve {
 		VulkanPipeline& operator=(const VulkanPipeline&) = delete;
 
 		void bind(VkCommandBuffer commandBuffer);
+		VkPipeline GetPipeline() const { return graphicsPipeline; }
 
 		static void DefaultPipelineConfigData(PipelineConfigData& configData);
 	};
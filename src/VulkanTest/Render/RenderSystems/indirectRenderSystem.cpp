@@ -0,0 +1,376 @@
+#include <stdexcept>
+#include <array>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <string>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "indirectRenderSystem.h"
+#include "../SwapChain/vulkanSwapChain.h"
+
+namespace lve {
+
+	// Has to match local_size_x in frustumCull.comp
+	constexpr uint32_t CULL_GROUP_SIZE = 64;
+
+	struct CullPushConstantData {
+		glm::vec4 frustumPlanes[6];
+		uint32_t recordCount;
+	};
+
+	IndirectRenderSystem::IndirectRenderSystem(
+		VulkanDevice& device,
+		VkRenderPass renderPass,
+		VkDescriptorSetLayout globalSetLayout,
+		VulkanFrameAllocator& instanceAllocator,
+		GeometryArena& arena,
+		VertexLayout vertexLayout,
+		VkDescriptorSetLayout bindlessSetLayout) : engineDevice{device}, arena{arena}, instanceAllocator{instanceAllocator},
+		vertexLayout{vertexLayout}, bindless{bindlessSetLayout != VK_NULL_HANDLE} {
+
+		// Every command points firstInstance at its object's transforms
+		if (!engineDevice.getEnabledFeatures().drawIndirectFirstInstance) {
+			throw std::runtime_error("GPU driven rendering needs the drawIndirectFirstInstance feature");
+		}
+		if (engineDevice.isDrawIndirectCountEnabled()) {
+			cmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+				vkGetDeviceProcAddr(engineDevice.device(), "vkCmdDrawIndexedIndirectCountKHR"));
+		}
+
+		// Room for every batch's records plus the padding that aligns each batch's start
+		VkDeviceSize storageAlignment = engineDevice.properties.limits.minStorageBufferOffsetAlignment;
+		recordAllocator = std::make_unique<VulkanFrameAllocator>(
+			engineDevice,
+			(sizeof(DrawRecord) * MAX_DRAWS + storageAlignment) * batches.size(),
+			vulkanSwapChain::MAX_FRAMES_IN_FLIGHT,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+		// Only the GPU writes and reads the commands, the CPU just clears them with vkCmdFillBuffer
+		drawCommandBuffer = std::make_unique<VulkanBuffer>(
+			engineDevice,
+			DRAW_COUNT_SIZE + sizeof(VkDrawIndexedIndirectCommand) * MAX_DRAWS,
+			static_cast<uint32_t>(vulkanSwapChain::MAX_FRAMES_IN_FLIGHT * batches.size()),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			storageAlignment);
+
+		createCullDescriptorSet();
+		createPipelineLayouts(globalSetLayout, bindlessSetLayout);
+		createpipelines(renderPass);
+	}
+
+	IndirectRenderSystem::~IndirectRenderSystem() {
+		vkDestroyPipelineLayout(engineDevice.device(), pipelineLayout, nullptr);
+		vkDestroyPipelineLayout(engineDevice.device(), cullPipelineLayout, nullptr);
+	}
+
+	void IndirectRenderSystem::createCullDescriptorSet() {
+		cullSetLayout = VulkanDescriptorSetLayout::Builder(engineDevice)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VK_SHADER_STAGE_COMPUTE_BIT)
+			.build();
+
+		cullPool = LveDescriptorPool::Builder(engineDevice)
+			.setMaxSets(1)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 3)
+			.build();
+
+		// One set for all frames and batches, the dynamic offsets pick the regions
+		auto instanceInfo = instanceAllocator.DescriptorInfo(instanceAllocator.GetFrameSize());
+		auto recordInfo = recordAllocator->DescriptorInfo(sizeof(DrawRecord) * MAX_DRAWS);
+		auto commandInfo = drawCommandBuffer->DescriptorInfo(drawCommandBuffer->GetInstanceSize(), 0);
+		LveDescriptorWriter(*cullSetLayout, *cullPool)
+			.writeBuffer(0, &instanceInfo)
+			.writeBuffer(1, &recordInfo)
+			.writeBuffer(2, &commandInfo)
+			.build(cullDescriptorSet);
+	}
+
+	void IndirectRenderSystem::UpdateInstanceDescriptor() {
+		auto instanceInfo = instanceAllocator.DescriptorInfo(instanceAllocator.GetFrameSize());
+		LveDescriptorWriter(*cullSetLayout, *cullPool)
+			.writeBuffer(0, &instanceInfo)
+			.overwrite(cullDescriptorSet);
+	}
+
+	void IndirectRenderSystem::createPipelineLayouts(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout bindlessSetLayout)
+	{
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+		if (bindless) {
+			descriptorSetLayouts.push_back(bindlessSetLayout);
+		}
+
+		VkPipelineLayoutCreateInfo pipelineLayoutData{};
+		pipelineLayoutData.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutData.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+		pipelineLayoutData.pSetLayouts = descriptorSetLayouts.data();
+		pipelineLayoutData.pushConstantRangeCount = 0;
+		pipelineLayoutData.pPushConstantRanges = nullptr;
+
+		if (vkCreatePipelineLayout(engineDevice.device(), &pipelineLayoutData, nullptr, &pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline layout");
+		}
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(CullPushConstantData);
+
+		VkDescriptorSetLayout cullLayout = cullSetLayout->getDescriptorSetLayout();
+
+		VkPipelineLayoutCreateInfo cullLayoutData{};
+		cullLayoutData.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		cullLayoutData.setLayoutCount = 1;
+		cullLayoutData.pSetLayouts = &cullLayout;
+		cullLayoutData.pushConstantRangeCount = 1;
+		cullLayoutData.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(engineDevice.device(), &cullLayoutData, nullptr, &cullPipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline layout");
+		}
+	}
+
+	void IndirectRenderSystem::createpipelines(VkRenderPass renderPass) {
+		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+		PipelineConfigData pipelineConfig{};
+		VulkanPipeline::DefaultPipelineConfigData(pipelineConfig);
+		pipelineConfig.renderPass = renderPass;
+		pipelineConfig.pipelineLayout = pipelineLayout;
+		pipelineConfig.bindingDescriptions = VulkanModel::GetBindingDescriptions(vertexLayout);
+		pipelineConfig.attributeDescriptions = VulkanModel::GetAttributeDescriptions(vertexLayout);
+
+		std::string vertexShader = vertexLayout == VertexLayout::Compact
+			? "src/VulkanTest/ShaderFolder/simpleShaderCompact"
+			: "src/VulkanTest/ShaderFolder/simpleShader";
+		vertexShader += bindless ? "Bindless.vert.spv" : ".vert.spv";
+		vulkanPipeline = std::make_unique<VulkanPipeline>(
+			engineDevice,
+			vertexShader,
+			"src/VulkanTest/ShaderFolder/simpleShader.frag.spv",
+			pipelineConfig
+		);
+
+		cullPipeline = std::make_unique<VulkanComputePipeline>(
+			engineDevice,
+			"src/VulkanTest/ShaderFolder/frustumCull.comp.spv",
+			cullPipelineLayout
+		);
+	}
+
+	void IndirectRenderSystem::Cull(FrameData& frameData) {
+		recordAllocator->BeginFrame(frameData.frameIndex);
+
+		instances.clear();
+		for (Batch& batch : batches) {
+			batch.records.clear();
+		}
+		directDraws.clear();
+		for (auto& kv : frameData.gameObjects) {
+			auto& object = kv.second;
+			if (object.model == nullptr) {
+				continue;
+			}
+
+			assert(object.model->GetVertexLayout() == vertexLayout && "model vertex layout does not match the render system");
+
+			uint32_t instance = static_cast<uint32_t>(instances.size());
+			instances.push_back(ObjectData::FromGameObject(object, object.transform.mat4()));
+
+			VulkanModel& model = *object.model;
+			std::vector<DrawRecord>& records = batches[model.GetIndexType() == VK_INDEX_TYPE_UINT16 ? 1 : 0].records;
+			uint32_t submeshCount = model.HasIndexBuffer() ? model.GetLodSubmeshCount(0) : 0;
+			if (model.GetArena() != &arena || submeshCount == 0 || records.size() + submeshCount > MAX_DRAWS) {
+				directDraws.push_back({ &model, instance });
+				continue;
+			}
+
+			glm::vec4 sphere = GetInputSphere(model);
+			for (uint32_t i = 0; i < submeshCount; i++) {
+				const VulkanModel::Submesh& submesh = model.GetLodSubmesh(0, i);
+				records.push_back({ sphere, submesh.indexCount, submesh.firstIndex, submesh.vertexOffset, instance });
+			}
+		}
+		if (instances.empty()) {
+			return;
+		}
+
+		// At the start of the frame region, which both descriptor ranges cover
+		VulkanFrameAllocator::Allocation instanceAllocation = instanceAllocator.Allocate(sizeof(ObjectData) * instances.size());
+		std::copy(instances.begin(), instances.end(), static_cast<ObjectData*>(instanceAllocation.data));
+		instanceOffset = instanceAllocation.dynamicOffset;
+
+		bool anyRecords = false;
+		for (size_t i = 0; i < batches.size(); i++) {
+			Batch& batch = batches[i];
+			batch.drawCommandOffset = drawCommandBuffer->GetAlignmentSize() * (frameData.frameIndex * batches.size() + i);
+			if (batch.records.empty()) {
+				continue;
+			}
+
+			VulkanFrameAllocator::Allocation recordAllocation = recordAllocator->Allocate(sizeof(DrawRecord) * batch.records.size());
+			std::copy(batch.records.begin(), batch.records.end(), static_cast<DrawRecord*>(recordAllocation.data));
+			batch.recordOffset = recordAllocation.dynamicOffset;
+			anyRecords = true;
+		}
+		if (!anyRecords) {
+			return;
+		}
+		recordAllocator->Flush();
+
+		cullPipeline->bind(frameData.commandBuffer);
+
+		CullPushConstantData push{};
+		std::array<glm::vec4, 6> frustumPlanes = frameData.camera.GetFrustumPlanes();
+		std::copy(frustumPlanes.begin(), frustumPlanes.end(), push.frustumPlanes);
+
+		for (const Batch& batch : batches) {
+			if (batch.records.empty()) {
+				continue;
+			}
+
+			// The count and every slot a draw may read start at zero
+			vkCmdFillBuffer(
+				frameData.commandBuffer,
+				drawCommandBuffer->GetBuffer(),
+				batch.drawCommandOffset,
+				DRAW_COUNT_SIZE + sizeof(VkDrawIndexedIndirectCommand) * batch.records.size(),
+				0);
+
+			VkBufferMemoryBarrier clearBarrier{};
+			clearBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			clearBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			clearBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			clearBarrier.buffer = drawCommandBuffer->GetBuffer();
+			clearBarrier.offset = batch.drawCommandOffset;
+			clearBarrier.size = drawCommandBuffer->GetInstanceSize();
+			vkCmdPipelineBarrier(
+				frameData.commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				0,
+				0,
+				nullptr,
+				1,
+				&clearBarrier,
+				0,
+				nullptr);
+
+			uint32_t dynamicOffsets[] = { instanceOffset, batch.recordOffset, static_cast<uint32_t>(batch.drawCommandOffset) };
+			vkCmdBindDescriptorSets(
+				frameData.commandBuffer,
+				VK_PIPELINE_BIND_POINT_COMPUTE,
+				cullPipelineLayout,
+				0,
+				1,
+				&cullDescriptorSet,
+				3,
+				dynamicOffsets
+			);
+
+			push.recordCount = static_cast<uint32_t>(batch.records.size());
+			vkCmdPushConstants(
+				frameData.commandBuffer,
+				cullPipelineLayout,
+				VK_SHADER_STAGE_COMPUTE_BIT,
+				0,
+				sizeof(CullPushConstantData),
+				&push
+			);
+
+			vkCmdDispatch(frameData.commandBuffer, (push.recordCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+			VkBufferMemoryBarrier commandBarrier = clearBarrier;
+			commandBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			commandBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+			vkCmdPipelineBarrier(
+				frameData.commandBuffer,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+				0,
+				0,
+				nullptr,
+				1,
+				&commandBarrier,
+				0,
+				nullptr);
+		}
+	}
+
+	void IndirectRenderSystem::RenderGameObjects(FrameData& frameData) {
+		if (instances.empty()) {
+			return;
+		}
+
+		vulkanPipeline->bind(frameData.commandBuffer);
+
+		uint32_t dynamicOffsets[] = { frameData.globalUboOffset, instanceOffset };
+		vkCmdBindDescriptorSets(
+			frameData.commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			pipelineLayout,
+			0,
+			1,
+			&frameData.globalDescriptorSet,
+			2,
+			dynamicOffsets
+		);
+		if (bindless) {
+			vkCmdBindDescriptorSets(
+				frameData.commandBuffer,
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
+				pipelineLayout,
+				1,
+				1,
+				&frameData.bindlessDescriptorSet,
+				0,
+				nullptr
+			);
+		}
+
+		for (const Batch& batch : batches) {
+			if (batch.records.empty()) {
+				continue;
+			}
+
+			arena.Bind(frameData.commandBuffer, batch.indexType);
+
+			VkBuffer buffer = drawCommandBuffer->GetBuffer();
+			VkDeviceSize commandsOffset = batch.drawCommandOffset + DRAW_COUNT_SIZE;
+			uint32_t maxDrawCount = static_cast<uint32_t>(batch.records.size());
+			uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+			if (cmdDrawIndexedIndirectCount != nullptr) {
+				cmdDrawIndexedIndirectCount(frameData.commandBuffer, buffer, commandsOffset, buffer, batch.drawCommandOffset, maxDrawCount, stride);
+			}
+			else if (engineDevice.getEnabledFeatures().multiDrawIndirect) {
+				vkCmdDrawIndexedIndirect(frameData.commandBuffer, buffer, commandsOffset, maxDrawCount, stride);
+			}
+			else {
+				// Still no per object work on the CPU, only one call per slot
+				for (uint32_t i = 0; i < maxDrawCount; i++) {
+					vkCmdDrawIndexedIndirect(frameData.commandBuffer, buffer, commandsOffset + i * stride, 1, stride);
+				}
+			}
+		}
+
+		for (const DirectDraw& draw : directDraws) {
+			draw.model->Bind(frameData.commandBuffer);
+			draw.model->DrawInstanced(frameData.commandBuffer, 0, 1, draw.instance);
+		}
+	}
+
+	glm::vec4 IndirectRenderSystem::GetInputSphere(const VulkanModel& model) {
+		// Quantized positions fill the unit cube, the decode matrix can't be inverted for flat models
+		if (model.GetVertexLayout() == VertexLayout::Compact) {
+			return glm::vec4(glm::vec3{0.5f}, std::sqrt(3.f) * 0.5f);
+		}
+		return glm::vec4(model.GetSphereCenter(), model.GetSphereRadius());
+	}
+}
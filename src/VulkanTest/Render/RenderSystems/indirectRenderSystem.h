@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "../../Camera&Movement/vulkanCamera.h"
+#include "../Pipeline/vulkanPipeline.h"
+#include "../Pipeline/vulkanComputePipeline.h"
+#include "../Model/vulkanModel.h"
+#include "../Model/geometryArena.h"
+#include "../Descriptors/vulkanDescriptor.h"
+#include "../Buffer/vulkanBuffer.h"
+#include "../vulkanDevice.h"
+#include "../../../gameObject.h"
+#include "../vulkanFrameData.h"
+#include "objectData.h"
+
+namespace lve {
+	/*
+	* GPU driven counterpart of SimpleVulkanRenderSystem for scenes with a very large number of objects.
+	* The CPU only writes each object's transforms and one draw record per submesh into storage buffers. A compute pass
+	* tests the bounding spheres against the camera frustum and appends a VkDrawIndexedIndirectCommand plus a draw
+	* count for everything visible, and the render pass draws them with a single vkCmdDrawIndexedIndirectCount.
+	* Without VK_KHR_draw_indirect_count it calls vkCmdDrawIndexedIndirect over every slot instead, the slots past the
+	* count are zeroed and draw nothing.
+	* Only models in the geometry arena can be drawn indirectly, since every draw shares one vertex and index buffer.
+	* The arena has a 32 bit and a 16 bit index buffer, so each index type is culled and drawn as its own batch.
+	* Other models are drawn one by one. Always draws LOD 0. Needs drawIndirectFirstInstance, which lavapipe has.
+	*/
+	class IndirectRenderSystem {
+
+		VulkanDevice& engineDevice;
+		GeometryArena& arena;
+		VulkanFrameAllocator& instanceAllocator;
+
+		std::unique_ptr<VulkanPipeline> vulkanPipeline;
+		VkPipelineLayout pipelineLayout;
+
+		std::unique_ptr<VulkanComputePipeline> cullPipeline;
+		VkPipelineLayout cullPipelineLayout;
+		std::unique_ptr<VulkanDescriptorSetLayout> cullSetLayout;
+		std::unique_ptr<LveDescriptorPool> cullPool;
+		VkDescriptorSet cullDescriptorSet;
+
+		// Every model drawn by this system has to be loaded with this layout
+		VertexLayout vertexLayout;
+		// Set 1 of the graphics pipeline is FrameData::bindlessDescriptorSet, as in SimpleVulkanRenderSystem
+		bool bindless;
+
+		// Input of frustumCull.comp, sphere is in the space of the vertex inputs
+		struct DrawRecord {
+			glm::vec4 sphere{0.f};
+			uint32_t indexCount{0};
+			uint32_t firstIndex{0};
+			int32_t vertexOffset{0};
+			uint32_t instance{0};
+		};
+
+		struct DirectDraw {
+			VulkanModel* model;
+			uint32_t instance;
+		};
+
+		// The arena models of one index type, with where this frame put their records and commands
+		struct Batch {
+			VkIndexType indexType;
+			std::vector<DrawRecord> records{};
+			uint32_t recordOffset{0};
+			VkDeviceSize drawCommandOffset{0};
+		};
+
+		// Per frame in flight and batch, drawCount at the start followed by MAX_DRAWS commands
+		std::unique_ptr<VulkanFrameAllocator> recordAllocator;
+		std::unique_ptr<VulkanBuffer> drawCommandBuffer;
+		PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount{nullptr};
+
+		// Filled by Cull for the following RenderGameObjects, kept between frames so they don't allocate
+		// Same ObjectData as SimpleVulkanRenderSystem, so both use the same vertex shaders
+		std::vector<ObjectData> instances{};
+		std::array<Batch, 2> batches{ { { VK_INDEX_TYPE_UINT32 }, { VK_INDEX_TYPE_UINT16 } } };
+		std::vector<DirectDraw> directDraws{};
+		uint32_t instanceOffset{0};
+
+		void createPipelineLayouts(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout bindlessSetLayout);
+		void createpipelines(VkRenderPass renderPass);
+		void createCullDescriptorSet();
+
+		// Sphere around the model bounds in the space GetPositionDecodeMatrix maps from
+		static glm::vec4 GetInputSphere(const VulkanModel& model);
+
+	public:
+		// Draw records and command slots per frame and batch, submeshes past it are drawn one by one.
+		// Stays below the 65535 maxDrawIndirectCount every multiDrawIndirect device has
+		static constexpr uint32_t MAX_DRAWS = 32768;
+		// drawCount padded so the commands that follow it start on 16 bytes
+		static constexpr VkDeviceSize DRAW_COUNT_SIZE = 16;
+
+		IndirectRenderSystem(
+			VulkanDevice& device,
+			VkRenderPass renderPass,
+			VkDescriptorSetLayout globalSetLayout,
+			VulkanFrameAllocator& instanceAllocator,
+			GeometryArena& arena,
+			VertexLayout vertexLayout = VertexLayout::Full,
+			// VulkanBindlessSet's layout to draw in bindless mode
+			VkDescriptorSetLayout bindlessSetLayout = VK_NULL_HANDLE
+		);
+		~IndirectRenderSystem();
+
+		IndirectRenderSystem(const IndirectRenderSystem&) = delete;
+		IndirectRenderSystem& operator=(const IndirectRenderSystem&) = delete;
+
+		// Writes the frame's objects and records the culling dispatch, call before the render pass begins
+		void Cull(FrameData& frameData);
+		// Draws what the last Cull found visible, inside the render pass
+		void RenderGameObjects(FrameData& frameData);
+		// Points the culling pass at the instance allocator's buffer again after VulkanFrameAllocator::Reserve replaced it
+		void UpdateInstanceDescriptor();
+
+	};
+}
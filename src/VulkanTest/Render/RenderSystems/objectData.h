@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "../../../gameObject.h"
+
+namespace lve {
+
+	/*
+	* One drawn object in the storage buffer at set 0 binding 1, std430 in the vertex shaders.
+	* The object index is gl_InstanceIndex, so an instanced draw of a run of objects only passes firstInstance.
+	* The normal matrix is a mat3 in the shaders, std430 pads each of its columns to a vec4,
+	* and color and materialIndex share the last 16 bytes, so an object is two cache lines.
+	*/
+	struct ObjectData {
+		glm::mat4 modelMatrix{1.f};
+		glm::vec4 normalMatrix[3]{ {1.f, 0.f, 0.f, 0.f}, {0.f, 1.f, 0.f, 0.f}, {0.f, 0.f, 1.f, 0.f} };
+		glm::vec3 color{1.f};
+		uint32_t materialIndex{0};
+
+		// modelMatrix is the object's transform, the model's position decoding is folded in here
+		static ObjectData FromGameObject(GameObject& object, const glm::mat4& modelMatrix) {
+			ObjectData data{};
+			data.modelMatrix = modelMatrix * object.model->GetPositionDecodeMatrix();
+			//Useful if I want non uniform scaling
+			glm::mat3 normalMatrix = object.transform.NormalMatrix();
+			for (int column = 0; column < 3; column++) {
+				data.normalMatrix[column] = glm::vec4(normalMatrix[column], 0.f);
+			}
+			data.color = object.color;
+			data.materialIndex = object.materialIndex;
+			return data;
+		}
+	};
+	static_assert(sizeof(ObjectData) == 128, "ObjectData has to match the std430 layout in the vertex shaders");
+
+	/*
+	* One storage buffer slot of VulkanBindlessSet, read as materials[materialIndex] by the bindless vertex shaders.
+	*/
+	struct MaterialData {
+		// Multiplies the vertex and object colors
+		glm::vec4 color{1.f};
+	};
+}
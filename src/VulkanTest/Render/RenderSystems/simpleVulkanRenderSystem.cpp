@@ -1,5 +1,9 @@
 #include <stdexcept>
 #include <array>
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <string>
 //remove later
 #include <iostream>
 
@@ -13,35 +17,46 @@
 
 namespace lve {
 
-	struct SimplePushConstantData {
-		//glm::mat4 transform{1.f};
-		glm::mat4 modelMatrix{1.f};
-		glm::mat4 normalMatrix{1.f}; //Useful if I want non uniform scaling
-	};
-
-	SimpleVulkanRenderSystem::SimpleVulkanRenderSystem(VulkanDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : engineDevice{device} {
-		createPipelineLayout(globalSetLayout);
+	// A LOD is used while its simplification error covers at most this many pixels
+	constexpr float LOD_PIXEL_ERROR = 1.f;
+	// Keeps the camera inside a bounding sphere from dividing by zero, it then just gets LOD 0
+	constexpr float MIN_LOD_DISTANCE = 1e-3f;
+
+	SimpleVulkanRenderSystem::SimpleVulkanRenderSystem(
+		VulkanDevice& device,
+		VkRenderPass renderPass,
+		VkDescriptorSetLayout globalSetLayout,
+		VertexLayout vertexLayout,
+		uint32_t recordingThreads,
+		VkDescriptorSetLayout bindlessSetLayout) : engineDevice{device}, renderPass{renderPass}, vertexLayout{vertexLayout},
+		bindless{bindlessSetLayout != VK_NULL_HANDLE} {
+
+		createPipelineLayout(globalSetLayout, bindlessSetLayout);
 		createpipeline(renderPass);
+
+		if (recordingThreads > 1) {
+			recorder = std::make_unique<ParallelCommandRecorder>(device, recordingThreads);
+		}
+		bindStates.resize(recorder ? recorder->GetThreadCount() : 1);
 	}
 
 	SimpleVulkanRenderSystem::~SimpleVulkanRenderSystem() {
 		vkDestroyPipelineLayout(engineDevice.device(), pipelineLayout, nullptr);
 	}
-	void SimpleVulkanRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+	void SimpleVulkanRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout bindlessSetLayout)
 	{
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
+		// Transforms come from the instance buffer in the global set, so there are no push constants
 		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+		if (bindless) {
+			descriptorSetLayouts.push_back(bindlessSetLayout);
+		}
 
-		VkPipelineLayoutCreateInfo pipelineLayoutData;
+		VkPipelineLayoutCreateInfo pipelineLayoutData{};
 		pipelineLayoutData.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutData.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 		pipelineLayoutData.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutData.pushConstantRangeCount = 1;
-		pipelineLayoutData.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutData.pushConstantRangeCount = 0;
+		pipelineLayoutData.pPushConstantRanges = nullptr;
 
 		if (vkCreatePipelineLayout(engineDevice.device(), &pipelineLayoutData, nullptr, &pipelineLayout) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create pipeline layout");
@@ -55,55 +70,182 @@ namespace lve {
 		VulkanPipeline::DefaultPipelineConfigData(pipelineConfig);
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = pipelineLayout;
+		pipelineConfig.bindingDescriptions = VulkanModel::GetBindingDescriptions(vertexLayout);
+		pipelineConfig.attributeDescriptions = VulkanModel::GetAttributeDescriptions(vertexLayout);
+
+		// The compact layout only differs in how the vertex shader reads its inputs, the bindless variants also read the material
+		std::string vertexShader = vertexLayout == VertexLayout::Compact
+			? "src/VulkanTest/ShaderFolder/simpleShaderCompact"
+			: "src/VulkanTest/ShaderFolder/simpleShader";
+		vertexShader += bindless ? "Bindless.vert.spv" : ".vert.spv";
 		vulkanPipeline = std::make_unique<VulkanPipeline>(
 			engineDevice,
-			"src/VulkanTest/ShaderFolder/simpleShader.vert.spv",
+			vertexShader,
 			"src/VulkanTest/ShaderFolder/simpleShader.frag.spv",
 			pipelineConfig
 		);
 	}
 	void SimpleVulkanRenderSystem::RenderGameObjects(FrameData& frameData) {
 		//Timer time;
-		vulkanPipeline->bind(frameData.commandBuffer);
-
-		vkCmdBindDescriptorSets(
-			frameData.commandBuffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			pipelineLayout,
-			0, 
-			1,
-			&frameData.globalDescriptorSet,
-			0,
-			nullptr
-		);
 
-		//auto projectionView = frameData.camera.GetProjectionMatrix() * frameData.camera.GetViewMatrix();
+		// Pixels covered by one world unit at distance 1 (or at any distance for orthographic)
+		float pixelsPerUnit = frameData.camera.GetProjectionMatrix()[1][1] * 0.5f * static_cast<float>(frameData.extent.height);
+
+		uint32_t objectCount = static_cast<uint32_t>(frameData.visibleObjects.size());
+		objects.resize(objectCount);
+		drawInstances.resize(objectCount);
+		drawQueue.Resize(objectCount);
+		frameBindStatistics = {};
+		glm::vec3 cameraPosition = frameData.camera.GetPosition();
+
+		// Every visible object is written to its own slot, so threads gathering different ranges never share one
+		auto gather = [&](uint32_t first, uint32_t last) {
+			for (uint32_t i = first; i < last; i++) {
+				auto& object = *frameData.visibleObjects[i];
+
+				assert(object.model->GetVertexLayout() == vertexLayout && "model vertex layout does not match the render system");
+
+				glm::mat4 modelMatrix = object.transform.mat4();
+
+				uint32_t lod = 0;
+				if (object.model->GetLodCount() > 1) {
+					lod = object.model->SelectLod(ErrorToScreen(*object.model, modelMatrix, frameData.camera, pixelsPerUnit), LOD_PIXEL_ERROR);
+				}
+
+				objects[i] = ObjectData::FromGameObject(object, modelMatrix);
+
+				drawInstances[i] = { object.model.get(), lod };
+
+				// One pipeline and descriptor set for now, so the buffers are the first field that tells draws apart.
+				// Arena models share geometry 0 with 32 bit and 1 with 16 bit indices, the others come after them
+				DrawQueue::KeyFields keyFields{};
+				keyFields.geometry = object.model->GetArena() == nullptr ? object.model->GetSortId() + 2
+					: object.model->GetIndexType() == VK_INDEX_TYPE_UINT16 ? 1 : 0;
+				keyFields.model = object.model->GetSortId();
+				keyFields.lod = lod;
+				keyFields.depthBucket = DrawQueue::DepthBucket(glm::length(glm::vec3(modelMatrix[3]) - cameraPosition));
+				drawQueue.Set(i, DrawQueue::MakeKey(keyFields), i);
+			}
+		};
+
+		if (recorder) {
+			recorder->BeginFrame(frameData.frameIndex);
+			recorder->Run([&](uint32_t thread) {
+				gather(SliceBegin(objectCount, thread), SliceBegin(objectCount, thread + 1));
+			});
+		}
+		else {
+			gather(0, objectCount);
+		}
+		if (objectCount == 0) {
+			return;
+		}
 
-		for (auto& kv : frameData.gameObjects	) {
-			auto& object = kv.second;
+		// Model ids are masked in the key, so groups still compare the models themselves
+		drawQueue.Sort();
+		const std::vector<DrawQueue::Packet>& packets = drawQueue.GetPackets();
+
+		drawGroups.clear();
+		uint32_t firstInstance = 0;
+		while (firstInstance < objectCount) {
+			const DrawInstance& group = drawInstances[packets[firstInstance].payload];
+			uint32_t instanceCount = 1;
+			while (firstInstance + instanceCount < objectCount
+				&& drawInstances[packets[firstInstance + instanceCount].payload].model == group.model
+				&& drawInstances[packets[firstInstance + instanceCount].payload].lod == group.lod) {
+				instanceCount++;
+			}
+			drawGroups.push_back({ firstInstance, instanceCount });
+			firstInstance += instanceCount;
+		}
 
-			SimplePushConstantData push{};
-			push.modelMatrix = object.transform.mat4();	
-			//Useful if I want non uniform scaling
-			push.normalMatrix = object.transform.NormalMatrix();
+		// The whole frame's objects in draw order, so a group's objects are the run its firstInstance starts.
+		// One array at the start of the frame region, which the descriptor range covers
+		VulkanFrameAllocator::Allocation instanceAllocation = frameData.instanceAllocator.Allocate(sizeof(ObjectData) * objectCount);
+		auto* objectData = static_cast<ObjectData*>(instanceAllocation.data);
+		auto writeInstances = [&](uint32_t first, uint32_t last) {
+			for (uint32_t i = first; i < last; i++) {
+				objectData[i] = objects[packets[i].payload];
+			}
+		};
+
+		uint32_t groupCount = static_cast<uint32_t>(drawGroups.size());
+		if (recorder) {
+			// Each thread writes a share of the instances and records a share of the groups into its secondary buffer
+			recorder->Run([&](uint32_t thread) {
+				writeInstances(SliceBegin(objectCount, thread), SliceBegin(objectCount, thread + 1));
+
+				uint32_t firstGroup = SliceBegin(groupCount, thread);
+				uint32_t lastGroup = SliceBegin(groupCount, thread + 1);
+				if (firstGroup == lastGroup) {
+					return;
+				}
+				VkCommandBuffer commandBuffer = recorder->BeginSecondary(thread, renderPass);
+				// Dynamic state is not inherited from the primary buffer
+				VkViewport viewport{ 0.f, 0.f, static_cast<float>(frameData.extent.width), static_cast<float>(frameData.extent.height), 0.f, 1.f };
+				VkRect2D scissor{ {0, 0}, frameData.extent };
+				vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+				vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+				RecordDrawGroups(commandBuffer, bindStates[thread], frameData, instanceAllocation.dynamicOffset, firstGroup, lastGroup);
+			});
+			recorder->ExecuteSecondaries(frameData.commandBuffer);
+		}
+		else {
+			writeInstances(0, objectCount);
+			RecordDrawGroups(frameData.commandBuffer, bindStates[0], frameData, instanceAllocation.dynamicOffset, 0, groupCount);
+		}
 
+		for (BindStateTracker& bindState : bindStates) {
+			frameBindStatistics.Add(bindState.GetStatistics());
+			bindState.ResetStatistics();
+		}
+	}
 
-			//push.transform = projectionView * modelMatrix;
-			//push.modelMatrix = modelMatrix;
+	void SimpleVulkanRenderSystem::RecordDrawGroups(
+		VkCommandBuffer commandBuffer,
+		BindStateTracker& bindState,
+		const FrameData& frameData,
+		uint32_t instanceOffset,
+		uint32_t firstGroup,
+		uint32_t lastGroup) {
+		// Whatever was bound before belongs to other code or another command buffer
+		bindState.Reset();
+
+		// Bound per group like any other state, so a key with more pipelines or materials needs no changes here
+		uint32_t dynamicOffsets[] = { frameData.globalUboOffset, instanceOffset };
+		const std::vector<DrawQueue::Packet>& packets = drawQueue.GetPackets();
+		for (uint32_t i = firstGroup; i < lastGroup; i++) {
+			const DrawGroup& drawGroup = drawGroups[i];
+			const DrawInstance& drawInstance = drawInstances[packets[drawGroup.firstInstance].payload];
+
+			bindState.BindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkanPipeline->GetPipeline());
+			bindState.BindDescriptorSet(
+				commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, frameData.globalDescriptorSet, 2, dynamicOffsets);
+			if (bindless) {
+				bindState.BindDescriptorSet(
+					commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, frameData.bindlessDescriptorSet);
+			}
+			// Models in the same arena share their buffers, only the first of them binds
+			drawInstance.model->Bind(commandBuffer, bindState);
+			drawInstance.model->DrawInstanced(commandBuffer, drawInstance.lod, drawGroup.instanceCount, drawGroup.firstInstance);
+		}
+	}
 
-			
+	uint32_t SimpleVulkanRenderSystem::SliceBegin(uint32_t count, uint32_t thread) const {
+		return static_cast<uint32_t>(static_cast<uint64_t>(count) * thread / recorder->GetThreadCount());
+	}
 
-			vkCmdPushConstants
-			(
-				frameData.commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(SimplePushConstantData),
-				&push
-			);
-			object.model->Bind(frameData.commandBuffer);
-			object.model->Draw(frameData.commandBuffer);
+	float SimpleVulkanRenderSystem::ErrorToScreen(const VulkanModel& model, const glm::mat4& modelMatrix, const VulkanCamera& camera, float pixelsPerUnit) {
+		glm::vec3 scale{glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))};
+		float maxScale = std::max(scale.x, std::max(scale.y, scale.z));
+		if (!camera.IsPerspective()) {
+			return maxScale * pixelsPerUnit;
 		}
+
+		// Distance to the nearest point of the bounding sphere so no part of the model gets a coarser LOD than it should
+		glm::vec3 center = glm::vec3(modelMatrix * glm::vec4((model.GetMinBounds() + model.GetMaxBounds()) * 0.5f, 1.f));
+		float radius = glm::length(model.GetMaxBounds() - model.GetMinBounds()) * 0.5f * maxScale;
+		float distance = std::max(glm::length(center - camera.GetPosition()) - radius, MIN_LOD_DISTANCE);
+		return maxScale * pixelsPerUnit / distance;
 	}
 }
\ No newline at end of file
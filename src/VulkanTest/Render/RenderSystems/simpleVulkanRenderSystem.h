@@ -5,32 +5,99 @@
 
 #include "../../Camera&Movement/vulkanCamera.h"
 #include "../Pipeline/vulkanPipeline.h"
+#include "../Model/vulkanModel.h"
 #include "../vulkanDevice.h"
 #include "../../../gameObject.h"
 #include "../vulkanFrameData.h"
+#include "objectData.h"
+#include "../Renderer/parallelCommandRecorder.h"
+#include "../Renderer/drawQueue.h"
+#include "../Renderer/bindStateTracker.h"
 
 namespace lve {
 	class SimpleVulkanRenderSystem {
 
 		VulkanDevice& engineDevice;
+		VkRenderPass renderPass;
 
 		std::unique_ptr<VulkanPipeline> vulkanPipeline;
 
 		VkPipelineLayout pipelineLayout;
 
-		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
+		// Every model drawn by this system has to be loaded with this layout
+		VertexLayout vertexLayout;
+		// Set 1 is FrameData::bindlessDescriptorSet and the vertex shaders read the objects' materials from it
+		bool bindless;
+
+		// What a visible object draws, indexed by the payload of its draw packet
+		struct DrawInstance {
+			VulkanModel* model;
+			uint32_t lod;
+		};
+
+		// Consecutive sorted draw packets sharing a model and LOD, drawn with one instanced call
+		struct DrawGroup {
+			uint32_t firstInstance;
+			uint32_t instanceCount;
+		};
+
+		// Kept between frames so gathering doesn't allocate
+		std::vector<ObjectData> objects{};
+		std::vector<DrawInstance> drawInstances{};
+		std::vector<DrawGroup> drawGroups{};
+		DrawQueue drawQueue{};
+
+		// One per recording thread, statistics summed into frameBindStatistics after recording
+		std::vector<BindStateTracker> bindStates{};
+		BindStateTracker::Statistics frameBindStatistics{};
+
+		// Only created for more than one recording thread
+		std::unique_ptr<ParallelCommandRecorder> recorder;
+
+		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout bindlessSetLayout);
 		void createpipeline(VkRenderPass renderPass);
 
+		// Binds everything the draws need, so it works on the primary buffer as well as on a fresh secondary one
+		void RecordDrawGroups(
+			VkCommandBuffer commandBuffer,
+			BindStateTracker& bindState,
+			const FrameData& frameData,
+			uint32_t instanceOffset,
+			uint32_t firstGroup,
+			uint32_t lastGroup);
+		// Start of thread's share when count items are split evenly over the recording threads
+		uint32_t SliceBegin(uint32_t count, uint32_t thread) const;
+
+		// Scale from a model space LOD error to pixels on screen
+		static float ErrorToScreen(const VulkanModel& model, const glm::mat4& modelMatrix, const VulkanCamera& camera, float pixelsPerUnit);
+
 	public:
 
-		SimpleVulkanRenderSystem(VulkanDevice& device, VkRenderPass renderPas, VkDescriptorSetLayout globalSetLayout);
+		SimpleVulkanRenderSystem(
+			VulkanDevice& device,
+			VkRenderPass renderPas,
+			VkDescriptorSetLayout globalSetLayout,
+			VertexLayout vertexLayout = VertexLayout::Full,
+			// Above 1 the draws are recorded into secondary command buffers on that many threads
+			uint32_t recordingThreads = 1,
+			// VulkanBindlessSet's layout to draw in bindless mode
+			VkDescriptorSetLayout bindlessSetLayout = VK_NULL_HANDLE
+		);
 		~SimpleVulkanRenderSystem();
 
 		SimpleVulkanRenderSystem(const SimpleVulkanRenderSystem&) = delete;
 		SimpleVulkanRenderSystem& operator=(const SimpleVulkanRenderSystem&) = delete;
 		
+		// Draws frameData.visibleObjects. With recording threads the render pass has to be begun with GetSubpassContents
 		void RenderGameObjects(FrameData& frameData);
 
+		// Binds issued and skipped as redundant by the last RenderGameObjects
+		const BindStateTracker::Statistics& GetBindStatistics() const { return frameBindStatistics; }
+
+		VkSubpassContents GetSubpassContents() const {
+			return recorder ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+		}
+
 	};
 
 
@@ -0,0 +1,103 @@
+#include <cassert>
+
+#include "bindStateTracker.h"
+
+namespace lve {
+
+	void BindStateTracker::Statistics::Add(const Statistics& other) {
+		pipelineBinds += other.pipelineBinds;
+		pipelineBindsSkipped += other.pipelineBindsSkipped;
+		descriptorSetBinds += other.descriptorSetBinds;
+		descriptorSetBindsSkipped += other.descriptorSetBindsSkipped;
+		vertexBufferBinds += other.vertexBufferBinds;
+		vertexBufferBindsSkipped += other.vertexBufferBindsSkipped;
+		indexBufferBinds += other.indexBufferBinds;
+		indexBufferBindsSkipped += other.indexBufferBindsSkipped;
+	}
+
+	void BindStateTracker::Reset() {
+		pipelines = {};
+		sets = {};
+		vertexBuffer = VK_NULL_HANDLE;
+		vertexBufferOffset = 0;
+		indexBuffer = VK_NULL_HANDLE;
+		indexBufferOffset = 0;
+	}
+
+	void BindStateTracker::BindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipeline pipeline) {
+		VkPipeline& bound = pipelines[BindPointSlot(bindPoint)];
+		if (bound == pipeline) {
+			statistics.pipelineBindsSkipped++;
+			return;
+		}
+		vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
+		bound = pipeline;
+		statistics.pipelineBinds++;
+	}
+
+	void BindStateTracker::BindDescriptorSet(
+		VkCommandBuffer commandBuffer,
+		VkPipelineBindPoint bindPoint,
+		VkPipelineLayout layout,
+		uint32_t firstSet,
+		VkDescriptorSet descriptorSet,
+		uint32_t dynamicOffsetCount,
+		const uint32_t* dynamicOffsets) {
+		assert(dynamicOffsetCount <= MAX_DYNAMIC_OFFSETS && "too many dynamic offsets to track");
+
+		auto& boundSets = sets[BindPointSlot(bindPoint)];
+		if (firstSet < MAX_TRACKED_SETS) {
+			const BoundSet& bound = boundSets[firstSet];
+			bool same = bound.layout == layout && bound.descriptorSet == descriptorSet && bound.dynamicOffsetCount == dynamicOffsetCount;
+			for (uint32_t i = 0; same && i < dynamicOffsetCount; i++) {
+				same = bound.dynamicOffsets[i] == dynamicOffsets[i];
+			}
+			if (same) {
+				statistics.descriptorSetBindsSkipped++;
+				return;
+			}
+		}
+
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, firstSet, 1, &descriptorSet, dynamicOffsetCount, dynamicOffsets);
+		statistics.descriptorSetBinds++;
+
+		// A different layout may disturb the other sets, whether it does depends on compatibility rules not worth tracking
+		for (uint32_t i = 0; i < MAX_TRACKED_SETS; i++) {
+			if (i != firstSet && boundSets[i].layout != layout) {
+				boundSets[i] = {};
+			}
+		}
+		if (firstSet < MAX_TRACKED_SETS) {
+			BoundSet& bound = boundSets[firstSet];
+			bound.layout = layout;
+			bound.descriptorSet = descriptorSet;
+			bound.dynamicOffsetCount = dynamicOffsetCount;
+			for (uint32_t i = 0; i < dynamicOffsetCount; i++) {
+				bound.dynamicOffsets[i] = dynamicOffsets[i];
+			}
+		}
+	}
+
+	void BindStateTracker::BindVertexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset) {
+		if (vertexBuffer == buffer && vertexBufferOffset == offset) {
+			statistics.vertexBufferBindsSkipped++;
+			return;
+		}
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, &offset);
+		vertexBuffer = buffer;
+		vertexBufferOffset = offset;
+		statistics.vertexBufferBinds++;
+	}
+
+	void BindStateTracker::BindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType) {
+		if (indexBuffer == buffer && indexBufferOffset == offset && this->indexType == indexType) {
+			statistics.indexBufferBindsSkipped++;
+			return;
+		}
+		vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+		indexBuffer = buffer;
+		indexBufferOffset = offset;
+		this->indexType = indexType;
+		statistics.indexBufferBinds++;
+	}
+}
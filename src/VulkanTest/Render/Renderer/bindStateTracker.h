@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+namespace lve {
+
+	/*
+	* Remembers what one command buffer has bound and drops binds that would not change anything.
+	* Only sees binds made through it, call Reset whenever the buffer was bound to by other code
+	* and at the start of every command buffer, secondary buffers inherit no bindings.
+	*/
+	class BindStateTracker {
+	public:
+		// Binds issued to the command buffer and binds dropped as redundant
+		struct Statistics {
+			uint64_t pipelineBinds{0};
+			uint64_t pipelineBindsSkipped{0};
+			uint64_t descriptorSetBinds{0};
+			uint64_t descriptorSetBindsSkipped{0};
+			uint64_t vertexBufferBinds{0};
+			uint64_t vertexBufferBindsSkipped{0};
+			uint64_t indexBufferBinds{0};
+			uint64_t indexBufferBindsSkipped{0};
+
+			void Add(const Statistics& other);
+			uint64_t GetSkippedCount() const {
+				return pipelineBindsSkipped + descriptorSetBindsSkipped + vertexBufferBindsSkipped + indexBufferBindsSkipped;
+			}
+		};
+
+		static constexpr uint32_t MAX_DYNAMIC_OFFSETS = 4;
+
+		// Forgets the bound state, keeps the statistics
+		void Reset();
+
+		void BindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipeline pipeline);
+		// One set at firstSet, skipped when the set, layout and every dynamic offset match what is bound there
+		void BindDescriptorSet(
+			VkCommandBuffer commandBuffer,
+			VkPipelineBindPoint bindPoint,
+			VkPipelineLayout layout,
+			uint32_t firstSet,
+			VkDescriptorSet descriptorSet,
+			uint32_t dynamicOffsetCount = 0,
+			const uint32_t* dynamicOffsets = nullptr);
+		// Binding 0 only, which is all the vertex layouts use
+		void BindVertexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset = 0);
+		void BindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+
+		const Statistics& GetStatistics() const { return statistics; }
+		void ResetStatistics() { statistics = {}; }
+
+	private:
+		// Sets above this index are always bound, without tracking
+		static constexpr uint32_t MAX_TRACKED_SETS = 4;
+
+		struct BoundSet {
+			VkPipelineLayout layout{VK_NULL_HANDLE};
+			VkDescriptorSet descriptorSet{VK_NULL_HANDLE};
+			uint32_t dynamicOffsetCount{0};
+			std::array<uint32_t, MAX_DYNAMIC_OFFSETS> dynamicOffsets{};
+		};
+
+		std::array<VkPipeline, 2> pipelines{};
+		std::array<std::array<BoundSet, MAX_TRACKED_SETS>, 2> sets{};
+		VkBuffer vertexBuffer{VK_NULL_HANDLE};
+		VkDeviceSize vertexBufferOffset{0};
+		VkBuffer indexBuffer{VK_NULL_HANDLE};
+		VkDeviceSize indexBufferOffset{0};
+		VkIndexType indexType{VK_INDEX_TYPE_UINT16};
+
+		Statistics statistics{};
+
+		// Graphics and compute keep separate bindings
+		static uint32_t BindPointSlot(VkPipelineBindPoint bindPoint) { return bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? 1 : 0; }
+	};
+}
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "drawQueue.h"
+
+namespace lve {
+
+	// Buckets per doubling of 1 + distance, so the 12 bits reach about 65000 units and everything farther shares the last one
+	constexpr float DEPTH_BUCKETS_PER_OCTAVE = 256.f;
+
+	uint64_t DrawQueue::MakeKey(const KeyFields& fields) {
+		uint64_t key = 0;
+		auto append = [&key](uint32_t value, uint32_t bits) {
+			key = (key << bits) | (value & ((1u << bits) - 1u));
+		};
+		append(fields.pass, PASS_BITS);
+		append(fields.pipeline, PIPELINE_BITS);
+		append(fields.material, MATERIAL_BITS);
+		append(fields.geometry, GEOMETRY_BITS);
+		append(fields.model, MODEL_BITS);
+		append(fields.lod, LOD_BITS);
+		append(fields.depthBucket, DEPTH_BITS);
+		return key;
+	}
+
+	uint32_t DrawQueue::DepthBucket(float distance) {
+		float bucket = std::log2(1.f + std::max(distance, 0.f)) * DEPTH_BUCKETS_PER_OCTAVE;
+		return static_cast<uint32_t>(std::min(bucket, static_cast<float>((1u << DEPTH_BITS) - 1u)));
+	}
+
+	void DrawQueue::Sort() {
+		constexpr uint32_t DIGIT_COUNT = sizeof(uint64_t);
+		constexpr uint32_t RADIX = 256;
+
+		size_t count = packets.size();
+		if (count < 2) {
+			return;
+		}
+
+		// Histograms of every byte in one pass over the keys
+		std::array<std::array<uint32_t, RADIX>, DIGIT_COUNT> histograms{};
+		for (const Packet& packet : packets) {
+			for (uint32_t digit = 0; digit < DIGIT_COUNT; digit++) {
+				histograms[digit][(packet.key >> (digit * 8)) & 0xFF]++;
+			}
+		}
+
+		scratch.resize(count);
+		for (uint32_t digit = 0; digit < DIGIT_COUNT; digit++) {
+			auto& histogram = histograms[digit];
+			// A byte every key shares would only copy the packets over
+			if (histogram[(packets[0].key >> (digit * 8)) & 0xFF] == count) {
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (uint32_t& bucket : histogram) {
+				uint32_t bucketCount = bucket;
+				bucket = offset;
+				offset += bucketCount;
+			}
+			for (const Packet& packet : packets) {
+				scratch[histogram[(packet.key >> (digit * 8)) & 0xFF]++] = packet;
+			}
+			packets.swap(scratch);
+		}
+	}
+}
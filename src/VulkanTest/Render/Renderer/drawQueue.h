@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	/*
+	* Draw packets of one frame ordered by a 64 bit sort key, so draws sharing state end up next to each other.
+	* From the most significant bits down the key holds the pass, pipeline, material or descriptor set, geometry
+	* buffers, model, LOD and a depth bucket. Fields are masked to their width, ids that wrap only cost extra binds.
+	* Sorting is an LSD radix sort over the key bytes, bytes that are the same in every key are skipped.
+	*/
+	class DrawQueue {
+	public:
+		struct Packet {
+			uint64_t key;
+			// Index into whatever the submitting render system keeps per draw
+			uint32_t payload;
+		};
+
+		struct KeyFields {
+			uint32_t pass{0};
+			uint32_t pipeline{0};
+			uint32_t material{0};
+			uint32_t geometry{0};
+			uint32_t model{0};
+			uint32_t lod{0};
+			uint32_t depthBucket{0};
+		};
+
+		static constexpr uint32_t PASS_BITS = 2;
+		static constexpr uint32_t PIPELINE_BITS = 6;
+		static constexpr uint32_t MATERIAL_BITS = 8;
+		static constexpr uint32_t GEOMETRY_BITS = 16;
+		static constexpr uint32_t MODEL_BITS = 16;
+		static constexpr uint32_t LOD_BITS = 4;
+		static constexpr uint32_t DEPTH_BITS = 12;
+		static_assert(PASS_BITS + PIPELINE_BITS + MATERIAL_BITS + GEOMETRY_BITS + MODEL_BITS + LOD_BITS + DEPTH_BITS == 64,
+			"sort key fields have to fill 64 bits");
+
+		static uint64_t MakeKey(const KeyFields& fields);
+		// Logarithmic in the distance so near objects, where ordering saves the most overdraw, get the finer buckets
+		static uint32_t DepthBucket(float distance);
+
+		void Clear() { packets.clear(); }
+		// Sized for count packets that are then written with Set, lets several threads fill disjoint ranges
+		void Resize(uint32_t count) { packets.resize(count); }
+		void Set(uint32_t index, uint64_t key, uint32_t payload) { packets[index] = { key, payload }; }
+		void Submit(uint64_t key, uint32_t payload) { packets.push_back({ key, payload }); }
+
+		// Stable, packets with equal keys keep their submission order
+		void Sort();
+
+		const std::vector<Packet>& GetPackets() const { return packets; }
+		uint32_t GetSize() const { return static_cast<uint32_t>(packets.size()); }
+
+	private:
+		std::vector<Packet> packets{};
+		// Kept between frames so sorting doesn't allocate
+		std::vector<Packet> scratch{};
+	};
+}
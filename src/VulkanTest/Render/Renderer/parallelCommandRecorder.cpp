@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include "parallelCommandRecorder.h"
+
+namespace lve {
+
+	ParallelCommandRecorder::ParallelCommandRecorder(VulkanDevice& device, uint32_t threadCount)
+		: device{ device }, threadCount{ std::max(threadCount, 1u) } {
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = device.findPhysicalQueueFamilies().graphicsFamily;
+		// Reset as a whole each frame, never per buffer
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		threadFrames.resize(this->threadCount);
+		for (auto& frames : threadFrames) {
+			for (auto& frame : frames) {
+				if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &frame.commandPool) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create secondary command pool!");
+				}
+
+				VkCommandBufferAllocateInfo allocInfo{};
+				allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+				allocInfo.commandPool = frame.commandPool;
+				allocInfo.commandBufferCount = 1;
+				if (vkAllocateCommandBuffers(device.device(), &allocInfo, &frame.commandBuffer) != VK_SUCCESS) {
+					throw std::runtime_error("failed to allocate secondary command buffer!");
+				}
+			}
+		}
+		executeList.reserve(this->threadCount);
+
+		for (uint32_t thread = 1; thread < this->threadCount; thread++) {
+			workers.emplace_back(&ParallelCommandRecorder::WorkerLoop, this, thread);
+		}
+	}
+
+	ParallelCommandRecorder::~ParallelCommandRecorder() {
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+		}
+		jobAvailable.notify_all();
+		for (auto& worker : workers) {
+			worker.join();
+		}
+
+		// Destroying a pool frees its buffers
+		for (auto& frames : threadFrames) {
+			for (auto& frame : frames) {
+				vkDestroyCommandPool(device.device(), frame.commandPool, nullptr);
+			}
+		}
+	}
+
+	void ParallelCommandRecorder::BeginFrame(int frameIndex) {
+		assert(frameIndex >= 0 && frameIndex < vulkanSwapChain::MAX_FRAMES_IN_FLIGHT && "frame index out of range");
+		this->frameIndex = frameIndex;
+		for (auto& frames : threadFrames) {
+			ThreadFrame& frame = frames[frameIndex];
+			vkResetCommandPool(device.device(), frame.commandPool, 0);
+			frame.recording = false;
+		}
+	}
+
+	void ParallelCommandRecorder::Run(const std::function<void(uint32_t thread)>& job) {
+		if (threadCount > 1) {
+			std::lock_guard<std::mutex> lock{ mutex };
+			this->job = &job;
+			jobGeneration++;
+			runningWorkers = threadCount - 1;
+		}
+		jobAvailable.notify_all();
+
+		job(0);
+
+		if (threadCount > 1) {
+			std::unique_lock<std::mutex> lock{ mutex };
+			jobFinished.wait(lock, [&]() { return runningWorkers == 0; });
+			this->job = nullptr;
+		}
+	}
+
+	VkCommandBuffer ParallelCommandRecorder::BeginSecondary(uint32_t thread, VkRenderPass renderPass, VkFramebuffer framebuffer) {
+		assert(thread < threadCount && "thread index out of range");
+		ThreadFrame& frame = threadFrames[thread][frameIndex];
+		assert(!frame.recording && "secondary command buffer already begun this frame");
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = framebuffer;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (vkBeginCommandBuffer(frame.commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording secondary command buffer!");
+		}
+		frame.recording = true;
+		return frame.commandBuffer;
+	}
+
+	void ParallelCommandRecorder::ExecuteSecondaries(VkCommandBuffer primaryCommandBuffer) {
+		executeList.clear();
+		for (auto& frames : threadFrames) {
+			ThreadFrame& frame = frames[frameIndex];
+			if (!frame.recording) {
+				continue;
+			}
+			if (vkEndCommandBuffer(frame.commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to record secondary command buffer!");
+			}
+			frame.recording = false;
+			executeList.push_back(frame.commandBuffer);
+		}
+
+		if (!executeList.empty()) {
+			vkCmdExecuteCommands(primaryCommandBuffer, static_cast<uint32_t>(executeList.size()), executeList.data());
+		}
+	}
+
+	void ParallelCommandRecorder::WorkerLoop(uint32_t thread) {
+		uint64_t finishedGeneration = 0;
+		while (true) {
+			const std::function<void(uint32_t)>* currentJob;
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				jobAvailable.wait(lock, [&]() { return stopping || jobGeneration != finishedGeneration; });
+				if (stopping) {
+					return;
+				}
+				finishedGeneration = jobGeneration;
+				currentJob = job;
+			}
+
+			(*currentJob)(thread);
+
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				runningWorkers--;
+			}
+			jobFinished.notify_one();
+		}
+	}
+}
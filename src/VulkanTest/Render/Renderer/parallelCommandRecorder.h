@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../vulkanDevice.h"
+#include "../SwapChain/vulkanSwapChain.h"
+
+namespace lve {
+
+	/*
+	* Worker threads that record secondary command buffers for one render pass in parallel.
+	* Every thread has its own command pool per frame in flight, so recording needs no locks and a frame's
+	* pools can be reset as a whole once its fence has signaled. Thread 0 is the thread calling Run,
+	* the others wait for work between frames.
+	* Per frame: BeginFrame, then Run with a job calling BeginSecondary for its thread, then ExecuteSecondaries
+	* on the primary buffer inside a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+	*/
+	class ParallelCommandRecorder {
+	public:
+		ParallelCommandRecorder(VulkanDevice& device, uint32_t threadCount);
+		~ParallelCommandRecorder();
+
+		ParallelCommandRecorder(const ParallelCommandRecorder&) = delete;
+		ParallelCommandRecorder& operator=(const ParallelCommandRecorder&) = delete;
+
+		uint32_t GetThreadCount() const { return threadCount; }
+
+		// Resets the pools of frameIndex, only call once the frame's fence has signaled
+		void BeginFrame(int frameIndex);
+
+		// Calls job(thread) once for every thread, in parallel, and returns once all of them have finished
+		void Run(const std::function<void(uint32_t thread)>& job);
+
+		// Begins the thread's secondary buffer of the frame, continuing subpass 0 of renderPass. Call from that thread's job
+		VkCommandBuffer BeginSecondary(uint32_t thread, VkRenderPass renderPass, VkFramebuffer framebuffer = VK_NULL_HANDLE);
+		// Ends the secondaries begun this frame and executes them on primaryCommandBuffer in thread order
+		void ExecuteSecondaries(VkCommandBuffer primaryCommandBuffer);
+
+	private:
+		struct ThreadFrame {
+			VkCommandPool commandPool{VK_NULL_HANDLE};
+			VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+			bool recording{false};
+		};
+
+		void WorkerLoop(uint32_t thread);
+
+		VulkanDevice& device;
+		uint32_t threadCount;
+		int frameIndex{0};
+
+		// [thread][frame in flight]
+		std::vector<std::array<ThreadFrame, vulkanSwapChain::MAX_FRAMES_IN_FLIGHT>> threadFrames{};
+		std::vector<VkCommandBuffer> executeList{};
+
+		std::mutex mutex;
+		std::condition_variable jobAvailable;
+		std::condition_variable jobFinished;
+		const std::function<void(uint32_t)>* job{nullptr};
+		// Bumped per Run so a worker never runs the same job twice
+		uint64_t jobGeneration{0};
+		uint32_t runningWorkers{0};
+		bool stopping{false};
+
+		std::vector<std::thread> workers{};
+	};
+}
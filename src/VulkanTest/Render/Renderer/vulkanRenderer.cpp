@@ -1,5 +1,6 @@
 #include <stdexcept>
 #include <array>
+#include <mutex>
 //remove later
 #include <iostream>
 
@@ -29,7 +30,10 @@ namespace lve {
 			extent = lveWindow.getExtent();
 			glfwWaitEvents();
 		}
-		vkDeviceWaitIdle(engineDevice.device());
+		{
+			std::lock_guard<std::mutex> lock{ engineDevice.getQueueMutex() };
+			vkDeviceWaitIdle(engineDevice.device());
+		}
 
 		if (vulkanSwap == nullptr) {
 			vulkanSwap = std::make_unique<vulkanSwapChain>(engineDevice, extent);
@@ -105,9 +109,9 @@ namespace lve {
 			throw std::runtime_error("failed to present swap chain image");
 		}
 		isFrameStarted = false;
-		currentFrameIndex = (currentFrameIndex++) % vulkanSwapChain::MAX_FRAMES_IN_FLIGHT;
+		currentFrameIndex = (currentFrameIndex + 1) % vulkanSwapChain::MAX_FRAMES_IN_FLIGHT;
 	}
-	void VulkanRender::BeginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+	void VulkanRender::BeginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
 		assert(isFrameStarted && "Cannot call BeginSwapChainRenderPass() when frame is not in progress");
 		assert(commandBuffer && "Cannot begin render pass on commandBuffer when on the wrong frame");
 
@@ -127,7 +131,10 @@ namespace lve {
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+		if (contents != VK_SUBPASS_CONTENTS_INLINE) {
+			return;
+		}
 
 		VkViewport viewport{};
 		viewport.x = 0.0f;
@@ -12,7 +12,7 @@ namespace lve {
 	class VulkanRender {
 		bool isFrameStarted{ false };
 		uint32_t currentImageIndex;
-		int currentFrameIndex;
+		int currentFrameIndex{ 0 };
 		LveWindow& lveWindow;
 		VulkanDevice& engineDevice;
 
@@ -33,7 +33,8 @@ namespace lve {
 		VkCommandBuffer BeginFrame();
 		void EndFrame();
 
-		void BeginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+		// With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS only vkCmdExecuteCommands may follow, the secondaries set their own viewport
+		void BeginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 		void EndSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
 		VkRenderPass GetSwapChainRenderPass() const {
@@ -44,6 +45,10 @@ namespace lve {
 			return vulkanSwap->extentAspectRatio();
 		}
 
+		VkExtent2D GetSwapChainExtent() const {
+			return vulkanSwap->getSwapChainExtent();
+		}
+
 		bool IsFrameInProgress() const { return isFrameStarted; };
 
 		VkCommandBuffer GetCurrentCommandBuffer() const {
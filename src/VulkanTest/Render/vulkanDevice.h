@@ -1,13 +1,18 @@
 #pragma once
 
 #include "Window/vulkanWindow.h"
+#include "Buffer/vulkanMemoryAllocator.h"
 
 // std lib headers
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace lve {
 
+    class VulkanUploadContext;
+
     struct SwapChainSupportDetails {
         VkSurfaceCapabilitiesKHR capabilities;
         std::vector<VkSurfaceFormatKHR> formats;
@@ -17,9 +22,12 @@ namespace lve {
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        // Transfer only family when the device has one, otherwise the graphics family
+        uint32_t transferFamily;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
+        bool hasDedicatedTransfer() const { return transferFamily != graphicsFamily; }
     };
 
     class VulkanDevice {
@@ -30,7 +38,8 @@ namespace lve {
         const bool enableValidationLayers = true;
 #endif
 
-        VulkanDevice(LveWindow& window);
+        // enableDescriptorIndexing asks for VK_EXT_descriptor_indexing, it is only enabled when the device has it
+        VulkanDevice(LveWindow& window, bool enableDescriptorIndexing = false);
         ~VulkanDevice();
 
         // Not copyable or movable
@@ -40,10 +49,31 @@ namespace lve {
         VulkanDevice& operator=(VulkanDevice&&) = delete;
 
         VkCommandPool getCommandPool() { return commandPool; }
+        // Pool for the transfer family, only use it from the thread that records uploads
+        VkCommandPool getTransferCommandPool() { return transferCommandPool; }
         VkDevice device() { return device_; }
         VkSurfaceKHR surface() { return surface_; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        // Same queue as graphicsQueue() when there is no dedicated transfer family
+        VkQueue transferQueue() { return transferQueue_; }
+        // Hold while calling vkQueueSubmit, vkQueuePresentKHR or vkDeviceWaitIdle, models are uploaded from streaming threads
+        std::mutex& getQueueMutex() { return queueMutex; }
+        // Batches uploads into one submission, see VulkanUploadContext
+        VulkanUploadContext& getUploadContext() { return *uploadContext; }
+        // Every buffer and image created through the device is placed by this, see VulkanMemoryAllocator
+        VulkanMemoryAllocator& getMemoryAllocator() { return *memoryAllocator; }
+        // Per heap and per memory type usage, budgets come from VK_EXT_memory_budget when the device supports it
+        VulkanMemoryAllocator::DetailedStatistics getMemoryStatistics() { return memoryAllocator->GetDetailedStatistics(); }
+        std::string getMemoryStatisticsJson() { return memoryAllocator->GetStatisticsJson(); }
+        bool isMemoryBudgetEnabled() const { return memoryBudgetEnabled; }
+        // Optional features are only set when the physical device supports them
+        const VkPhysicalDeviceFeatures& getEnabledFeatures() const { return enabledFeatures; }
+        bool isDrawIndirectCountEnabled() const { return drawIndirectCountEnabled; }
+        // Requested and supported with at least what VulkanBindlessSet needs, the structs are zeroed otherwise
+        bool isDescriptorIndexingEnabled() const { return descriptorIndexingEnabled; }
+        const VkPhysicalDeviceDescriptorIndexingFeatures& getDescriptorIndexingFeatures() const { return descriptorIndexingFeatures; }
+        const VkPhysicalDeviceDescriptorIndexingProperties& getDescriptorIndexingProperties() const { return descriptorIndexingProperties; }
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -57,9 +87,11 @@ namespace lve {
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer& buffer,
-            VkDeviceMemory& bufferMemory);
+            VulkanMemoryAllocator::Allocation& bufferMemory,
+            VkMemoryPropertyFlags preferredProperties = 0);
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
+        // Both wait for the copy to finish, record into getUploadContext() instead to batch several copies
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
         void copyBufferToImage(
             VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
@@ -68,7 +100,7 @@ namespace lve {
             const VkImageCreateInfo& imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage& image,
-            VkDeviceMemory& imageMemory);
+            VulkanMemoryAllocator::Allocation& imageMemory);
 
         VkPhysicalDeviceProperties properties;
 
@@ -85,9 +117,13 @@ namespace lve {
         std::vector<const char*> getRequiredExtensions();
         bool checkValidationLayerSupport();
         QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
+        // Fills descriptorIndexingFeatures with the subset to enable, false when the device lacks a required one
+        bool queryDescriptorIndexing();
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
         void hasGflwRequiredInstanceExtensions();
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool isInstanceExtensionAvailable(const char* extensionName);
+        bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extensionName);
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance instance;
@@ -95,11 +131,26 @@ namespace lve {
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
         LveWindow& window;
         VkCommandPool commandPool;
+        VkCommandPool transferCommandPool;
 
         VkDevice device_;
         VkSurfaceKHR surface_;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
+        std::mutex queueMutex;
+        // Optional extensions, enabled when available
+        bool properties2Enabled{ false };
+        bool memoryBudgetEnabled{ false };
+        bool drawIndirectCountEnabled{ false };
+        bool descriptorIndexingRequested{ false };
+        bool descriptorIndexingEnabled{ false };
+        VkPhysicalDeviceFeatures enabledFeatures{};
+        VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
+        VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties{};
+
+        std::unique_ptr<VulkanMemoryAllocator> memoryAllocator;
+        std::unique_ptr<VulkanUploadContext> uploadContext;
 
         const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
         const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
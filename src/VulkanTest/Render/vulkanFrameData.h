@@ -2,6 +2,9 @@
 
 #include "../Camera&Movement/vulkanCamera.h"
 #include "../../gameObject.h"
+#include "Buffer/vulkanFrameAllocator.h"
+
+#include <vector>
 
 #include <vulkan/vulkan.h>
 
@@ -13,5 +16,16 @@ namespace lve {
 		VulkanCamera &camera;
 		VkDescriptorSet globalDescriptorSet;
 		GameObject::Map& gameObjects;
+		VkExtent2D extent;
+		// Transient uniform data of this frame, reset once the frame index comes around again
+		VulkanFrameAllocator& frameAllocator;
+		// Dynamic offset of this frame's GlobalUbo in globalDescriptorSet
+		uint32_t globalUboOffset;
+		// Per instance storage data of this frame, read by gl_InstanceIndex through binding 1 of globalDescriptorSet
+		VulkanFrameAllocator& instanceAllocator;
+		// Objects of gameObjects with a model whose bounds touch the camera frustum, see FrustumCuller
+		const std::vector<GameObject*>& visibleObjects;
+		// VulkanBindlessSet bound as set 1 in bindless mode, VK_NULL_HANDLE otherwise
+		VkDescriptorSet bindlessDescriptorSet;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,19 @@
+//Declarations for VulkanBindlessSet, include with #extension GL_GOOGLE_include_directive : require
+//Define BINDLESS_SET before including to bind it to another set index
+#extension GL_EXT_nonuniform_qualifier : require
+
+#ifndef BINDLESS_SET
+#define BINDLESS_SET 1
+#endif
+
+//VulkanBindlessSet::SAMPLED_IMAGE_BINDING
+layout(set = BINDLESS_SET, binding = 0) uniform sampler2D bindlessTextures[];
+
+//VulkanBindlessSet::STORAGE_BUFFER_BINDING, declare a typed view of binding 1 per buffer layout that is read
+#define BINDLESS_STORAGE_BUFFER(Name, Contents) \
+	layout(std430, set = BINDLESS_SET, binding = 1) readonly buffer Name##Block Contents Name[]
+
+//Slots can differ between invocations of one draw, so index through nonuniformEXT
+vec4 SampleBindless(uint slot, vec2 uv) {
+	return texture(bindlessTextures[nonuniformEXT(slot)], uv);
+}
@@ -14,12 +14,6 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
 	vec4 lightColor;//w is light intensity
 } ubo;
 
-layout(push_constant) uniform Push {
-	//mat4 transform; //Projection * view * model
-	mat4 modelMatrix;
-	mat4 normalMatrix; //This is for if I need to have a non-uniform scale
-} push;
-
 void main() {
 	vec3 directionToLight = ubo.lightPosition - fragPositionWorldSpace;
 
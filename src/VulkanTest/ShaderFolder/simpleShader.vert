@@ -1,9 +1,18 @@
 #version 450
 
+#ifdef BINDLESS
+//Compiled with BINDLESS defined into the Bindless.vert.spv variant, which tints objects with their material
+#extension GL_GOOGLE_include_directive : require
+#include "bindless.glsl"
+
+//MaterialData in objectData.h, ObjectData.materialIndex is the slot
+BINDLESS_STORAGE_BUFFER(materials, { vec4 color; });
+#endif
+
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
 layout(location = 2) in vec3 normal;
-layout(location = 3) in vec3 uv;
+layout(location = 3) in vec2 uv;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragPositionWorldSpace;
@@ -17,24 +26,35 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
 	vec4 lightColor;//w is light intensity
 } ubo;
 
-layout(push_constant) uniform Push {
-	//mat4 transform; //Projection * view * model
+//ObjectData in objectData.h, gl_InstanceIndex is the object index
+struct Object {
 	mat4 modelMatrix;
-	mat4 normalMatrix; //This is for if I need to have a non-uniform scale
-} push;
+	mat3 normalMatrix; //This is for if I need to have a non-uniform scale
+	vec3 color;
+	uint materialIndex;
+};
+
+//One element per drawn object, instanced draws of the same model cover a run of them
+layout(std430, set = 0, binding = 1) readonly buffer ObjectBuffer {
+	Object objects[];
+} objectBuffer;
 
 //const vec3 DIRECTION_TO_LIGHT = normalize(vec3(1.0,-3.0,-1.0));
 //const float AMBIENT_LIGHT = 0.02;
 
 void main()	{
+	Object object = objectBuffer.objects[gl_InstanceIndex];
 
-	vec4 worldPosition = push.modelMatrix * vec4(position, 1.0);
+	vec4 worldPosition = object.modelMatrix * vec4(position, 1.0);
 
 	gl_Position = ubo.projection * ubo.view * worldPosition;
 
-	fragNormalWorldSpace = normalize(mat3(push.normalMatrix) * normal);
+	fragNormalWorldSpace = normalize(object.normalMatrix * normal);
 	fragPositionWorldSpace = worldPosition.xyz;
-	fragColor = color;
+	fragColor = color * object.color;
+#ifdef BINDLESS
+	fragColor *= materials[nonuniformEXT(object.materialIndex)].color.rgb;
+#endif
 }	
 	//gl_Position = push.transform * vec4(position, 1.0);
 
@@ -0,0 +1,63 @@
+#version 450
+
+#ifdef BINDLESS
+//Compiled with BINDLESS defined into the Bindless.vert.spv variant, which tints objects with their material
+#extension GL_GOOGLE_include_directive : require
+#include "bindless.glsl"
+
+//MaterialData in objectData.h, ObjectData.materialIndex is the slot
+BINDLESS_STORAGE_BUFFER(materials, { vec4 color; });
+#endif
+
+layout(location = 0) in vec4 position; //unorm16 inside the mesh bounds, the model matrix has the bounds folded in
+layout(location = 1) in vec4 color;
+layout(location = 2) in vec2 normal; //octahedral encoded
+layout(location = 3) in vec2 uv;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPositionWorldSpace;
+layout(location = 2) out vec3 fragNormalWorldSpace;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+	mat4 projection;
+	mat4 view;
+	vec4 ambientLightColor;
+	vec3 lightPosition;
+	vec4 lightColor;//w is light intensity
+} ubo;
+
+//ObjectData in objectData.h, gl_InstanceIndex is the object index
+struct Object {
+	mat4 modelMatrix;
+	mat3 normalMatrix; //This is for if I need to have a non-uniform scale
+	vec3 color;
+	uint materialIndex;
+};
+
+//One element per drawn object, instanced draws of the same model cover a run of them
+layout(std430, set = 0, binding = 1) readonly buffer ObjectBuffer {
+	Object objects[];
+} objectBuffer;
+
+vec3 OctDecode(vec2 encoded) {
+	vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-normal.z, 0.0);
+	normal.x += normal.x >= 0.0 ? -fold : fold;
+	normal.y += normal.y >= 0.0 ? -fold : fold;
+	return normalize(normal);
+}
+
+void main()	{
+	Object object = objectBuffer.objects[gl_InstanceIndex];
+
+	vec4 worldPosition = object.modelMatrix * vec4(position.xyz, 1.0);
+
+	gl_Position = ubo.projection * ubo.view * worldPosition;
+
+	fragNormalWorldSpace = normalize(object.normalMatrix * OctDecode(normal));
+	fragPositionWorldSpace = worldPosition.xyz;
+	fragColor = color.rgb * object.color;
+#ifdef BINDLESS
+	fragColor *= materials[nonuniformEXT(object.materialIndex)].color.rgb;
+#endif
+}
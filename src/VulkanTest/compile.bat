@@ -1,4 +1,8 @@
 @echo on
 C:\GraphicsTesting\VulkanSDK\1.3.250.1\Bin\glslc.exe ShaderFolder\simpleShader.vert -o ShaderFolder\simpleShader.vert.spv
 C:\GraphicsTesting\VulkanSDK\1.3.250.1\Bin\glslc.exe ShaderFolder\simpleShader.frag -o ShaderFolder\simpleShader.frag.spv
+C:\GraphicsTesting\VulkanSDK\1.3.250.1\Bin\glslc.exe ShaderFolder\simpleShaderCompact.vert -o ShaderFolder\simpleShaderCompact.vert.spv
+C:\GraphicsTesting\VulkanSDK\1.3.250.1\Bin\glslc.exe -DBINDLESS ShaderFolder\simpleShader.vert -o ShaderFolder\simpleShaderBindless.vert.spv
+C:\GraphicsTesting\VulkanSDK\1.3.250.1\Bin\glslc.exe -DBINDLESS ShaderFolder\simpleShaderCompact.vert -o ShaderFolder\simpleShaderCompactBindless.vert.spv
+C:\GraphicsTesting\VulkanSDK\1.3.250.1\Bin\glslc.exe ShaderFolder\frustumCull.comp -o ShaderFolder\frustumCull.comp.spv
 pause
\ No newline at end of file
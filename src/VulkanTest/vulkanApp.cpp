@@ -4,6 +4,7 @@
 //remove later
 #include <iostream>
 #include <chrono>
+#include <fstream>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -13,6 +14,7 @@
 #include "Render/Buffer/vulkanBuffer.h"
 #include "Camera&Movement/vulkanCamera.h"
 #include "Render/RenderSystems/simpleVulkanRenderSystem.h"
+#include "Render/RenderSystems/indirectRenderSystem.h"
 #include "vulkanApp.h"
 #include "../timeCheck.h"
 #include "Camera&Movement/KeyboardMovementCTRL.h"
@@ -29,11 +31,16 @@ namespace lve {
 		alignas(16) glm::vec4 lightColor {1.f};//w is light intensity
 	};
 
+	// Added to a fresh bindless set in order, so MATERIALS[i] gets slot i and the default materialIndex 0 is white
+	const MaterialData MATERIALS[] = { { { 1.f, 1.f, 1.f, 1.f } }, { { 1.f, .6f, .4f, 1.f } }, { { .5f, .7f, 1.f, 1.f } } };
+	constexpr uint32_t MATERIAL_COUNT = sizeof(MATERIALS) / sizeof(MATERIALS[0]);
+
 	vulkanApp::vulkanApp() {
 		globalPool = 
 			LveDescriptorPool::Builder(engineDevice)
-			.setMaxSets(vulkanSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, vulkanSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.setMaxSets(1)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1)
 			.build();
 
 		LoadGameObjects();
@@ -43,40 +50,72 @@ namespace lve {
 
 	void vulkanApp::Run() {
 
-		std::vector<std::unique_ptr<VulkanBuffer>> uboBuffers(vulkanSwapChain::MAX_FRAMES_IN_FLIGHT);
-
-		for (int i = 0; i < uboBuffers.size(); i++) {
-			uboBuffers[i] = std::make_unique<VulkanBuffer>(
-				engineDevice,
-				sizeof(GlobalUbo),
-				1,
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-			);
-			uboBuffers[i]->Map();
-		}
+		// Uniform data of every frame in flight lives here, the GlobalUbo is just the first allocation of a frame
+		VulkanFrameAllocator frameAllocator{ engineDevice, FRAME_UNIFORM_SIZE, vulkanSwapChain::MAX_FRAMES_IN_FLIGHT };
+		// Written by the render system, one array per frame that starts at the frame's dynamic offset
+		VulkanFrameAllocator instanceAllocator{
+			engineDevice, FRAME_INSTANCE_SIZE, vulkanSwapChain::MAX_FRAMES_IN_FLIGHT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
 
 		auto globalSetLayout = VulkanDescriptorSetLayout::Builder(engineDevice)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT)
 			.build();
 
-		std::vector<VkDescriptorSet> globalDesrciptorSets(vulkanSwapChain::MAX_FRAMES_IN_FLIGHT);
-
-		for (int i = 0; i < globalDesrciptorSets.size(); i++) {
-			auto bufferData = uboBuffers[i]->DescriptorInfo();
-			LveDescriptorWriter(*globalSetLayout, *globalPool)
-				.writeBuffer(0, &bufferData)
-				.build(globalDesrciptorSets[i]
-				);
+		// One set for all frames, the dynamic offset picks the frame's GlobalUbo
+		VkDescriptorSet globalDescriptorSet;
+		auto bufferData = frameAllocator.DescriptorInfo(sizeof(GlobalUbo));
+		auto instanceData = instanceAllocator.DescriptorInfo(instanceAllocator.GetFrameSize());
+		LveDescriptorWriter(*globalSetLayout, *globalPool)
+			.writeBuffer(0, &bufferData)
+			.writeBuffer(1, &instanceData)
+			.build(globalDescriptorSet);
+
+		// Only in bindless mode. The materials never change, so they stay in host visible memory written once
+		std::unique_ptr<VulkanBindlessSet> bindlessSet;
+		std::unique_ptr<VulkanBuffer> materialBuffer;
+		if (BINDLESS_DESCRIPTORS) {
+			bindlessSet = std::make_unique<VulkanBindlessSet>(engineDevice);
+			materialBuffer = std::make_unique<VulkanBuffer>(
+				engineDevice,
+				sizeof(MaterialData),
+				MATERIAL_COUNT,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				engineDevice.properties.limits.minStorageBufferOffsetAlignment);
+			materialBuffer->Map();
+			for (uint32_t i = 0; i < MATERIAL_COUNT; i++) {
+				MaterialData material = MATERIALS[i];
+				materialBuffer->WriteToIndex(&material, i);
+				uint32_t slot = bindlessSet->AddStorageBuffer(materialBuffer->DescriptorInfoForIndex(i));
+				if (slot != i) {
+					throw std::runtime_error("failed to add the materials to the bindless set!");
+				}
+			}
 		}
+		VkDescriptorSetLayout bindlessSetLayout = bindlessSet ? bindlessSet->GetDescriptorSetLayout() : VK_NULL_HANDLE;
 
 		SimpleVulkanRenderSystem simpleRendererSystem
 		{
 			engineDevice, 
 			vulkanRenderer.GetSwapChainRenderPass(), 
-			globalSetLayout->getDescriptorSetLayout()
+			globalSetLayout->getDescriptorSetLayout(),
+			VERTEX_LAYOUT,
+			RECORDING_THREADS,
+			bindlessSetLayout
 		};
 
+		std::unique_ptr<IndirectRenderSystem> indirectRenderSystem;
+		if (GPU_DRIVEN) {
+			indirectRenderSystem = std::make_unique<IndirectRenderSystem>(
+				engineDevice,
+				vulkanRenderer.GetSwapChainRenderPass(),
+				globalSetLayout->getDescriptorSetLayout(),
+				instanceAllocator,
+				geometryArena,
+				VERTEX_LAYOUT,
+				bindlessSetLayout);
+		}
+
         VulkanCamera camera{};
 
         //camera.SetViewDirection(glm::vec3{0.f}, glm::vec3{0.5f, 0.f, 1.f});
@@ -90,6 +129,10 @@ namespace lve {
 		std::cout << "maxPushConstantsSize" << engineDevice.properties.limits.maxPushConstantsSize << "\n";
 
         auto currentTime = std::chrono::high_resolution_clock::now();
+
+		// Summed over the frames drawn by SimpleVulkanRenderSystem, printed per frame on exit
+		BindStateTracker::Statistics bindStatistics{};
+		uint32_t simpleRenderedFrames = 0;
 		
 		while (!lveWindow.ShouldClose()) {
             //Timer timePerFrame;
@@ -107,58 +150,173 @@ namespace lve {
             float aspect = vulkanRenderer.GetAspectRatio();
             camera.SetPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 100.f);
 
+			modelStreamer.Update();
+			for (auto& kv : gameObjects) {
+				auto& object = kv.second;
+				if (object.model == nullptr && object.streamedModel != nullptr && object.streamedModel->IsResident()) {
+					object.model = object.streamedModel->GetModel();
+				}
+			}
+
 			if (auto commandBuffer = vulkanRenderer.BeginFrame()) {
 
 				int frameIndex = vulkanRenderer.GetFrameIndex();
+				// BeginFrame waited for this frame index's fence, so its old allocations are no longer read
+				frameAllocator.BeginFrame(frameIndex);
+				instanceAllocator.BeginFrame(frameIndex);
+				modelRegistry.BeginFrame(frameIndex);
+				if (bindlessSet) {
+					bindlessSet->BeginFrame(frameIndex);
+				}
+
+				CullGameObjects(camera);
+
+				// Every object gets an ObjectData, or only the visible ones when culling on the CPU
+				VkDeviceSize instanceSize = sizeof(ObjectData) * (indirectRenderSystem ? cullObjects.size() : visibleObjects.size());
+				if (instanceSize > instanceAllocator.GetFrameSize()) {
+					// Frames in flight still read the old buffer, and nothing has been recorded into this frame's yet
+					{
+						std::lock_guard<std::mutex> lock{ engineDevice.getQueueMutex() };
+						vkDeviceWaitIdle(engineDevice.device());
+					}
+					instanceAllocator.Reserve(instanceSize);
+					auto grownInstanceData = instanceAllocator.DescriptorInfo(instanceAllocator.GetFrameSize());
+					LveDescriptorWriter(*globalSetLayout, *globalPool)
+						.writeBuffer(1, &grownInstanceData)
+						.overwrite(globalDescriptorSet);
+					if (indirectRenderSystem) {
+						indirectRenderSystem->UpdateInstanceDescriptor();
+					}
+				}
+
+				//Update
+				GlobalUbo ubo{};
+				ubo.projection = camera.GetProjectionMatrix();
+				ubo.view = camera.GetViewMatrix();
+				uint32_t globalUboOffset = frameAllocator.Push(ubo);
+
 				FrameData frameData
 				{
 					frameIndex,
 					frameTime,
 					commandBuffer,
 					camera,
-					globalDesrciptorSets[frameIndex],
-					gameObjects
+					globalDescriptorSet,
+					gameObjects,
+					vulkanRenderer.GetSwapChainExtent(),
+					frameAllocator,
+					globalUboOffset,
+					instanceAllocator,
+					visibleObjects,
+					bindlessSet ? bindlessSet->GetDescriptorSet() : VK_NULL_HANDLE
 				};
 
-
-				//Update
-				GlobalUbo ubo{};
-				ubo.projection = camera.GetProjectionMatrix();
-				ubo.view = camera.GetViewMatrix();
-				uboBuffers[frameIndex]->WriteToBuffer(&ubo);
-				uboBuffers[frameIndex]->Flush();
-
 				//Render
-				vulkanRenderer.BeginSwapChainRenderPass(commandBuffer);
-				simpleRendererSystem.RenderGameObjects(frameData);
+				if (indirectRenderSystem) {
+					indirectRenderSystem->Cull(frameData);
+				}
+				vulkanRenderer.BeginSwapChainRenderPass(
+					commandBuffer, indirectRenderSystem ? VK_SUBPASS_CONTENTS_INLINE : simpleRendererSystem.GetSubpassContents());
+				if (indirectRenderSystem) {
+					indirectRenderSystem->RenderGameObjects(frameData);
+				}
+				else {
+					simpleRendererSystem.RenderGameObjects(frameData);
+					bindStatistics.Add(simpleRendererSystem.GetBindStatistics());
+					simpleRenderedFrames++;
+				}
 				vulkanRenderer.EndSwapChainRenderPass(commandBuffer);
+				frameAllocator.Flush();
+				instanceAllocator.Flush();
 				vulkanRenderer.EndFrame();
 			}
 		}
 
+		if (simpleRenderedFrames > 0) {
+			uint64_t issuedBinds = bindStatistics.pipelineBinds + bindStatistics.descriptorSetBinds
+				+ bindStatistics.vertexBufferBinds + bindStatistics.indexBufferBinds;
+			std::cout << "Binds per frame: " << issuedBinds / simpleRenderedFrames << " issued, "
+				<< bindStatistics.GetSkippedCount() / simpleRenderedFrames << " skipped ("
+				<< bindStatistics.pipelineBindsSkipped / simpleRenderedFrames << " pipeline, "
+				<< bindStatistics.descriptorSetBindsSkipped / simpleRenderedFrames << " descriptor set, "
+				<< bindStatistics.vertexBufferBindsSkipped / simpleRenderedFrames << " vertex buffer, "
+				<< bindStatistics.indexBufferBindsSkipped / simpleRenderedFrames << " index buffer)\n";
+		}
+
+		ModelRegistry::Statistics registryStatistics = modelRegistry.GetStatistics();
+		std::cout << "Model registry: " << registryStatistics.hits << " hits, " << registryStatistics.contentHits << " content hits, "
+			<< registryStatistics.misses << " misses, " << registryStatistics.residentModels << " models in "
+			<< registryStatistics.residentBytes << " bytes\n";
+
+		if (bindlessSet) {
+			VulkanBindlessSet::Statistics bindlessStatistics = bindlessSet->GetStatistics();
+			std::cout << "Bindless set: " << bindlessStatistics.storageBufferSlotsUsed << "/" << bindlessStatistics.storageBufferSlotCapacity
+				<< " storage buffers, " << bindlessStatistics.imageSlotsUsed << "/" << bindlessStatistics.imageSlotCapacity << " images\n";
+		}
+
+		GeometryArena::Statistics arenaStatistics = geometryArena.GetStatistics();
+		std::cout << "Geometry arena: " << arenaStatistics.allocationCount << " models, "
+			<< arenaStatistics.usedVertices << "/" << arenaStatistics.vertexCapacity << " vertices, "
+			<< arenaStatistics.usedIndices << "/" << arenaStatistics.indexCapacity << " 32 bit indices, "
+			<< arenaStatistics.usedShortIndices << "/" << arenaStatistics.shortIndexCapacity << " 16 bit indices\n";
+
+		VulkanMemoryAllocator::DetailedStatistics memoryStatistics = engineDevice.getMemoryStatistics();
+		std::cout << "Device memory: " << memoryStatistics.total.allocationCount << " allocations, "
+			<< memoryStatistics.total.usedBytes << "/" << memoryStatistics.total.allocatedBytes << " bytes used, "
+			<< memoryStatistics.total.fragmentation * 100.f << "% fragmented\n";
+		for (uint32_t i = 0; i < memoryStatistics.budgets.size(); i++) {
+			std::cout << "\theap " << i << ": " << memoryStatistics.budgets[i].usage << "/" << memoryStatistics.budgets[i].budget
+				<< (memoryStatistics.budgetFromDriver ? " bytes of budget\n" : " bytes of estimated budget\n");
+		}
+		std::ofstream(MEMORY_STATISTICS_PATH) << engineDevice.getMemoryStatisticsJson();
+
+		std::lock_guard<std::mutex> lock{ engineDevice.getQueueMutex() };
 		vkDeviceWaitIdle(engineDevice.device());
 	}
 
+	void vulkanApp::CullGameObjects(const VulkanCamera& camera) {
+		frustumCuller.Clear();
+		cullObjects.clear();
+		for (auto& kv : gameObjects) {
+			auto& object = kv.second;
+			if (object.model == nullptr) {
+				continue;
+			}
+			// LOD 0 bounds, the simplified LODs stay inside them closely enough
+			frustumCuller.Add(object.transform.mat4(), object.model->GetMinBounds(), object.model->GetMaxBounds());
+			cullObjects.push_back(&object);
+		}
+
+		frustumCuller.Cull(camera.GetFrustumPlanes(), visibleIndices);
+		visibleObjects.clear();
+		for (uint32_t index : visibleIndices) {
+			visibleObjects.push_back(cullObjects[index]);
+		}
+	}
+
 	void vulkanApp::LoadGameObjects() {
-		std::shared_ptr<VulkanModel> lveModel =
-			VulkanModel::CreateModelFromDevice(engineDevice, "src/Models/flat_vase.obj");
+		ModelLoadSettings loadSettings{};
+		loadSettings.vertexLayout = VERTEX_LAYOUT;
+		loadSettings.buildLods = true;
+
+		// Objects show up once their model is resident, the first frame doesn't wait for any of them
 		auto flatVase = GameObject::CreateGameObject();
-		flatVase.model = lveModel;
+		flatVase.streamedModel = modelStreamer.Load("src/Models/flat_vase.obj", loadSettings);
 		flatVase.transform.translation = { -.5f, .5f, 0.f };
 		flatVase.transform.scale = { 3.f, 1.5f, 3.f };
+		flatVase.materialIndex = 1;
 		gameObjects.emplace(flatVase.GetId(), std::move(flatVase));
 
-		lveModel = VulkanModel::CreateModelFromDevice(engineDevice, "src/Models/smooth_vase.obj");
 		auto smoothVase = GameObject::CreateGameObject();
-		smoothVase.model = lveModel;
+		smoothVase.streamedModel = modelStreamer.Load("src/Models/smooth_vase.obj", loadSettings);
 		smoothVase.transform.translation = { .5f, .5f, 0.f };
 		smoothVase.transform.scale = { 3.f, 1.5f, 3.f };
+		smoothVase.materialIndex = 2;
 		gameObjects.emplace(smoothVase.GetId(), std::move(smoothVase));
 
 
-		lveModel = VulkanModel::CreateModelFromDevice(engineDevice, "src/Models/quad.obj");
 		auto floor = GameObject::CreateGameObject();
-		floor.model = lveModel;
+		floor.streamedModel = modelStreamer.Load("src/Models/quad.obj", loadSettings);
 		floor.transform.translation = { 0.f, .5f, 0.f };
 		floor.transform.scale = { 3.f, 1.5f, 3.f };
 		gameObjects.emplace(floor.GetId(), std::move(floor));
@@ -7,19 +7,37 @@
 #include "Render/vulkanDevice.h"
 #include "../gameObject.h"
 #include "Render/Renderer/vulkanRenderer.h"
+#include "Render/Model/modelStreamer.h"
+#include "Render/Model/geometryArena.h"
 #include "Render/Descriptors/vulkanDescriptor.h"
+#include "Render/Descriptors/vulkanBindlessSet.h"
+#include "Render/Culling/frustumCuller.h"
+#include "Camera&Movement/vulkanCamera.h"
 
 namespace lve {
 	class vulkanApp{
 		LveWindow lveWindow{ WIDTH, HEIGHT, "VulkanTest" };
 
-		VulkanDevice engineDevice{lveWindow};
+		VulkanDevice engineDevice{ lveWindow, BINDLESS_DESCRIPTORS };
 
 		VulkanRender vulkanRenderer{ lveWindow, engineDevice };
 
+		// Declared before the registry so it outlives every model holding a range of it
+		GeometryArena geometryArena{ engineDevice, VERTEX_LAYOUT, ARENA_VERTEX_CAPACITY, ARENA_INDEX_CAPACITY, ARENA_SHORT_INDEX_CAPACITY };
+		ModelRegistry modelRegistry{ engineDevice, &geometryArena };
+		ModelStreamer modelStreamer{ engineDevice, modelRegistry, STREAMING_THREADS };
+
 		//std::vector<GameObject>(gameObjects);
 
 		void LoadGameObjects();
+		// Fills visibleObjects with the objects whose model bounds touch the camera frustum
+		void CullGameObjects(const VulkanCamera& camera);
+
+		// Kept between frames so culling doesn't allocate, cullObjects[i] is box i of frustumCuller
+		FrustumCuller frustumCuller{};
+		std::vector<GameObject*> cullObjects{};
+		std::vector<uint32_t> visibleIndices{};
+		std::vector<GameObject*> visibleObjects{};
 
 		// note: order of declarations matters
 		std::unique_ptr<LveDescriptorPool> globalPool{};
@@ -29,6 +47,33 @@ namespace lve {
 		static constexpr int WIDTH = 1920;
 		static constexpr int HEIGHT = 1080;
 
+		static constexpr uint32_t STREAMING_THREADS = 2;
+		// Threads recording SimpleVulkanRenderSystem's draws into secondary command buffers, 1 records inline on the main thread
+		static constexpr uint32_t RECORDING_THREADS = 1;
+
+		// Models that don't fit get their own buffers, so these only have to cover the usual scene
+		static constexpr uint32_t ARENA_VERTEX_CAPACITY = 1u << 20;
+		static constexpr uint32_t ARENA_INDEX_CAPACITY = 4u << 20;
+		static constexpr uint32_t ARENA_SHORT_INDEX_CAPACITY = 2u << 20;
+
+		// Transient uniform data per frame in flight, see VulkanFrameAllocator
+		static constexpr VkDeviceSize FRAME_UNIFORM_SIZE = 256 * 1024;
+		// Starting ObjectData region per frame in flight (128 bytes each, 32768 objects), grows with the scene
+		static constexpr VkDeviceSize FRAME_INSTANCE_SIZE = 4 * 1024 * 1024;
+
+		// Written to the working directory on exit and ignored by git, see VulkanMemoryAllocator::GetStatisticsJson
+		static constexpr const char* MEMORY_STATISTICS_PATH = "memory_statistics.json";
+
+		// Culls and builds the draws on the GPU with IndirectRenderSystem, needs frustumCull.comp compiled
+		static constexpr bool GPU_DRIVEN = false;
+
+		// Binds a VulkanBindlessSet as set 1 and tints each object with the material its materialIndex points at.
+		// Needs a device with descriptor indexing and the Bindless.vert.spv shaders compiled, see compile.bat
+		static constexpr bool BINDLESS_DESCRIPTORS = false;
+
+		// Compact needs simpleShaderCompact.vert compiled, see compile.bat
+		static constexpr VertexLayout VERTEX_LAYOUT = VertexLayout::Full;
+
 		vulkanApp();
 		~vulkanApp();
 
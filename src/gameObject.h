@@ -5,6 +5,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "VulkanTest/Render/Model/vulkanModel.h"
+#include "VulkanTest/Render/Model/modelStreamer.h"
 
 namespace lve {
 
@@ -32,8 +33,13 @@ namespace lve {
 		using Map = std::unordered_map<id_t, GameObject>;
 
 
+		// Null while streamedModel is still loading, such objects are not drawn
 		std::shared_ptr<VulkanModel> model{};
-		glm::vec3 color{};
+		std::shared_ptr<StreamedModel> streamedModel{};
+		// Multiplies the vertex colors
+		glm::vec3 color{1.f};
+		// Slot of the object's MaterialData in the bindless set, only read when vulkanApp::BINDLESS_DESCRIPTORS is on
+		uint32_t materialIndex{0};
 		TransformComponent transform{};
 
 		GameObject(const GameObject&) = delete;
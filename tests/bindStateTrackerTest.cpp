@@ -0,0 +1,158 @@
+//std
+#include <cstdint>
+#include <vector>
+
+#include "../src/VulkanTest/Render/Renderer/bindStateTracker.h"
+#include "testCheck.h"
+
+/*
+* Checks which binds BindStateTracker passes on to the command buffer and which it drops.
+* The test is not linked against Vulkan, it defines the four vkCmdBind functions the tracker calls itself
+* and records every call in commandLog instead.
+*/
+
+namespace {
+
+	enum class Command { Pipeline, DescriptorSets, VertexBuffers, IndexBuffer };
+	std::vector<Command> commandLog{};
+
+	template<typename Handle>
+	Handle FakeHandle(uintptr_t value) {
+		return reinterpret_cast<Handle>(value);
+	}
+}
+
+extern "C" {
+	VKAPI_ATTR void VKAPI_CALL vkCmdBindPipeline(VkCommandBuffer, VkPipelineBindPoint, VkPipeline) {
+		commandLog.push_back(Command::Pipeline);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdBindDescriptorSets(
+		VkCommandBuffer, VkPipelineBindPoint, VkPipelineLayout, uint32_t, uint32_t, const VkDescriptorSet*, uint32_t, const uint32_t*) {
+		commandLog.push_back(Command::DescriptorSets);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdBindVertexBuffers(VkCommandBuffer, uint32_t, uint32_t, const VkBuffer*, const VkDeviceSize*) {
+		commandLog.push_back(Command::VertexBuffers);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdBindIndexBuffer(VkCommandBuffer, VkBuffer, VkDeviceSize, VkIndexType) {
+		commandLog.push_back(Command::IndexBuffer);
+	}
+}
+
+namespace {
+
+	using lve::BindStateTracker;
+
+	const VkCommandBuffer COMMAND_BUFFER = VK_NULL_HANDLE;
+
+	void TestPipelines() {
+		commandLog.clear();
+		BindStateTracker tracker{};
+		VkPipeline first = FakeHandle<VkPipeline>(1);
+		VkPipeline second = FakeHandle<VkPipeline>(2);
+
+		tracker.BindPipeline(COMMAND_BUFFER, VK_PIPELINE_BIND_POINT_GRAPHICS, first);
+		tracker.BindPipeline(COMMAND_BUFFER, VK_PIPELINE_BIND_POINT_GRAPHICS, first);
+		// Compute has its own binding
+		tracker.BindPipeline(COMMAND_BUFFER, VK_PIPELINE_BIND_POINT_COMPUTE, first);
+		tracker.BindPipeline(COMMAND_BUFFER, VK_PIPELINE_BIND_POINT_GRAPHICS, second);
+		tracker.BindPipeline(COMMAND_BUFFER, VK_PIPELINE_BIND_POINT_GRAPHICS, first);
+
+		CHECK(commandLog.size() == 4);
+		CHECK(tracker.GetStatistics().pipelineBinds == 4);
+		CHECK(tracker.GetStatistics().pipelineBindsSkipped == 1);
+	}
+
+	void TestDescriptorSets() {
+		commandLog.clear();
+		BindStateTracker tracker{};
+		VkPipelineLayout layout = FakeHandle<VkPipelineLayout>(1);
+		VkPipelineLayout otherLayout = FakeHandle<VkPipelineLayout>(2);
+		VkDescriptorSet globalSet = FakeHandle<VkDescriptorSet>(3);
+		VkDescriptorSet materialSet = FakeHandle<VkDescriptorSet>(4);
+		const VkPipelineBindPoint graphics = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		uint32_t offsets[] = { 0, 256 };
+		uint32_t movedOffsets[] = { 0, 512 };
+
+		tracker.BindDescriptorSet(COMMAND_BUFFER, graphics, layout, 0, globalSet, 2, offsets);
+		tracker.BindDescriptorSet(COMMAND_BUFFER, graphics, layout, 0, globalSet, 2, offsets);
+		CHECK(commandLog.size() == 1);
+
+		// A different dynamic offset is a new bind
+		tracker.BindDescriptorSet(COMMAND_BUFFER, graphics, layout, 0, globalSet, 2, movedOffsets);
+		CHECK(commandLog.size() == 2);
+
+		// Another set index under the same layout leaves set 0 alone
+		tracker.BindDescriptorSet(COMMAND_BUFFER, graphics, layout, 1, materialSet);
+		tracker.BindDescriptorSet(COMMAND_BUFFER, graphics, layout, 0, globalSet, 2, movedOffsets);
+		CHECK(commandLog.size() == 3);
+
+		// A different layout forgets the other sets
+		tracker.BindDescriptorSet(COMMAND_BUFFER, graphics, otherLayout, 1, materialSet);
+		tracker.BindDescriptorSet(COMMAND_BUFFER, graphics, otherLayout, 0, globalSet, 2, movedOffsets);
+		CHECK(commandLog.size() == 5);
+
+		CHECK(tracker.GetStatistics().descriptorSetBinds == 5);
+		CHECK(tracker.GetStatistics().descriptorSetBindsSkipped == 2);
+	}
+
+	void TestBuffers() {
+		commandLog.clear();
+		BindStateTracker tracker{};
+		VkBuffer vertexBuffer = FakeHandle<VkBuffer>(1);
+		VkBuffer indexBuffer = FakeHandle<VkBuffer>(2);
+		VkBuffer shortIndexBuffer = FakeHandle<VkBuffer>(3);
+
+		tracker.BindVertexBuffer(COMMAND_BUFFER, vertexBuffer);
+		tracker.BindVertexBuffer(COMMAND_BUFFER, vertexBuffer);
+		tracker.BindVertexBuffer(COMMAND_BUFFER, vertexBuffer, 64);
+		CHECK(tracker.GetStatistics().vertexBufferBinds == 2);
+		CHECK(tracker.GetStatistics().vertexBufferBindsSkipped == 1);
+
+		tracker.BindIndexBuffer(COMMAND_BUFFER, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		tracker.BindIndexBuffer(COMMAND_BUFFER, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		// Same buffer read with another index type has to be rebound
+		tracker.BindIndexBuffer(COMMAND_BUFFER, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+		tracker.BindIndexBuffer(COMMAND_BUFFER, shortIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
+		tracker.BindIndexBuffer(COMMAND_BUFFER, shortIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
+		CHECK(tracker.GetStatistics().indexBufferBinds == 3);
+		CHECK(tracker.GetStatistics().indexBufferBindsSkipped == 2);
+
+		CHECK(commandLog.size() == 5);
+		CHECK(tracker.GetStatistics().GetSkippedCount() == 3);
+	}
+
+	void TestReset() {
+		commandLog.clear();
+		BindStateTracker tracker{};
+		VkPipeline pipeline = FakeHandle<VkPipeline>(1);
+		VkBuffer buffer = FakeHandle<VkBuffer>(2);
+
+		tracker.BindPipeline(COMMAND_BUFFER, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		tracker.BindVertexBuffer(COMMAND_BUFFER, buffer);
+		tracker.Reset();
+		// A new command buffer starts with nothing bound, so both are bound again
+		tracker.BindPipeline(COMMAND_BUFFER, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		tracker.BindVertexBuffer(COMMAND_BUFFER, buffer);
+		CHECK(commandLog.size() == 4);
+
+		// Reset keeps the statistics, ResetStatistics clears them and Add sums them up
+		CHECK(tracker.GetStatistics().pipelineBinds == 2);
+		BindStateTracker::Statistics total{};
+		total.Add(tracker.GetStatistics());
+		total.Add(tracker.GetStatistics());
+		CHECK(total.pipelineBinds == 4 && total.vertexBufferBinds == 4);
+		tracker.ResetStatistics();
+		CHECK(tracker.GetStatistics().pipelineBinds == 0);
+	}
+}
+
+int main() {
+	TestPipelines();
+	TestDescriptorSets();
+	TestBuffers();
+	TestReset();
+	return lvetest::FinishTest("bindStateTrackerTest");
+}
@@ -0,0 +1,163 @@
+//std
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../src/VulkanTest/Render/Renderer/drawQueue.h"
+#include "testCheck.h"
+
+/*
+* Checks DrawQueue::Sort against std::stable_sort, including keys where some bytes are the same everywhere
+* and the radix sort skips them, and that MakeKey keeps every field inside its bits.
+* Payloads are the submission order, so comparing packets also checks the sort is stable.
+*/
+
+namespace {
+
+	using lve::DrawQueue;
+	using Packet = DrawQueue::Packet;
+
+	void CheckSortMatches(const std::vector<uint64_t>& keys) {
+		DrawQueue queue{};
+		std::vector<Packet> expected{};
+		for (uint32_t i = 0; i < keys.size(); i++) {
+			queue.Submit(keys[i], i);
+			expected.push_back({ keys[i], i });
+		}
+		std::stable_sort(expected.begin(), expected.end(), [](const Packet& a, const Packet& b) { return a.key < b.key; });
+
+		queue.Sort();
+		const std::vector<Packet>& sorted = queue.GetPackets();
+		CHECK(sorted.size() == expected.size());
+		bool same = sorted.size() == expected.size();
+		for (size_t i = 0; same && i < sorted.size(); i++) {
+			same = sorted[i].key == expected[i].key && sorted[i].payload == expected[i].payload;
+		}
+		CHECK(same);
+	}
+
+	std::vector<uint64_t> RandomKeys(std::mt19937_64& random, uint32_t count, uint64_t mask, uint64_t fixedBits) {
+		std::vector<uint64_t> keys(count);
+		for (uint64_t& key : keys) {
+			key = (random() & mask) | fixedBits;
+		}
+		return keys;
+	}
+
+	void TestRandomKeys() {
+		std::mt19937_64 random{ 7 };
+		CheckSortMatches(RandomKeys(random, 5000, ~0ull, 0));
+		// Few distinct keys, so most packets only stay in order if the sort is stable
+		CheckSortMatches(RandomKeys(random, 5000, 0x0300000000000003ull, 0));
+	}
+
+	void TestConstantBytes() {
+		std::mt19937_64 random{ 11 };
+		// Only some bytes differ, the others are skipped. Odd and even counts of sorted bytes both have to end up in packets
+		CheckSortMatches(RandomKeys(random, 3000, 0x00000000000000FFull, 0xAB00000000000000ull));
+		CheckSortMatches(RandomKeys(random, 3000, 0x00FF0000FF000000ull, 0x0000110000002200ull));
+		CheckSortMatches(RandomKeys(random, 3000, 0xFF00FF00FF000000ull, 0x00000000000000CDull));
+		CheckSortMatches(RandomKeys(random, 3000, 0x00000000000F0FFFull, 0));
+		// Every byte constant, nothing may move
+		CheckSortMatches(std::vector<uint64_t>(100, 0x0123456789ABCDEFull));
+	}
+
+	void TestSmallQueues() {
+		CheckSortMatches({});
+		CheckSortMatches({ 42 });
+		CheckSortMatches({ 2, 1 });
+		CheckSortMatches({ 1, 1 });
+	}
+
+	void TestSetAfterResize() {
+		DrawQueue queue{};
+		queue.Resize(3);
+		queue.Set(2, 5, 0);
+		queue.Set(0, 9, 1);
+		queue.Set(1, 5, 2);
+		queue.Sort();
+		// Equal keys keep the order of their slots, not the order Set was called in
+		const std::vector<Packet>& sorted = queue.GetPackets();
+		CHECK(queue.GetSize() == 3);
+		CHECK(sorted[0].payload == 2 && sorted[1].payload == 0 && sorted[2].payload == 1);
+
+		queue.Clear();
+		CHECK(queue.GetSize() == 0);
+	}
+
+	void TestMakeKeyMasksFields() {
+		DrawQueue::KeyFields allBits{ ~0u, ~0u, ~0u, ~0u, ~0u, ~0u, ~0u };
+		CHECK(DrawQueue::MakeKey(allBits) == ~0ull);
+		CHECK(DrawQueue::MakeKey({}) == 0);
+
+		// Each field alone, with every bit set, fills exactly its own bits, from the most significant down
+		uint32_t DrawQueue::KeyFields::* fields[] = {
+			&DrawQueue::KeyFields::pass,
+			&DrawQueue::KeyFields::pipeline,
+			&DrawQueue::KeyFields::material,
+			&DrawQueue::KeyFields::geometry,
+			&DrawQueue::KeyFields::model,
+			&DrawQueue::KeyFields::lod,
+			&DrawQueue::KeyFields::depthBucket
+		};
+		const uint32_t widths[] = {
+			DrawQueue::PASS_BITS,
+			DrawQueue::PIPELINE_BITS,
+			DrawQueue::MATERIAL_BITS,
+			DrawQueue::GEOMETRY_BITS,
+			DrawQueue::MODEL_BITS,
+			DrawQueue::LOD_BITS,
+			DrawQueue::DEPTH_BITS
+		};
+		uint32_t shift = 64;
+		for (size_t i = 0; i < sizeof(widths) / sizeof(widths[0]); i++) {
+			shift -= widths[i];
+			uint64_t fieldMask = ((1ull << widths[i]) - 1) << shift;
+
+			DrawQueue::KeyFields keyFields{};
+			keyFields.*fields[i] = ~0u;
+			CHECK(DrawQueue::MakeKey(keyFields) == fieldMask);
+
+			// A value one past the width wraps to zero instead of carrying into the next field
+			keyFields.*fields[i] = 1u << widths[i];
+			CHECK(DrawQueue::MakeKey(keyFields) == 0);
+
+			keyFields.*fields[i] = (1u << widths[i]) + 1;
+			CHECK(DrawQueue::MakeKey(keyFields) == 1ull << shift);
+		}
+		CHECK(shift == 0);
+
+		// A more significant field outweighs everything below it
+		DrawQueue::KeyFields low{ 0, ~0u, ~0u, ~0u, ~0u, ~0u, ~0u };
+		DrawQueue::KeyFields high{};
+		high.pass = 1;
+		CHECK(DrawQueue::MakeKey(high) > DrawQueue::MakeKey(low));
+	}
+
+	void TestDepthBucket() {
+		CHECK(DrawQueue::DepthBucket(0.f) == 0);
+		CHECK(DrawQueue::DepthBucket(-5.f) == 0);
+		CHECK(DrawQueue::DepthBucket(1e30f) == (1u << DrawQueue::DEPTH_BITS) - 1);
+
+		uint32_t previous = 0;
+		bool monotonic = true;
+		for (float distance = 0.f; distance < 100000.f; distance = distance * 1.1f + 0.01f) {
+			uint32_t bucket = DrawQueue::DepthBucket(distance);
+			monotonic = monotonic && bucket >= previous;
+			previous = bucket;
+		}
+		CHECK(monotonic);
+		CHECK(DrawQueue::DepthBucket(1.f) < DrawQueue::DepthBucket(2.f));
+	}
+}
+
+int main() {
+	TestRandomKeys();
+	TestConstantBytes();
+	TestSmallQueues();
+	TestSetAfterResize();
+	TestMakeKeyMasksFields();
+	TestDepthBucket();
+	return lvetest::FinishTest("drawQueueTest");
+}
@@ -0,0 +1,151 @@
+//std
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../src/VulkanTest/Render/Culling/frustumCuller.h"
+#include "../src/VulkanTest/Camera&Movement/vulkanCamera.h"
+#include "testCheck.h"
+
+/*
+* Checks that FrustumCuller::Cull, whichever SIMD path it was built with, reports exactly the boxes CullScalar does.
+* Box counts are picked to not be a multiple of LANE_COUNT so the scalar tail after the last batch runs too.
+*/
+
+namespace {
+
+	using lve::FrustumCuller;
+
+	// Axis aligned frustum from -10 to 10 on x and y and 0 to 20 on z, every value exact in float
+	const std::array<glm::vec4, 6> BOX_PLANES = { {
+		{ 1.f, 0.f, 0.f, 10.f },
+		{ -1.f, 0.f, 0.f, 10.f },
+		{ 0.f, 1.f, 0.f, 10.f },
+		{ 0.f, -1.f, 0.f, 10.f },
+		{ 0.f, 0.f, 1.f, 0.f },
+		{ 0.f, 0.f, -1.f, 20.f }
+	} };
+
+	std::array<glm::vec4, 6> CameraPlanes() {
+		lve::VulkanCamera camera{};
+		camera.SetPerspectiveProjection(glm::radians(60.f), 16.f / 9.f, 0.1f, 100.f);
+		camera.SetViewDirection(glm::vec3{ 0.f }, glm::vec3{ 0.3f, -0.2f, 1.f });
+		return camera.GetFrustumPlanes();
+	}
+
+	void CheckPathsAgree(const FrustumCuller& culler, const std::array<glm::vec4, 6>& planes) {
+		std::vector<uint32_t> visible{};
+		std::vector<uint32_t> scalarVisible{};
+		culler.Cull(planes, visible);
+		culler.CullScalar(planes, scalarVisible);
+		CHECK(visible == scalarVisible);
+	}
+
+	void TestRandomBoxes() {
+		std::mt19937 random{ 42 };
+		std::uniform_real_distribution<float> position{ -100.f, 100.f };
+		std::uniform_real_distribution<float> size{ 0.1f, 5.f };
+
+		// One short of a multiple of every lane count
+		const uint32_t boxCount = 1024 * FrustumCuller::LANE_COUNT + 7;
+		FrustumCuller culler{};
+		culler.Reserve(boxCount);
+		for (uint32_t i = 0; i < boxCount; i++) {
+			culler.Add(glm::vec3{ position(random), position(random), position(random) }, glm::vec3{ size(random), size(random), size(random) });
+		}
+		CHECK(culler.GetBoxCount() == boxCount);
+
+		std::vector<uint32_t> visible{};
+		culler.Cull(CameraPlanes(), visible);
+		CHECK(!visible.empty() && visible.size() < boxCount);
+
+		CheckPathsAgree(culler, CameraPlanes());
+		CheckPathsAgree(culler, BOX_PLANES);
+	}
+
+	void TestBoxesTouchingPlanes() {
+		struct Case {
+			glm::vec3 center;
+			glm::vec3 extent;
+			bool visible;
+		};
+		// Touching counts as inside, a box just past a plane is culled
+		const Case cases[] = {
+			{ { -11.f, 0.f, 10.f }, { 1.f, 1.f, 1.f }, true },
+			{ { -11.5f, 0.f, 10.f }, { 1.f, 1.f, 1.f }, false },
+			{ { 11.f, 0.f, 10.f }, { 1.f, 1.f, 1.f }, true },
+			{ { 12.f, 0.f, 10.f }, { 1.f, 1.f, 1.f }, false },
+			{ { 0.f, -10.5f, 10.f }, { 2.f, 0.5f, 2.f }, true },
+			{ { 0.f, 10.25f, 10.f }, { 2.f, 0.25f, 2.f }, true },
+			{ { 0.f, 10.5f, 10.f }, { 2.f, 0.25f, 2.f }, false },
+			{ { 0.f, 0.f, -1.f }, { 1.f, 1.f, 1.f }, true },
+			{ { 0.f, 0.f, 21.f }, { 1.f, 1.f, 1.f }, true },
+			{ { 0.f, 0.f, 21.5f }, { 1.f, 1.f, 1.f }, false },
+			{ { 0.f, 0.f, 10.f }, { 0.f, 0.f, 0.f }, true },
+		};
+		constexpr uint32_t caseCount = sizeof(cases) / sizeof(cases[0]);
+
+		// Every case lands in a different lane each round, and the last round ends inside the scalar tail
+		FrustumCuller culler{};
+		std::vector<uint32_t> expected{};
+		for (uint32_t round = 0; round < 3; round++) {
+			for (const Case& boxCase : cases) {
+				uint32_t index = culler.Add(boxCase.center, boxCase.extent);
+				if (boxCase.visible) {
+					expected.push_back(index);
+				}
+			}
+		}
+		CHECK(culler.GetBoxCount() == 3 * caseCount);
+
+		std::vector<uint32_t> visible{};
+		culler.Cull(BOX_PLANES, visible);
+		CHECK(visible == expected);
+		culler.CullScalar(BOX_PLANES, visible);
+		CHECK(visible == expected);
+	}
+
+	void TestFewerBoxesThanLanes() {
+		FrustumCuller culler{};
+		std::vector<uint32_t> visible{ 7 };
+		culler.Cull(BOX_PLANES, visible);
+		CHECK(visible.empty());
+
+		culler.Add({ 0.f, 0.f, 10.f }, { 1.f, 1.f, 1.f });
+		culler.Add({ 50.f, 0.f, 10.f }, { 1.f, 1.f, 1.f });
+		culler.Cull(BOX_PLANES, visible);
+		CHECK(visible == std::vector<uint32_t>{ 0 });
+		CheckPathsAgree(culler, CameraPlanes());
+	}
+
+	void TestTransformedBounds() {
+		// Quarter turn around z swaps the x and y extents
+		glm::mat4 modelMatrix{ 1.f };
+		modelMatrix[0] = { 0.f, 1.f, 0.f, 0.f };
+		modelMatrix[1] = { -1.f, 0.f, 0.f, 0.f };
+		modelMatrix[3] = { 0.f, 0.f, 10.f, 1.f };
+
+		FrustumCuller culler{};
+		culler.Add(modelMatrix, { 10.f, -1.f, -1.f }, { 12.f, 1.f, 1.f });
+		culler.Add(modelMatrix, { -1.f, 10.f, -1.f }, { 1.f, 11.f, 1.f });
+
+		// The first box ends up on y from 10 to 12, touching the y plane, the second on x from -11 to -10
+		std::vector<uint32_t> visible{};
+		culler.Cull(BOX_PLANES, visible);
+		CHECK((visible == std::vector<uint32_t>{ 0, 1 }));
+
+		culler.Clear();
+		culler.Add(modelMatrix, { 10.5f, -1.f, -1.f }, { 12.f, 1.f, 1.f });
+		culler.Cull(BOX_PLANES, visible);
+		CHECK(visible.empty());
+	}
+}
+
+int main() {
+	TestRandomBoxes();
+	TestBoxesTouchingPlanes();
+	TestFewerBoxesThanLanes();
+	TestTransformedBounds();
+	return lvetest::FinishTest("frustumCullerTest");
+}
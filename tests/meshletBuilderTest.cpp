@@ -0,0 +1,366 @@
+//std
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../src/VulkanTest/Render/Model/meshletBuilder.h"
+#include "testCheck.h"
+
+/*
+* CPU checks for MeshletBuilder::Build and ComputeBounds on generated meshes, no device needed.
+* Every test rebuilds the meshlets of a mesh and checks the result against the index buffer it came from.
+*/
+
+namespace {
+
+	using lve::MeshletBuilder;
+	using Builder = lve::VulkanModel::Builder;
+	using Meshlet = lve::VulkanModel::Meshlet;
+	using MeshletBounds = lve::VulkanModel::MeshletBounds;
+
+	constexpr float PI = 3.14159265358979f;
+
+	void AddVertex(Builder& builder, glm::vec3 position) {
+		lve::VulkanModel::Vertex vertex{};
+		vertex.position = position;
+		builder.vertices.push_back(vertex);
+	}
+
+	// Flat grid in the xy plane, every triangle faces +z
+	Builder MakeGrid(uint32_t quadsPerSide) {
+		Builder builder{};
+		uint32_t verticesPerSide = quadsPerSide + 1;
+		for (uint32_t y = 0; y < verticesPerSide; y++) {
+			for (uint32_t x = 0; x < verticesPerSide; x++) {
+				AddVertex(builder, { static_cast<float>(x) / quadsPerSide, static_cast<float>(y) / quadsPerSide, 0.f });
+			}
+		}
+		for (uint32_t y = 0; y < quadsPerSide; y++) {
+			for (uint32_t x = 0; x < quadsPerSide; x++) {
+				uint32_t a = y * verticesPerSide + x;
+				uint32_t b = a + 1;
+				uint32_t c = b + verticesPerSide;
+				uint32_t d = a + verticesPerSide;
+				builder.indicies.insert(builder.indicies.end(), { a, b, c, a, c, d });
+			}
+		}
+		return builder;
+	}
+
+	// Unit sphere from latitude / longitude rings, every triangle faces outwards (or inwards, which makes every meshlet concave).
+	// The pole rows hold degenerate triangles
+	Builder MakeSphere(uint32_t rings, uint32_t segments, bool inwards = false) {
+		Builder builder{};
+		for (uint32_t ring = 0; ring <= rings; ring++) {
+			float theta = PI * ring / rings;
+			for (uint32_t segment = 0; segment <= segments; segment++) {
+				float phi = 2.f * PI * segment / segments;
+				AddVertex(builder, { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+			}
+		}
+
+		auto addTriangle = [&](uint32_t a, uint32_t b, uint32_t c) {
+			const glm::vec3& p0 = builder.vertices[a].position;
+			glm::vec3 normal = glm::cross(builder.vertices[b].position - p0, builder.vertices[c].position - p0);
+			if ((glm::dot(normal, p0 + builder.vertices[b].position + builder.vertices[c].position) < 0.f) != inwards) {
+				std::swap(b, c);
+			}
+			builder.indicies.insert(builder.indicies.end(), { a, b, c });
+		};
+		for (uint32_t ring = 0; ring < rings; ring++) {
+			for (uint32_t segment = 0; segment < segments; segment++) {
+				uint32_t a = ring * (segments + 1) + segment;
+				uint32_t b = a + 1;
+				uint32_t c = b + segments + 1;
+				uint32_t d = a + segments + 1;
+				addTriangle(a, b, c);
+				addTriangle(a, c, d);
+			}
+		}
+		return builder;
+	}
+
+	// Unit cube with 4 vertices per face, so each face can fall into a different meshlet
+	Builder MakeCube() {
+		Builder builder{};
+		const glm::vec3 normals[] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+		for (const glm::vec3& normal : normals) {
+			glm::vec3 tangent = std::abs(normal.x) > 0.f ? glm::vec3{ 0, 1, 0 } : glm::vec3{ 1, 0, 0 };
+			glm::vec3 bitangent = glm::cross(normal, tangent);
+			uint32_t first = static_cast<uint32_t>(builder.vertices.size());
+			AddVertex(builder, normal - tangent - bitangent);
+			AddVertex(builder, normal + tangent - bitangent);
+			AddVertex(builder, normal + tangent + bitangent);
+			AddVertex(builder, normal - tangent + bitangent);
+			builder.indicies.insert(builder.indicies.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+		}
+		return builder;
+	}
+
+	// Random triangles over a small vertex pool, so vertices are shared in no particular order and some triangles repeat a corner
+	Builder MakeTriangleSoup(uint32_t vertexCount, uint32_t triangleCount, uint32_t seed) {
+		Builder builder{};
+		std::mt19937 random{ seed };
+		std::uniform_real_distribution<float> coordinate{ -1.f, 1.f };
+		std::uniform_int_distribution<uint32_t> vertex{ 0, vertexCount - 1 };
+		for (uint32_t i = 0; i < vertexCount; i++) {
+			AddVertex(builder, { coordinate(random), coordinate(random), coordinate(random) });
+		}
+		for (uint32_t i = 0; i < triangleCount * 3; i++) {
+			builder.indicies.push_back(vertex(random));
+		}
+		return builder;
+	}
+
+	uint32_t LocalIndex(const Builder& builder, const Meshlet& meshlet, uint32_t triangle, uint32_t corner) {
+		return builder.meshletTriangles[(meshlet.triangleOffset + triangle) * 3 + corner];
+	}
+
+	// Limits hold, the meshlets tile the index buffer in order and rebuild every triangle of it exactly once
+	void CheckMeshlets(const Builder& builder, uint32_t maxVertices, uint32_t maxTriangles) {
+		CHECK(!builder.meshlets.empty());
+		CHECK(builder.meshletBounds.size() == builder.meshlets.size());
+		CHECK(builder.meshletTriangles.size() % 4 == 0);
+
+		uint32_t nextIndex = 0;
+		uint32_t nextVertexOffset = 0;
+		uint32_t nextTriangleOffset = 0;
+		for (const auto& meshlet : builder.meshlets) {
+			CHECK(meshlet.vertexCount >= 1 && meshlet.vertexCount <= maxVertices);
+			CHECK(meshlet.triangleCount >= 1 && meshlet.triangleCount <= maxTriangles);
+			CHECK(meshlet.firstIndex == nextIndex);
+			CHECK(meshlet.vertexOffset == nextVertexOffset);
+			CHECK(meshlet.triangleOffset == nextTriangleOffset);
+			CHECK(meshlet.vertexOffset + meshlet.vertexCount <= builder.meshletVertices.size());
+			CHECK((meshlet.triangleOffset + meshlet.triangleCount) * 3 <= builder.meshletTriangles.size());
+
+			// No vertex is listed twice within a meshlet
+			std::vector<uint32_t> vertices(
+				builder.meshletVertices.begin() + meshlet.vertexOffset,
+				builder.meshletVertices.begin() + meshlet.vertexOffset + meshlet.vertexCount);
+			std::sort(vertices.begin(), vertices.end());
+			CHECK(std::adjacent_find(vertices.begin(), vertices.end()) == vertices.end());
+
+			for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++) {
+				for (uint32_t corner = 0; corner < 3; corner++) {
+					uint32_t localIndex = LocalIndex(builder, meshlet, triangle, corner);
+					CHECK(localIndex < meshlet.vertexCount);
+					uint32_t vertex = builder.meshletVertices[meshlet.vertexOffset + localIndex];
+					CHECK(vertex == builder.indicies[meshlet.firstIndex + triangle * 3 + corner]);
+				}
+			}
+
+			nextIndex = meshlet.firstIndex + meshlet.triangleCount * 3;
+			nextVertexOffset += meshlet.vertexCount;
+			nextTriangleOffset += meshlet.triangleCount;
+		}
+		CHECK(nextIndex == builder.indicies.size());
+		CHECK(nextVertexOffset == builder.meshletVertices.size());
+	}
+
+	// Every vertex a meshlet references is inside its bounding sphere
+	void CheckSpheres(const Builder& builder) {
+		for (size_t i = 0; i < builder.meshlets.size(); i++) {
+			const Meshlet& meshlet = builder.meshlets[i];
+			const MeshletBounds& bounds = builder.meshletBounds[i];
+			for (uint32_t j = 0; j < meshlet.vertexCount; j++) {
+				const glm::vec3& position = builder.vertices[builder.meshletVertices[meshlet.vertexOffset + j]].position;
+				CHECK(glm::length(position - bounds.center) <= bounds.radius * (1.f + 1e-5f) + 1e-6f);
+			}
+		}
+	}
+
+	// Whenever the cone says a meshlet is backfacing, no triangle in it may face the camera.
+	// Returns how many meshlet / camera pairs were culled so callers can check the test is not vacuous
+	uint32_t CheckConesAreConservative(const Builder& builder, const std::vector<glm::vec3>& cameras) {
+		uint32_t culled = 0;
+		for (size_t i = 0; i < builder.meshlets.size(); i++) {
+			const Meshlet& meshlet = builder.meshlets[i];
+			const MeshletBounds& bounds = builder.meshletBounds[i];
+			for (const glm::vec3& camera : cameras) {
+				if (!bounds.IsBackfacing(camera)) {
+					continue;
+				}
+				culled++;
+				for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++) {
+					auto position = [&](uint32_t corner) -> const glm::vec3& {
+						uint32_t localIndex = LocalIndex(builder, meshlet, triangle, corner);
+						return builder.vertices[builder.meshletVertices[meshlet.vertexOffset + localIndex]].position;
+					};
+					glm::vec3 normal = glm::cross(position(1) - position(0), position(2) - position(0));
+					CHECK(glm::dot(normal, camera - position(0)) <= 1e-4f * glm::length(normal));
+				}
+			}
+		}
+		return culled;
+	}
+
+	std::vector<glm::vec3> RandomCameras(uint32_t count, float extent, uint32_t seed) {
+		std::mt19937 random{ seed };
+		std::uniform_real_distribution<float> coordinate{ -extent, extent };
+		std::vector<glm::vec3> cameras{};
+		for (uint32_t i = 0; i < count; i++) {
+			cameras.push_back({ coordinate(random), coordinate(random), coordinate(random) });
+		}
+		return cameras;
+	}
+
+	void TestDefaultLimits() {
+		Builder builder = MakeTriangleSoup(500, 2000, 1);
+		MeshletBuilder::Build(builder);
+		CheckMeshlets(builder, MeshletBuilder::MAX_VERTICES, MeshletBuilder::MAX_TRIANGLES);
+		CheckSpheres(builder);
+
+		// A grid shares enough vertices that the triangle limit is the one that splits it
+		Builder grid = MakeGrid(64);
+		MeshletBuilder::Build(grid);
+		CheckMeshlets(grid, MeshletBuilder::MAX_VERTICES, MeshletBuilder::MAX_TRIANGLES);
+		CHECK(std::any_of(grid.meshlets.begin(), grid.meshlets.end(), [](const Meshlet& meshlet) {
+			return meshlet.vertexCount == MeshletBuilder::MAX_VERTICES || meshlet.triangleCount == MeshletBuilder::MAX_TRIANGLES;
+		}));
+	}
+
+	void TestCustomLimits() {
+		for (auto [maxVertices, maxTriangles] : { std::pair<uint32_t, uint32_t>{ 3, 1 }, { 16, 8 }, { 8, 124 }, { 254, 4 } }) {
+			Builder builder = MakeTriangleSoup(300, 1000, maxVertices * 31 + maxTriangles);
+			MeshletBuilder::Build(builder, maxVertices, maxTriangles);
+			CheckMeshlets(builder, maxVertices, maxTriangles);
+			CheckSpheres(builder);
+
+			Builder sphere = MakeSphere(12, 24);
+			MeshletBuilder::Build(sphere, maxVertices, maxTriangles);
+			CheckMeshlets(sphere, maxVertices, maxTriangles);
+			CheckSpheres(sphere);
+		}
+	}
+
+	void TestSubmeshBoundaries() {
+		// Two copies of a grid back to back, the second one indexed relative to its own vertices like LoadModel does
+		Builder builder = MakeGrid(10);
+		uint32_t firstIndexCount = static_cast<uint32_t>(builder.indicies.size());
+		uint32_t firstVertexCount = static_cast<uint32_t>(builder.vertices.size());
+		Builder second = MakeGrid(10);
+		for (auto& vertex : second.vertices) {
+			vertex.position.z = 1.f;
+			builder.vertices.push_back(vertex);
+		}
+		for (uint32_t index : second.indicies) {
+			builder.indicies.push_back(index + firstVertexCount);
+		}
+		builder.submeshes.push_back({ 0, firstIndexCount, 0 });
+		builder.submeshes.push_back({ firstIndexCount, static_cast<uint32_t>(second.indicies.size()), static_cast<int32_t>(firstVertexCount) });
+
+		MeshletBuilder::Build(builder);
+		CheckMeshlets(builder, MeshletBuilder::MAX_VERTICES, MeshletBuilder::MAX_TRIANGLES);
+		for (const auto& meshlet : builder.meshlets) {
+			uint32_t lastIndex = meshlet.firstIndex + meshlet.triangleCount * 3;
+			bool inFirst = lastIndex <= firstIndexCount;
+			bool inSecond = meshlet.firstIndex >= firstIndexCount;
+			CHECK(inFirst || inSecond);
+			CHECK(meshlet.baseVertex == (inSecond ? static_cast<int32_t>(firstVertexCount) : 0));
+		}
+	}
+
+	void TestLodsAreSkipped() {
+		Builder builder = MakeGrid(8);
+		uint32_t lod0Count = static_cast<uint32_t>(builder.indicies.size());
+		builder.indicies.insert(builder.indicies.end(), { 0, 8, 80 });
+		builder.lods.push_back({ 0, lod0Count, 0.f });
+		builder.lods.push_back({ lod0Count, 3, 0.5f });
+		builder.submeshes.push_back({ 0, lod0Count, 0 });
+		builder.submeshes.push_back({ lod0Count, 3, 0 });
+
+		MeshletBuilder::Build(builder);
+		const Meshlet& last = builder.meshlets.back();
+		CHECK(last.firstIndex + last.triangleCount * 3 == lod0Count);
+	}
+
+	void TestFlatGridCone() {
+		Builder builder = MakeGrid(16);
+		MeshletBuilder::Build(builder);
+		CheckSpheres(builder);
+
+		for (size_t i = 0; i < builder.meshlets.size(); i++) {
+			const MeshletBounds& bounds = builder.meshletBounds[i];
+			// All normals are +z, so the cone is as tight as it gets
+			CHECK(std::abs(bounds.coneAxis.z - 1.f) < 1e-5f);
+			CHECK(bounds.coneCutoff < 1e-3f);
+			CHECK(bounds.IsBackfacing(bounds.center + glm::vec3{ 0.3f, -0.2f, -2.f }));
+			CHECK(!bounds.IsBackfacing(bounds.center + glm::vec3{ 0.3f, -0.2f, 2.f }));
+		}
+		CHECK(CheckConesAreConservative(builder, RandomCameras(200, 3.f, 2)) > 0);
+	}
+
+	void TestSphereCones() {
+		Builder builder = MakeSphere(24, 48);
+		MeshletBuilder::Build(builder);
+		CheckMeshlets(builder, MeshletBuilder::MAX_VERTICES, MeshletBuilder::MAX_TRIANGLES);
+		CheckSpheres(builder);
+
+		// Cameras inside the sphere see every triangle from behind, far away cameras cull the far side
+		std::vector<glm::vec3> cameras = RandomCameras(200, 4.f, 3);
+		cameras.push_back({ 0.f, 0.f, 0.f });
+		cameras.push_back({ 0.f, 0.f, 10.f });
+		CHECK(CheckConesAreConservative(builder, cameras) > 0);
+
+		// Smaller meshlets are flatter, so more of them get a usable cone
+		MeshletBuilder::Build(builder, 16, 8);
+		CheckSpheres(builder);
+		CHECK(CheckConesAreConservative(builder, cameras) > 0);
+
+		// Seen from inside, the triangle planes pass in front of the sphere center and the apex has to move back
+		Builder inside = MakeSphere(24, 48, true);
+		MeshletBuilder::Build(inside, 16, 8);
+		CheckSpheres(inside);
+		std::vector<glm::vec3> nearSurface = RandomCameras(2000, 1.2f, 5);
+		CHECK(CheckConesAreConservative(inside, nearSurface) > 0);
+	}
+
+	void TestCubeCones() {
+		Builder builder = MakeCube();
+		MeshletBuilder::Build(builder, 4, 2);
+		CheckMeshlets(builder, 4, 2);
+		CheckSpheres(builder);
+		CHECK(builder.meshlets.size() == 6);
+
+		// One meshlet per face, each face is culled from anywhere behind its plane
+		for (size_t i = 0; i < builder.meshlets.size(); i++) {
+			const MeshletBounds& bounds = builder.meshletBounds[i];
+			CHECK(bounds.coneCutoff < 1e-3f);
+			CHECK(bounds.IsBackfacing(-bounds.coneAxis * 0.5f));
+			CHECK(!bounds.IsBackfacing(bounds.coneAxis * 3.f));
+		}
+		CHECK(CheckConesAreConservative(builder, RandomCameras(200, 4.f, 4)) > 0);
+
+		// Faces pointing opposite ways in one meshlet average out, that cone must never cull
+		MeshletBuilder::Build(builder);
+		CHECK(builder.meshlets.size() == 1);
+		CHECK(builder.meshletBounds[0].coneCutoff == 1.f);
+	}
+
+	void TestDegenerateMeshlet() {
+		Builder builder{};
+		AddVertex(builder, { 0.f, 0.f, 0.f });
+		AddVertex(builder, { 1.f, 0.f, 0.f });
+		builder.indicies = { 0, 1, 1, 1, 0, 0 };
+		MeshletBuilder::Build(builder);
+		CheckMeshlets(builder, MeshletBuilder::MAX_VERTICES, MeshletBuilder::MAX_TRIANGLES);
+		CheckSpheres(builder);
+		CHECK(builder.meshletBounds[0].coneCutoff == 1.f);
+		CHECK(!builder.meshletBounds[0].IsBackfacing({ 0.f, 0.f, 5.f }));
+	}
+}
+
+int main() {
+	TestDefaultLimits();
+	TestCustomLimits();
+	TestSubmeshBoundaries();
+	TestLodsAreSkipped();
+	TestFlatGridCone();
+	TestSphereCones();
+	TestCubeCones();
+	TestDegenerateMeshlet();
+	return lvetest::FinishTest("meshletBuilderTest");
+}
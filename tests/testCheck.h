@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// Minimal checks for the CPU side tests. A failed CHECK prints where it failed and the test keeps going,
+// FinishTest then returns the exit code ctest looks at
+
+namespace lvetest {
+
+	inline int& FailureCount() {
+		static int failures = 0;
+		return failures;
+	}
+
+	inline int FinishTest(const char* testName) {
+		if (FailureCount() == 0) {
+			std::cout << testName << ": passed\n";
+			return EXIT_SUCCESS;
+		}
+		std::cout << testName << ": " << FailureCount() << " checks failed\n";
+		return EXIT_FAILURE;
+	}
+}
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+			lvetest::FailureCount()++; \
+		} \
+	} while (false)
@@ -0,0 +1,330 @@
+#include "../src/VulkanTest/Render/Buffer/vulkanMemoryAllocator.h"
+#include "testCheck.h"
+
+// std
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+/*
+ * Placement checks for VulkanMemoryAllocator against a fake memory properties table, no GPU needed.
+ * The fake device hands out made up VkDeviceMemory handles and fails allocations that don't fit their heap,
+ * the way vkAllocateMemory returns VK_ERROR_OUT_OF_DEVICE_MEMORY.
+ */
+
+namespace {
+
+    using lve::VulkanMemoryAllocator;
+    using Allocation = VulkanMemoryAllocator::Allocation;
+    using ResourceKind = VulkanMemoryAllocator::ResourceKind;
+
+    constexpr VkDeviceSize MB = 1024 * 1024;
+    constexpr VkDeviceSize ATOM_SIZE = 256;
+
+    // Discrete GPU without resizable BAR: a device local heap, a large host heap and a small device local and host visible heap
+    constexpr uint32_t DEVICE_TYPE = 0;
+    constexpr uint32_t HOST_TYPE = 1;
+    constexpr uint32_t BAR_TYPE = 2;
+    constexpr VkDeviceSize DEVICE_HEAP_SIZE = 512 * MB;  // Small heap, blocks of an eighth
+    constexpr VkDeviceSize HOST_HEAP_SIZE = 4096 * MB;   // DEFAULT_BLOCK_SIZE blocks
+    constexpr VkDeviceSize BAR_HEAP_SIZE = 256 * MB;
+
+    class FakeDevice {
+    public:
+        FakeDevice() {
+            properties.memoryTypeCount = 3;
+            properties.memoryTypes[DEVICE_TYPE] = { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0 };
+            properties.memoryTypes[HOST_TYPE] = { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1 };
+            properties.memoryTypes[BAR_TYPE] = {
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 2 };
+            properties.memoryHeapCount = 3;
+            properties.memoryHeaps[0] = { DEVICE_HEAP_SIZE, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT };
+            properties.memoryHeaps[1] = { HOST_HEAP_SIZE, 0 };
+            properties.memoryHeaps[2] = { BAR_HEAP_SIZE, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT };
+        }
+
+        VulkanMemoryAllocator::MemoryFunctions Functions() {
+            VulkanMemoryAllocator::MemoryFunctions functions{};
+            functions.allocate = [this](uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory& memory) {
+                uint32_t heap = properties.memoryTypes[memoryTypeIndex].heapIndex;
+                if (heapUsage[heap] + size > properties.memoryHeaps[heap].size) {
+                    return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+                }
+                heapUsage[heap] += size;
+                allocateCount++;
+                memory = reinterpret_cast<VkDeviceMemory>(nextHandle++);
+                live[memory] = { memoryTypeIndex, size };
+                return VK_SUCCESS;
+            };
+            functions.free = [this](VkDeviceMemory memory) {
+                auto found = live.find(memory);
+                CHECK(found != live.end());
+                if (found != live.end()) {
+                    heapUsage[properties.memoryTypes[found->second.memoryTypeIndex].heapIndex] -= found->second.size;
+                    live.erase(found);
+                }
+            };
+            functions.map = [](VkDeviceMemory memory, void** data) {
+                *data = MappedBase(memory);
+                return VK_SUCCESS;
+            };
+            functions.unmap = [](VkDeviceMemory) {};
+            return functions;
+        }
+
+        // Never dereferenced, only used to check the offset Map adds
+        static char* MappedBase(VkDeviceMemory memory) {
+            return reinterpret_cast<char*>(memory) + 0x100000;
+        }
+
+        uint32_t LiveCount(uint32_t memoryTypeIndex) const {
+            uint32_t count = 0;
+            for (const auto& entry : live) {
+                count += entry.second.memoryTypeIndex == memoryTypeIndex;
+            }
+            return count;
+        }
+
+        struct Memory {
+            uint32_t memoryTypeIndex;
+            VkDeviceSize size;
+        };
+
+        VkPhysicalDeviceMemoryProperties properties{};
+        VkDeviceSize heapUsage[VK_MAX_MEMORY_HEAPS]{};
+        std::map<VkDeviceMemory, Memory> live{};
+        uint32_t allocateCount{0};
+        uintptr_t nextHandle{0x1000};
+    };
+
+    VkMemoryRequirements Requirements(VkDeviceSize size, uint32_t memoryTypeBits = 0x7, VkDeviceSize alignment = 256) {
+        return { size, alignment, memoryTypeBits };
+    }
+
+    void FreeAll(VulkanMemoryAllocator& allocator, std::vector<Allocation>& allocations) {
+        for (auto& allocation : allocations) {
+            allocator.Free(allocation);
+        }
+        allocations.clear();
+    }
+
+    void TestMemoryTypeSelection() {
+        FakeDevice device{};
+        VulkanMemoryAllocator allocator{ device.properties, 1, ATOM_SIZE, device.Functions() };
+
+        CHECK(allocator.FindMemoryType(0x7, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == DEVICE_TYPE);
+        // Host memory stays out of device local heaps unless it asks for them
+        CHECK(allocator.FindMemoryType(0x7, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == HOST_TYPE);
+        CHECK(allocator.FindMemoryType(0x7, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == BAR_TYPE);
+        CHECK(allocator.FindMemoryType(1u << HOST_TYPE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == HOST_TYPE);
+
+        bool threw = false;
+        try {
+            allocator.FindMemoryType(1u << DEVICE_TYPE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        }
+        catch (const std::runtime_error&) {
+            threw = true;
+        }
+        CHECK(threw);
+    }
+
+    void TestFallbackWhenHeapIsFull() {
+        FakeDevice device{};
+        VulkanMemoryAllocator allocator{ device.properties, 1, ATOM_SIZE, device.Functions() };
+        VkDeviceSize barBlockSize = BAR_HEAP_SIZE / 8;
+
+        // Fill the BAR heap with shared allocations until one spills over into the next type with the same properties
+        std::vector<Allocation> allocations{};
+        for (int i = 0; i < 64; i++) {
+            allocations.push_back(allocator.Allocate(
+                Requirements(barBlockSize / 2), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ResourceKind::Linear));
+            if (allocations.back().memoryTypeIndex != BAR_TYPE) {
+                break;
+            }
+        }
+        CHECK(allocations.size() > 1);
+        CHECK(allocations.back().memoryTypeIndex == HOST_TYPE);
+        CHECK(device.heapUsage[2] <= BAR_HEAP_SIZE);
+        CHECK(device.heapUsage[2] + barBlockSize / 2 > BAR_HEAP_SIZE);
+        for (size_t i = 0; i + 1 < allocations.size(); i++) {
+            CHECK(allocations[i].memoryTypeIndex == BAR_TYPE);
+            CHECK(!allocations[i].dedicated);
+        }
+
+        // Without another type allowed by the resource there is nowhere left to go
+        bool threw = false;
+        try {
+            allocator.Allocate(Requirements(barBlockSize / 2, 1u << BAR_TYPE), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 0, ResourceKind::Linear);
+        }
+        catch (const std::runtime_error&) {
+            threw = true;
+        }
+        CHECK(threw);
+
+        // Room freed in the heap is used again before falling back
+        allocator.Free(allocations.front());
+        Allocation again = allocator.Allocate(
+            Requirements(barBlockSize / 2), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ResourceKind::Linear);
+        CHECK(again.memoryTypeIndex == BAR_TYPE);
+        allocations.push_back(again);
+
+        FreeAll(allocator, allocations);
+    }
+
+    void TestSeparatePoolsWithGranularity() {
+        FakeDevice device{};
+        VulkanMemoryAllocator allocator{ device.properties, 4096, ATOM_SIZE, device.Functions() };
+
+        Allocation firstBuffer = allocator.Allocate(Requirements(1 * MB), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, ResourceKind::Linear);
+        Allocation image = allocator.Allocate(Requirements(1 * MB), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, ResourceKind::Optimal);
+        Allocation secondBuffer = allocator.Allocate(Requirements(1 * MB), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, ResourceKind::Linear);
+        Allocation secondImage = allocator.Allocate(Requirements(1 * MB), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, ResourceKind::Optimal);
+
+        CHECK(firstBuffer.memory != image.memory);
+        CHECK(firstBuffer.memory == secondBuffer.memory);
+        CHECK(image.memory == secondImage.memory);
+        CHECK(device.LiveCount(DEVICE_TYPE) == 2);
+        CHECK(allocator.GetStatistics().blockCount == 2);
+
+        for (Allocation* allocation : { &firstBuffer, &image, &secondBuffer, &secondImage }) {
+            allocator.Free(*allocation);
+        }
+        // Each pool keeps its own empty block
+        CHECK(device.LiveCount(DEVICE_TYPE) == 2);
+    }
+
+    void TestSharedPoolWithoutGranularity() {
+        FakeDevice device{};
+        VulkanMemoryAllocator allocator{ device.properties, 1, ATOM_SIZE, device.Functions() };
+
+        Allocation buffer = allocator.Allocate(Requirements(1 * MB), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, ResourceKind::Linear);
+        Allocation image = allocator.Allocate(Requirements(1 * MB), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, ResourceKind::Optimal);
+        CHECK(buffer.memory == image.memory);
+        CHECK(device.LiveCount(DEVICE_TYPE) == 1);
+
+        allocator.Free(buffer);
+        allocator.Free(image);
+    }
+
+    void TestDedicatedThreshold() {
+        FakeDevice device{};
+        VulkanMemoryAllocator allocator{ device.properties, 1, ATOM_SIZE, device.Functions() };
+
+        // Half a block still shares a block, anything above gets its own memory of exactly its size
+        VkDeviceSize deviceBlockSize = DEVICE_HEAP_SIZE / 8;
+        Allocation shared = allocator.Allocate(Requirements(deviceBlockSize / 2), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, ResourceKind::Linear);
+        CHECK(!shared.dedicated);
+        CHECK(device.live[shared.memory].size == deviceBlockSize);
+
+        Allocation dedicated = allocator.Allocate(
+            Requirements(deviceBlockSize / 2 + 1), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, ResourceKind::Linear);
+        CHECK(dedicated.dedicated);
+        CHECK(dedicated.offset == 0);
+        CHECK(device.live[dedicated.memory].size == deviceBlockSize / 2 + 1);
+        CHECK(allocator.GetStatistics().dedicatedCount == 1);
+
+        // Large heaps use DEFAULT_BLOCK_SIZE, and host visible sizes are rounded to the atom size before the check
+        VkDeviceSize hostBlockSize = VulkanMemoryAllocator::DEFAULT_BLOCK_SIZE;
+        Allocation hostShared = allocator.Allocate(
+            Requirements(hostBlockSize / 2 - ATOM_SIZE + 1), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 0, ResourceKind::Linear);
+        CHECK(hostShared.memoryTypeIndex == HOST_TYPE);
+        CHECK(!hostShared.dedicated);
+        CHECK(hostShared.size == hostBlockSize / 2);
+        CHECK(hostShared.offset % ATOM_SIZE == 0);
+
+        Allocation hostDedicated = allocator.Allocate(
+            Requirements(hostBlockSize / 2 + 1), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 0, ResourceKind::Linear);
+        CHECK(hostDedicated.dedicated);
+        CHECK(hostDedicated.size == hostBlockSize / 2 + ATOM_SIZE);
+
+        // Dedicated memory is released on Free, the shared block is kept
+        VkDeviceMemory dedicatedMemory = dedicated.memory;
+        allocator.Free(dedicated);
+        CHECK(dedicated.memory == VK_NULL_HANDLE);
+        CHECK(device.live.count(dedicatedMemory) == 0);
+        allocator.Free(hostDedicated);
+        allocator.Free(shared);
+        allocator.Free(hostShared);
+        CHECK(device.LiveCount(DEVICE_TYPE) == 1);
+        CHECK(device.LiveCount(HOST_TYPE) == 1);
+    }
+
+    void TestOneEmptyBlockPerPool() {
+        FakeDevice device{};
+        VulkanMemoryAllocator allocator{ device.properties, 1, ATOM_SIZE, device.Functions() };
+        VkDeviceSize deviceBlockSize = DEVICE_HEAP_SIZE / 8;
+
+        std::vector<Allocation> allocations{};
+        for (int i = 0; i < 6; i++) {
+            allocations.push_back(allocator.Allocate(
+                Requirements(deviceBlockSize / 2), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, ResourceKind::Linear));
+        }
+        uint32_t blockCount = device.LiveCount(DEVICE_TYPE);
+        CHECK(blockCount >= 3);
+        CHECK(allocator.GetStatistics().allocationCount == 6);
+
+        FreeAll(allocator, allocations);
+        CHECK(device.LiveCount(DEVICE_TYPE) == 1);
+        VulkanMemoryAllocator::Statistics statistics = allocator.GetStatistics();
+        CHECK(statistics.blockCount == 1);
+        CHECK(statistics.allocationCount == 0);
+        CHECK(statistics.usedBytes == 0);
+        CHECK(statistics.freeBytes == deviceBlockSize);
+
+        // The kept block is reused without another vkAllocateMemory
+        uint32_t allocateCount = device.allocateCount;
+        Allocation reused = allocator.Allocate(Requirements(1 * MB), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, ResourceKind::Linear);
+        CHECK(device.allocateCount == allocateCount);
+        allocator.Free(reused);
+        CHECK(device.LiveCount(DEVICE_TYPE) == 1);
+    }
+
+    void TestMapOffsets() {
+        FakeDevice device{};
+        VulkanMemoryAllocator allocator{ device.properties, 1, ATOM_SIZE, device.Functions() };
+
+        Allocation first = allocator.Allocate(Requirements(100), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 0, ResourceKind::Linear);
+        Allocation second = allocator.Allocate(Requirements(100), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 0, ResourceKind::Linear);
+        CHECK(first.memory == second.memory);
+        CHECK(first.size == ATOM_SIZE);
+        CHECK(second.offset % ATOM_SIZE == 0);
+
+        void* firstData = nullptr;
+        void* secondData = nullptr;
+        CHECK(allocator.Map(first, &firstData) == VK_SUCCESS);
+        CHECK(allocator.Map(second, &secondData) == VK_SUCCESS);
+        CHECK(firstData == FakeDevice::MappedBase(first.memory) + first.offset);
+        CHECK(secondData == FakeDevice::MappedBase(second.memory) + second.offset);
+        allocator.Unmap(first);
+        allocator.Unmap(second);
+
+        allocator.Free(first);
+        allocator.Free(second);
+    }
+
+    void TestDestructorReleasesEverything() {
+        FakeDevice device{};
+        {
+            VulkanMemoryAllocator allocator{ device.properties, 4096, ATOM_SIZE, device.Functions() };
+            Allocation buffer = allocator.Allocate(Requirements(1 * MB), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, ResourceKind::Linear);
+            Allocation image = allocator.Allocate(Requirements(1 * MB), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, ResourceKind::Optimal);
+            allocator.Free(buffer);
+            allocator.Free(image);
+            CHECK(!device.live.empty());
+        }
+        CHECK(device.live.empty());
+    }
+}
+
+int main() {
+    TestMemoryTypeSelection();
+    TestFallbackWhenHeapIsFull();
+    TestSeparatePoolsWithGranularity();
+    TestSharedPoolWithoutGranularity();
+    TestDedicatedThreshold();
+    TestOneEmptyBlockPerPool();
+    TestMapOffsets();
+    TestDestructorReleasesEverything();
+    return lvetest::FinishTest("vulkanMemoryAllocatorTest");
+}